@@ -43,6 +43,9 @@ workspace "c-ish"
 	filter "platforms:x64"
 		architecture "x86_64"
 
+	filter "system:linux"
+		links { "pthread" }
+
 project "base"
 	kind "StaticLib"
 	language "C++"
@@ -60,3 +63,8 @@ project "test"
 	files { "src/test/**.h", "src/test/**.cpp" }
 	links { "base", "compiler" }
 
+project "bench"
+	kind "ConsoleApp"
+	language "C++"
+	files { "src/bench/**.h", "src/bench/**.cpp" }
+	links { "base", "compiler" }
@@ -0,0 +1,364 @@
+#pragma once
+
+#include "base.h"
+#include "memory.h"
+
+// Growable array of `T`
+//
+// Allocates through `ator` (or the thread's default allocator if null). The
+// buffer grows by doubling: it's first extended in place using `mem::try_extend()`
+// which succeeds if it's the latest allocation of a `linear_allocator`,
+// otherwise the elements are relocated to a new buffer with `relocate_n()`,
+// which is a single `memmove()` for trivially relocatable types.
+//
+// `small_array<T, N>` derives from this and stores up to `N` elements inline,
+// it can be passed as `array<T>&` to code that doesn't care about the storage.
+template <typename T>
+struct array
+{
+	typedef T value_type;
+	typedef T *iterator;
+	typedef const T *const_iterator;
+
+	T *data;
+	uint32_t count;
+	uint32_t capacity;
+	uint32_t small_capacity;
+	mem::allocator *ator;
+
+	array()
+		: data(nullptr)
+		, count(0)
+		, capacity(0)
+		, small_capacity(0)
+		, ator(nullptr)
+	{
+	}
+
+	explicit array(mem::allocator *ator)
+		: data(nullptr)
+		, count(0)
+		, capacity(0)
+		, small_capacity(0)
+		, ator(ator)
+	{
+	}
+
+	array(const array &rhs)
+		: data(nullptr)
+		, count(0)
+		, capacity(0)
+		, small_capacity(0)
+		, ator(rhs.ator)
+	{
+		copy_from(rhs);
+	}
+
+	array(array &&rhs)
+		: data(nullptr)
+		, count(0)
+		, capacity(0)
+		, small_capacity(0)
+		, ator(rhs.ator)
+	{
+		move_from(rhs);
+	}
+
+	~array()
+	{
+		destroy_n(data, count);
+		free_buffer();
+	}
+
+	array &operator=(const array &rhs)
+	{
+		if (this != &rhs) {
+			clear();
+			copy_from(rhs);
+		}
+		return *this;
+	}
+
+	array &operator=(array &&rhs)
+	{
+		if (this != &rhs) {
+			clear();
+			move_from(rhs);
+		}
+		return *this;
+	}
+
+	// -- Fundamental operations
+
+	static void destroy_n(T *ptr, uint32_t num)
+	{
+		if (!std::is_trivially_destructible<T>::value) {
+			for (uint32_t i = 0; i < num; i++)
+				ptr[i].~T();
+		}
+	}
+
+	// Inline storage of `small_array`, directly after the `array` members
+	T *small_data() const
+	{
+		return (T*)((char*)this + align_up((uint64_t)sizeof(array), (uint64_t)alignof(T)));
+	}
+
+	bool is_small() const
+	{
+		return small_capacity > 0 && data == small_data();
+	}
+
+	void free_buffer()
+	{
+		if (data && !is_small())
+			mem::free(data);
+		data = small_capacity ? small_data() : nullptr;
+		capacity = small_capacity;
+	}
+
+	void grow(uint32_t min_capacity)
+	{
+		uint32_t new_capacity = capacity ? capacity * 2 : 4;
+		if (new_capacity < min_capacity)
+			new_capacity = min_capacity;
+
+		if (data && !is_small() && mem::try_extend(data, sizeof(T) * new_capacity)) {
+			capacity = new_capacity;
+			return;
+		}
+
+		T *new_data = (T*)mem::alloc_using(ator, sizeof(T) * new_capacity, alignof(T));
+		p_assert(new_data != nullptr);
+		relocate_n(new_data, data, count);
+		if (data && !is_small())
+			mem::free(data);
+		data = new_data;
+		capacity = new_capacity;
+	}
+
+	// Copy the elements of `rhs` to this array which must be empty
+	void copy_from(const array &rhs)
+	{
+		if (rhs.count > capacity)
+			grow(rhs.count);
+		if (p_trivially_copyable(T)) {
+			memcpy((void*)data, (const void*)rhs.data, sizeof(T) * rhs.count);
+		} else {
+			for (uint32_t i = 0; i < rhs.count; i++)
+				new (&data[i]) T(rhs.data[i]);
+		}
+		count = rhs.count;
+	}
+
+	// Take the elements of `rhs` to this array which must be empty, steals
+	// the buffer unless `rhs` is using its inline storage
+	void move_from(array &rhs)
+	{
+		if (rhs.is_small() || (rhs.count <= small_capacity && is_small())) {
+			if (rhs.count > capacity)
+				grow(rhs.count);
+			relocate_n(data, rhs.data, rhs.count);
+			count = rhs.count;
+			rhs.count = 0;
+		} else {
+			free_buffer();
+			data = rhs.data;
+			count = rhs.count;
+			capacity = rhs.capacity;
+			rhs.data = nullptr;
+			rhs.count = 0;
+			rhs.free_buffer();
+		}
+	}
+
+	void reserve(uint32_t size)
+	{
+		if (size > capacity)
+			grow(size);
+	}
+
+	void push(const T &t)
+	{
+		if (count == capacity) {
+			// `t` may point into the array
+			T copy(t);
+			grow(count + 1);
+			new (&data[count]) T(std::move(copy));
+		} else {
+			new (&data[count]) T(t);
+		}
+		count++;
+	}
+
+	void push(T &&t)
+	{
+		if (count == capacity) {
+			T copy(std::move(t));
+			grow(count + 1);
+			new (&data[count]) T(std::move(copy));
+		} else {
+			new (&data[count]) T(std::move(t));
+		}
+		count++;
+	}
+
+	template <typename... Args>
+	T &emplace(Args&&... args)
+	{
+		T *t;
+		if (count == capacity) {
+			// `args` may refer into the array
+			T copy(std::forward<Args>(args)...);
+			grow(count + 1);
+			t = new (&data[count]) T(std::move(copy));
+		} else {
+			t = new (&data[count]) T(std::forward<Args>(args)...);
+		}
+		count++;
+		return *t;
+	}
+
+	// Append `num` elements copied from `src`, which must not point into the array
+	void push_n(const T *src, uint32_t num)
+	{
+		if (count + num > capacity)
+			grow(count + num);
+		if (p_trivially_copyable(T)) {
+			memcpy((void*)(data + count), (const void*)src, sizeof(T) * num);
+		} else {
+			for (uint32_t i = 0; i < num; i++)
+				new (&data[count + i]) T(src[i]);
+		}
+		count += num;
+	}
+
+	void pop()
+	{
+		p_assert(count > 0);
+		count--;
+		data[count].~T();
+	}
+
+	// Resize to `size` elements, new elements are value-initialized
+	void resize(uint32_t size)
+	{
+		if (size > count) {
+			if (size > capacity)
+				grow(size);
+			for (uint32_t i = count; i < size; i++)
+				new (&data[i]) T();
+		} else {
+			destroy_n(data + size, count - size);
+		}
+		count = size;
+	}
+
+	// Erase an element keeping the order, returns the following element
+	iterator erase(const_iterator it)
+	{
+		uint32_t const index = (uint32_t)(it - data);
+		p_assert(index < count);
+		data[index].~T();
+		relocate_n(data + index, data + index + 1, count - index - 1);
+		count--;
+		return data + index;
+	}
+
+	void clear()
+	{
+		destroy_n(data, count);
+		count = 0;
+	}
+
+	T &operator[](uint32_t index) { p_assert(index < count); return data[index]; }
+	const T &operator[](uint32_t index) const { p_assert(index < count); return data[index]; }
+
+	T &back() { p_assert(count > 0); return data[count - 1]; }
+	const T &back() const { p_assert(count > 0); return data[count - 1]; }
+
+	const_iterator begin() const { return data; }
+	iterator begin() { return data; }
+	const_iterator end() const { return data + count; }
+	iterator end() { return data + count; }
+
+protected:
+
+	// Used by `small_array` to point to its inline storage
+	array(uint32_t small_capacity, mem::allocator *ator)
+		: data(small_data())
+		, count(0)
+		, capacity(small_capacity)
+		, small_capacity(small_capacity)
+		, ator(ator)
+	{
+	}
+};
+
+// Array that stores up to `N` elements without allocating
+template <typename T, uint32_t N>
+struct small_array : array<T>
+{
+	static_assert(N > 0, "Use array<T> for no inline storage");
+
+	alignas(T) char storage[sizeof(T) * N];
+
+	small_array()
+		: array<T>(N, nullptr)
+	{
+		p_assert((T*)storage == this->small_data());
+	}
+
+	explicit small_array(mem::allocator *ator)
+		: array<T>(N, ator)
+	{
+	}
+
+	small_array(const small_array &rhs)
+		: array<T>(N, rhs.ator)
+	{
+		this->copy_from(rhs);
+	}
+
+	small_array(const array<T> &rhs)
+		: array<T>(N, rhs.ator)
+	{
+		this->copy_from(rhs);
+	}
+
+	small_array(small_array &&rhs)
+		: array<T>(N, rhs.ator)
+	{
+		this->move_from(rhs);
+	}
+
+	small_array(array<T> &&rhs)
+		: array<T>(N, rhs.ator)
+	{
+		this->move_from(rhs);
+	}
+
+	small_array &operator=(const array<T> &rhs)
+	{
+		array<T>::operator=(rhs);
+		return *this;
+	}
+
+	small_array &operator=(const small_array &rhs)
+	{
+		array<T>::operator=(rhs);
+		return *this;
+	}
+
+	small_array &operator=(array<T> &&rhs)
+	{
+		array<T>::operator=(std::move(rhs));
+		return *this;
+	}
+
+	small_array &operator=(small_array &&rhs)
+	{
+		array<T>::operator=(std::move(rhs));
+		return *this;
+	}
+};
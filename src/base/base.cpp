@@ -0,0 +1,8 @@
+#include "base.h"
+#include <chrono>
+
+uint64_t get_time_ns()
+{
+	auto now = std::chrono::steady_clock::now().time_since_epoch();
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
@@ -2,6 +2,10 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <string.h>
+#include <new>
+#include <utility>
+#include <type_traits>
 
 #define p_msvc 1
 #define p_gcc 2
@@ -15,6 +19,12 @@
 	#define p_compiler p_generic
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define p_sse2 1
+#else
+	#define p_sse2 0
+#endif
+
 #define p_debug 1
 #define p_release 2
 #define p_final 3
@@ -33,6 +43,19 @@
 #define p_trivially_copyable(x) (std::is_trivially_copyable<x>::value)
 #endif
 
+// Types that can be moved to a new address with memcpy() instead of move
+// constructing and destroying the original. Trivially copyable types are always
+// relocatable, other types can opt in by specializing this template:
+//
+//     template <> struct is_trivially_relocatable<handle> : std::true_type { };
+//
+template <typename T>
+struct is_trivially_relocatable : std::integral_constant<bool, p_trivially_copyable(T)>
+{
+};
+
+#define p_trivially_relocatable(x) (is_trivially_relocatable<x>::value)
+
 #if p_build != p_final
 	#if p_compiler == p_msvc
 		#define p_assert(x) do { if (!(x)) __debugbreak(); } while (0)
@@ -65,3 +88,49 @@ constexpr inline uint32_t at_most(uint32_t a, uint32_t b) { return a < b ? a : b
 constexpr inline uint64_t at_least(uint64_t a, uint64_t b) { return a > b ? a : b; }
 constexpr inline uint64_t at_most(uint64_t a, uint64_t b) { return a < b ? a : b; }
 
+
+// Move `count` objects from `src` to uninitialized memory at `dst`, the objects
+// at `src` are left destroyed. The ranges may overlap if `dst` is before `src`.
+template <typename T>
+inline void relocate_n(T *dst, T *src, size_t count)
+{
+	if (p_trivially_relocatable(T)) {
+		// Empty ranges may be null
+		if (count > 0)
+			memmove((void*)dst, (const void*)src, count * sizeof(T));
+	} else {
+		for (size_t i = 0; i < count; i++) {
+			new (&dst[i]) T(std::move(src[i]));
+			src[i].~T();
+		}
+	}
+}
+
+// Like `relocate_n()` but for overlapping ranges where `dst` is after `src`
+template <typename T>
+inline void relocate_n_backward(T *dst, T *src, size_t count)
+{
+	if (p_trivially_relocatable(T)) {
+		if (count > 0)
+			memmove((void*)dst, (const void*)src, count * sizeof(T));
+	} else {
+		for (size_t i = count; i > 0; i--) {
+			new (&dst[i - 1]) T(std::move(src[i - 1]));
+			src[i - 1].~T();
+		}
+	}
+}
+
+template <typename T>
+inline void relocate(T *dst, T *src)
+{
+	if (p_trivially_relocatable(T)) {
+		memcpy((void*)dst, (const void*)src, sizeof(T));
+	} else {
+		new (dst) T(std::move(*src));
+		src->~T();
+	}
+}
+
+// Monotonic time in nanoseconds
+uint64_t get_time_ns();
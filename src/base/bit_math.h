@@ -3,6 +3,7 @@
 #include "base.h"
 
 static uint32_t find_msb(uint32_t val);
+static uint32_t find_lsb(uint32_t val);
 
 #if p_compiler == p_msvc
 
@@ -16,6 +17,14 @@ static inline uint32_t find_msb(uint32_t val)
 	return (uint32_t)index;
 }
 
+static inline uint32_t find_lsb(uint32_t val)
+{
+	p_assert(val != 0);
+	unsigned long index;
+	_BitScanForward(&index, (unsigned long)val);
+	return (uint32_t)index;
+}
+
 #elif p_compiler == p_gcc
 
 static inline uint32_t find_msb(uint32_t val)
@@ -23,5 +32,10 @@ static inline uint32_t find_msb(uint32_t val)
 	return 31 - __builtin_clz(val);
 }
 
+static inline uint32_t find_lsb(uint32_t val)
+{
+	return __builtin_ctz(val);
+}
+
 #endif
 
@@ -0,0 +1,520 @@
+#pragma once
+
+#include "hash_map.h"
+#include "flat_map.h"
+
+// Target size of a `btree_map` node in bytes: four cache lines, the nodes are
+// allocated aligned to the cache line so a node search touches exactly these.
+constexpr usize btree_node_size = 256;
+
+// Sorted map stored as a B+ tree with cache-line aligned nodes
+//
+// The entries live in the leaves which are linked in order so iteration is
+// a walk over dense arrays. Inner nodes only store the separator keys and
+// child pointers, for 32-bit keys an inner node fits 20 keys and is searched
+// using `flat_key_search`. Iterators point to `{ key, val }` entries like
+// `hash_map` and are invalidated by inserting or erasing.
+//
+// Erasing doesn't merge or free underfull nodes: the tree only shrinks on
+// `clear()`. Prefer `flat_map` if the map is built once and then queried.
+template <typename Key, typename Val>
+struct btree_map
+{
+	typedef map_key_val<Key, Val> key_val;
+	typedef map_key_val<const Key, Val> value_type;
+
+	static const uint32_t leaf_header_size = 2 * sizeof(void*) + 8;
+	static const uint32_t inner_header_size = sizeof(void*) + 8;
+	static const uint32_t leaf_capacity = (btree_node_size - leaf_header_size) / sizeof(key_val) >= 4
+		? (btree_node_size - leaf_header_size) / sizeof(key_val) : 4;
+	static const uint32_t inner_capacity = (btree_node_size - inner_header_size) / (sizeof(Key) + sizeof(void*)) >= 4
+		? (btree_node_size - inner_header_size) / (sizeof(Key) + sizeof(void*)) : 4;
+
+	struct node
+	{
+		uint32_t count;
+		bool leaf;
+	};
+
+	struct leaf_node : node
+	{
+		leaf_node *prev;
+		leaf_node *next;
+		alignas(key_val) char entry_data[sizeof(key_val) * leaf_capacity];
+
+		key_val *entries() { return (key_val*)entry_data; }
+	};
+
+	struct inner_node : node
+	{
+		alignas(Key) char key_data[sizeof(Key) * inner_capacity];
+		node *children[inner_capacity + 1];
+
+		Key *keys() { return (Key*)key_data; }
+	};
+
+	template <typename It, typename Ref>
+	struct iterator_base
+	{
+		leaf_node *leaf;
+		uint32_t index;
+
+		iterator_base()
+		{
+		}
+
+		iterator_base(leaf_node *leaf, uint32_t index)
+			: leaf(leaf)
+			, index(index)
+		{
+		}
+
+		bool operator!=(const It &rhs) const
+		{
+			return leaf != rhs.leaf || index != rhs.index;
+		}
+
+		bool operator==(const It &rhs) const
+		{
+			return leaf == rhs.leaf && index == rhs.index;
+		}
+
+		// Skip to the next non-empty leaf, the last leaf stays as the end
+		void skip_empty()
+		{
+			while (leaf && index == leaf->count && leaf->next) {
+				leaf = leaf->next;
+				index = 0;
+			}
+		}
+
+		It& operator++()
+		{
+			index++;
+			skip_empty();
+			return static_cast<It&>(*this);
+		}
+
+		It& operator--()
+		{
+			while (index == 0) {
+				leaf = leaf->prev;
+				index = leaf->count;
+			}
+			index--;
+			return static_cast<It&>(*this);
+		}
+
+		It operator++(int)
+		{
+			It copy = static_cast<It&>(*this);
+			++*this;
+			return copy;
+		}
+
+		It operator--(int)
+		{
+			It copy = static_cast<It&>(*this);
+			--*this;
+			return copy;
+		}
+
+		Ref &operator*() const { return (Ref&)leaf->entries()[index]; }
+		Ref *operator->() const { return (Ref*)&leaf->entries()[index]; }
+	};
+
+	struct iterator : iterator_base<iterator, value_type>
+	{
+		iterator() : iterator_base<iterator, value_type>() { }
+		iterator(leaf_node *l, uint32_t i) : iterator_base<iterator, value_type>(l, i) { }
+	};
+
+	struct const_iterator : iterator_base<const_iterator, const value_type>
+	{
+		const_iterator() : iterator_base<const_iterator, const value_type>() { }
+		const_iterator(iterator it) : iterator_base<const_iterator, const value_type>(it.leaf, it.index) { }
+		const_iterator(leaf_node *l, uint32_t i) : iterator_base<const_iterator, const value_type>(l, i) { }
+	};
+
+	node *root;
+	leaf_node *first;
+	leaf_node *last;
+	usize count;
+	mem::allocator *ator;
+
+	btree_map()
+		: root(nullptr)
+		, first(nullptr)
+		, last(nullptr)
+		, count(0)
+		, ator(nullptr)
+	{
+	}
+
+	btree_map(const btree_map &rhs)
+		: root(nullptr)
+		, first(nullptr)
+		, last(nullptr)
+		, count(0)
+		, ator(rhs.ator)
+	{
+		for (const value_type &kv : rhs) {
+			insert(kv.key, kv.val);
+		}
+	}
+
+	btree_map(btree_map &&rhs)
+		: root(rhs.root)
+		, first(rhs.first)
+		, last(rhs.last)
+		, count(rhs.count)
+		, ator(rhs.ator)
+	{
+		rhs.root = nullptr;
+		rhs.first = nullptr;
+		rhs.last = nullptr;
+		rhs.count = 0;
+		rhs.ator = nullptr;
+	}
+
+	~btree_map()
+	{
+		if (root)
+			free_node(root);
+	}
+
+	btree_map &operator=(const btree_map &rhs)
+	{
+		this->~btree_map();
+		new (this) btree_map(rhs);
+		return *this;
+	}
+
+	btree_map &operator=(btree_map &&rhs)
+	{
+		this->~btree_map();
+		new (this) btree_map(std::move(rhs));
+		return *this;
+	}
+
+	// -- Fundamental operations
+
+	leaf_node *alloc_leaf()
+	{
+		leaf_node *leaf = (leaf_node*)mem::alloc_using(ator, sizeof(leaf_node), 64);
+		p_assert(leaf != nullptr);
+		leaf->count = 0;
+		leaf->leaf = true;
+		leaf->prev = nullptr;
+		leaf->next = nullptr;
+		return leaf;
+	}
+
+	inner_node *alloc_inner()
+	{
+		inner_node *inner = (inner_node*)mem::alloc_using(ator, sizeof(inner_node), 64);
+		p_assert(inner != nullptr);
+		inner->count = 0;
+		inner->leaf = false;
+		return inner;
+	}
+
+	void free_node(node *n)
+	{
+		if (n->leaf) {
+			key_val *entries = ((leaf_node*)n)->entries();
+			if (!std::is_trivially_destructible<key_val>::value) {
+				for (uint32_t i = 0; i < n->count; i++)
+					entries[i].~key_val();
+			}
+		} else {
+			inner_node *inner = (inner_node*)n;
+			Key *keys = inner->keys();
+			for (uint32_t i = 0; i <= n->count; i++)
+				free_node(inner->children[i]);
+			if (!std::is_trivially_destructible<Key>::value) {
+				for (uint32_t i = 0; i < n->count; i++)
+					keys[i].~Key();
+			}
+		}
+		mem::free(n);
+	}
+
+	static bool is_full(const node *n)
+	{
+		if (n->leaf)
+			return n->count == leaf_capacity;
+		else
+			return n->count == inner_capacity;
+	}
+
+	// Index of the child of `inner` that contains `key`
+	static uint32_t child_index(inner_node *inner, const Key &key)
+	{
+		const Key *keys = inner->keys();
+		uint32_t const n = inner->count;
+		uint32_t ix = (uint32_t)flat_key_search<Key>::count_less(keys, n, key);
+		if (ix < n && !(key < keys[ix]))
+			ix++;
+		return ix;
+	}
+
+	// Index of the first entry in `leaf` with a key not less than `key`
+	static uint32_t leaf_lower_bound(leaf_node *leaf, const Key &key)
+	{
+		const key_val *entries = leaf->entries();
+		uint32_t lo = 0, hi = leaf->count;
+		while (lo < hi) {
+			uint32_t const mid = (lo + hi) / 2;
+			if (entries[mid].key < key) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+		return lo;
+	}
+
+	// Split the full child `ix` of `parent` in half and insert the separator
+	// key to `parent` which must not be full
+	void split_child(inner_node *parent, uint32_t ix)
+	{
+		node *child = parent->children[ix];
+		node *right;
+
+		if (child->leaf) {
+			leaf_node *l = (leaf_node*)child;
+			leaf_node *r = alloc_leaf();
+			uint32_t const mid = l->count / 2;
+			relocate_n(r->entries(), l->entries() + mid, l->count - mid);
+			r->count = l->count - mid;
+			l->count = mid;
+
+			r->prev = l;
+			r->next = l->next;
+			if (l->next) {
+				l->next->prev = r;
+			} else {
+				last = r;
+			}
+			l->next = r;
+
+			relocate_n_backward(parent->keys() + ix + 1, parent->keys() + ix, parent->count - ix);
+			new (&parent->keys()[ix]) Key(r->entries()[0].key);
+			right = r;
+		} else {
+			inner_node *l = (inner_node*)child;
+			inner_node *r = alloc_inner();
+			uint32_t const mid = l->count / 2;
+			Key *sep = l->keys() + mid;
+			relocate_n(r->keys(), l->keys() + mid + 1, l->count - mid - 1);
+			memcpy(r->children, l->children + mid + 1, (l->count - mid) * sizeof(node*));
+			r->count = l->count - mid - 1;
+			l->count = mid;
+
+			relocate_n_backward(parent->keys() + ix + 1, parent->keys() + ix, parent->count - ix);
+			relocate_n(parent->keys() + ix, sep, 1);
+			right = r;
+		}
+
+		memmove(parent->children + ix + 2, parent->children + ix + 1, (parent->count - ix) * sizeof(node*));
+		parent->children[ix + 1] = right;
+		parent->count++;
+	}
+
+	// Find the position of `key` and returns `false` if it exists, otherwise
+	// makes room for a new entry at `leaf_index` that must be constructed.
+	bool insert_slot(const Key &key, leaf_node *&leaf, uint32_t &leaf_index)
+	{
+		if (!root) {
+			first = last = alloc_leaf();
+			root = first;
+		}
+
+		// Look for an existing entry before splitting anything: `key` may
+		// refer to an entry of this tree (eg. `m[it->key]`) which a split
+		// would relocate. If the key is missing it can't alias an entry.
+		node *n = root;
+		bool needs_split = is_full(n);
+		while (!n->leaf) {
+			inner_node *inner = (inner_node*)n;
+			n = inner->children[child_index(inner, key)];
+			needs_split |= is_full(n);
+		}
+
+		leaf = (leaf_node*)n;
+		leaf_index = leaf_lower_bound(leaf, key);
+		key_val *entries = leaf->entries();
+		if (leaf_index < leaf->count && !(key < entries[leaf_index].key))
+			return false;
+
+		if (needs_split) {
+			// Split full nodes on the way down so there is always room for a separator
+			if (is_full(root)) {
+				inner_node *new_root = alloc_inner();
+				new_root->children[0] = root;
+				root = new_root;
+				split_child(new_root, 0);
+			}
+
+			n = root;
+			while (!n->leaf) {
+				inner_node *inner = (inner_node*)n;
+				uint32_t ix = child_index(inner, key);
+				if (is_full(inner->children[ix])) {
+					split_child(inner, ix);
+					if (!(key < inner->keys()[ix]))
+						ix++;
+				}
+				n = inner->children[ix];
+			}
+
+			leaf = (leaf_node*)n;
+			leaf_index = leaf_lower_bound(leaf, key);
+			entries = leaf->entries();
+		}
+
+		relocate_n_backward(entries + leaf_index + 1, entries + leaf_index, leaf->count - leaf_index);
+		leaf->count++;
+		count++;
+		return true;
+	}
+
+	// Position of the first entry with a key not less than `key`
+	iterator lower_bound_impl(const Key &key) const
+	{
+		if (!root) return iterator(nullptr, 0);
+
+		node *n = root;
+		while (!n->leaf) {
+			inner_node *inner = (inner_node*)n;
+			n = inner->children[child_index(inner, key)];
+		}
+
+		leaf_node *leaf = (leaf_node*)n;
+		iterator it(leaf, leaf_lower_bound(leaf, key));
+		it.skip_empty();
+		return it;
+	}
+
+	iterator find_impl(const Key &key) const
+	{
+		iterator it = lower_bound_impl(key);
+		if (it.leaf && it.index < it.leaf->count && !(key < it->key))
+			return it;
+		return end_impl();
+	}
+
+	iterator begin_impl() const
+	{
+		iterator it(first, 0);
+		it.skip_empty();
+		return it;
+	}
+
+	iterator end_impl() const
+	{
+		return iterator(last, last ? last->count : 0);
+	}
+
+	void erase_entry(leaf_node *leaf, uint32_t index)
+	{
+		key_val *entries = leaf->entries();
+		entries[index].~key_val();
+		relocate_n(entries + index, entries + index + 1, leaf->count - index - 1);
+		leaf->count--;
+		count--;
+	}
+
+	template <typename K, typename... Args>
+	bool emplace_impl(K &&key, Args&&... args)
+	{
+		leaf_node *leaf;
+		uint32_t ix;
+		bool inserted = insert_slot(key, leaf, ix);
+		key_val &kv = leaf->entries()[ix];
+		if (inserted) {
+			new (&kv.key) Key(std::forward<typename std::remove_reference<K>::type>(key));
+		} else {
+			kv.val.~Val();
+		}
+		new (&kv.val) Val(std::forward<Args>(args)...);
+		return inserted;
+	}
+
+	template <typename K, typename... Args>
+	bool try_emplace_impl(key_val *&kv, K &&key, Args&&... args)
+	{
+		leaf_node *leaf;
+		uint32_t ix;
+		bool inserted = insert_slot(key, leaf, ix);
+		kv = &leaf->entries()[ix];
+		if (inserted) {
+			new (&kv->key) Key(std::forward<typename std::remove_reference<K>::type>(key));
+			new (&kv->val) Val(std::forward<Args>(args)...);
+		}
+		return inserted;
+	}
+
+	bool insert(const Key  &key, const Val  &val) { return emplace_impl(          key,            val); }
+	bool insert(const Key  &key,       Val &&val) { return emplace_impl(          key,  std::move(val)); }
+	bool insert(      Key &&key, const Val  &val) { return emplace_impl(std::move(key),           val); }
+	bool insert(      Key &&key,       Val &&val) { return emplace_impl(std::move(key), std::move(val)); }
+
+	template <typename... Args> bool emplace(const Key  &key, Args&&... args) { return emplace_impl(          key,  std::forward<Args>(args)...); }
+	template <typename... Args> bool emplace(      Key &&key, Args&&... args) { return emplace_impl(std::move(key), std::forward<Args>(args)...); }
+
+	template <typename... Args> bool try_emplace(const Key  &key, Args&&... args) { key_val *kv; return try_emplace_impl(kv,           key,  std::forward<Args>(args)...); }
+	template <typename... Args> bool try_emplace(      Key &&key, Args&&... args) { key_val *kv; return try_emplace_impl(kv, std::move(key), std::forward<Args>(args)...); }
+
+	Val& operator[](const Key  &key) { key_val *kv; try_emplace_impl(kv,           key);  return kv->val; }
+	Val& operator[](      Key &&key) { key_val *kv; try_emplace_impl(kv, std::move(key)); return kv->val; }
+
+	iterator erase(const_iterator it)
+	{
+		erase_entry(it.leaf, it.index);
+		iterator next(it.leaf, it.index);
+		next.skip_empty();
+		return next;
+	}
+
+	bool erase(const Key &key)
+	{
+		iterator it = find_impl(key);
+		if (it == end_impl()) return false;
+		erase_entry(it.leaf, it.index);
+		return true;
+	}
+
+	iterator find(const Key &key) { return find_impl(key); }
+	const_iterator find(const Key &key) const { return find_impl(key); }
+
+	// First entry with a key not less than `key`
+	iterator lower_bound(const Key &key) { return lower_bound_impl(key); }
+	const_iterator lower_bound(const Key &key) const { return lower_bound_impl(key); }
+
+	// First entry with a key greater than `key`
+	iterator upper_bound(const Key &key)
+	{
+		iterator it = lower_bound_impl(key);
+		if (it != end_impl() && !(key < it->key))
+			++it;
+		return it;
+	}
+	const_iterator upper_bound(const Key &key) const { return const_cast<btree_map*>(this)->upper_bound(key); }
+
+	void clear()
+	{
+		if (root)
+			free_node(root);
+		root = nullptr;
+		first = nullptr;
+		last = nullptr;
+		count = 0;
+	}
+
+	const_iterator begin() const { return begin_impl(); }
+	iterator begin() { return begin_impl(); }
+	const_iterator end() const { return end_impl(); }
+	iterator end() { return end_impl(); }
+};
@@ -0,0 +1,41 @@
+#include "concurrent_hash_map.h"
+
+retire_allocator::retire_allocator()
+	: parent(mem::get_default_allocator_for_this_thread())
+	, list(nullptr)
+{
+}
+
+retire_allocator::~retire_allocator()
+{
+	reclaim();
+}
+
+void *retire_allocator::allocator_allocate(uint32_t thread, size_t size, size_t alignment)
+{
+	return parent->allocator_allocate(thread, size, alignment);
+}
+
+void retire_allocator::allocator_free(uint32_t thread, void *pointer, size_t size, size_t alignment)
+{
+	retired *r = (retired*)mem::alloc_using(parent, sizeof(retired), alignof(retired));
+	p_assert(r != nullptr);
+	r->next = list;
+	r->pointer = pointer;
+	r->size = size;
+	r->alignment = alignment;
+	list = r;
+}
+
+void retire_allocator::reclaim()
+{
+	uint32_t thread = mem::get_thread_index();
+	retired *r = list;
+	while (r) {
+		retired *next = r->next;
+		parent->allocator_free(thread, r->pointer, r->size, r->alignment);
+		mem::free(r);
+		r = next;
+	}
+	list = nullptr;
+}
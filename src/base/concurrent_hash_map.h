@@ -0,0 +1,507 @@
+#pragma once
+
+#include "hash_map.h"
+#include <atomic>
+#include <mutex>
+
+// Allocator that defers frees until `reclaim()`
+//
+// Optimistic readers of a `concurrent_hash_map` may still be probing a table
+// that a writer has just rehashed away, so the old buffers are kept alive
+// until the owner knows no readers are running.
+struct retire_allocator : mem::allocator
+{
+	struct retired
+	{
+		retired *next;
+		void *pointer;
+		size_t size;
+		size_t alignment;
+	};
+
+	retire_allocator(const retire_allocator&) = delete;
+	retire_allocator &operator=(const retire_allocator&) = delete;
+
+	retire_allocator();
+	~retire_allocator();
+
+	virtual void *allocator_allocate(uint32_t thread, size_t size, size_t alignment) override;
+	virtual void allocator_free(uint32_t thread, void *pointer, size_t size, size_t alignment) override;
+
+	// Free all the retired allocations
+	void reclaim();
+
+	mem::allocator *parent;
+	retired *list;
+};
+
+// Hash map that can be shared between threads
+//
+// The keys are split to `1 << shard_bits` shards by the top bits of the hash,
+// each shard being a Robin Hood table like `hash_container` guarded by its own
+// mutex and a sequence number. Writers lock the shard and make the sequence
+// odd for the duration of the write. Readers don't lock: they probe the table,
+// copy the candidate entry out and only trust it if the sequence didn't change
+// meanwhile, which is why the keys and values must be trivially copyable.
+// After a few failed attempts a reader falls back to locking.
+//
+// Every word a reader may load concurrently with a writer is a `std::atomic`
+// accessed with relaxed loads and stores, entries are copied word by word.
+// Tables are never resized in place: a larger one is built privately and
+// published with a release store. Replaced tables are retired instead of
+// freed as readers may be probing them, call `reclaim()` when no other
+// threads are using the map to release them. The retired memory is bounded
+// by the size of the current tables.
+template <typename Key, typename Val, typename Hash = default_hash<Key>>
+struct concurrent_hash_map
+{
+	typedef map_key_val<Key, Val> key_val;
+
+	static_assert(p_trivially_copyable(Key) && p_trivially_copyable(Val),
+		"concurrent_hash_map requires trivially copyable keys and values");
+
+	static const uint32_t max_optimistic_reads = 16;
+
+	// Entries are stored as the largest words their alignment allows
+	typedef typename std::conditional<alignof(key_val) % 8 == 0, uint64_t,
+		typename std::conditional<alignof(key_val) % 4 == 0, uint32_t,
+		typename std::conditional<alignof(key_val) % 2 == 0, uint16_t,
+		uint8_t>::type>::type>::type word;
+
+	static const uint32_t entry_words = sizeof(key_val) / sizeof(word);
+
+	static_assert(sizeof(std::atomic<word>) == sizeof(word) && sizeof(std::atomic<uhash>) == sizeof(uhash),
+		"Atomic words must have the same layout as plain ones");
+
+	// Header of a table allocation followed by `capacity` hashes and entries,
+	// `capacity` doesn't change after the table is published and `count` is
+	// only accessed by writers
+	struct table
+	{
+		usize capacity;
+		usize count;
+
+		std::atomic<uhash> *hashes() const
+		{
+			return (std::atomic<uhash>*)(this + 1);
+		}
+
+		std::atomic<word> *entry(usize index) const
+		{
+			uint64_t const offset = align_up((uint64_t)sizeof(uhash) * capacity, (uint64_t)alignof(word));
+			return (std::atomic<word>*)((char*)(this + 1) + offset) + (size_t)index * entry_words;
+		}
+	};
+
+	struct alignas(64) shard
+	{
+		std::atomic<uint32_t> sequence;
+		std::atomic<table*> current;
+		std::mutex mutex;
+		retire_allocator retirer;
+
+		shard()
+			: sequence(0)
+			, current(nullptr)
+		{
+		}
+
+		~shard()
+		{
+			mem::free(current.load(std::memory_order_relaxed));
+		}
+	};
+
+	// Locks a shard and marks it as being written to for the lifetime of the scope
+	struct write_scope
+	{
+		shard &s;
+
+		explicit write_scope(shard &s)
+			: s(s)
+		{
+			s.mutex.lock();
+			s.sequence.store(s.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+		}
+
+		~write_scope()
+		{
+			s.sequence.store(s.sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+			s.mutex.unlock();
+		}
+	};
+
+	shard *shards;
+	uint32_t shard_bits;
+	uhash seed;
+
+	concurrent_hash_map(const concurrent_hash_map&) = delete;
+	concurrent_hash_map &operator=(const concurrent_hash_map&) = delete;
+
+	explicit concurrent_hash_map(uint32_t shard_bits = 6)
+		: shard_bits(shard_bits)
+		, seed(hash_random_seed())
+	{
+		p_assert(shard_bits < 16);
+		uint32_t const num = 1U << shard_bits;
+		shards = (shard*)mem::alloc(sizeof(shard) * num, alignof(shard));
+		p_assert(shards != nullptr);
+		for (uint32_t i = 0; i < num; i++) {
+			new (&shards[i]) shard();
+		}
+	}
+
+	~concurrent_hash_map()
+	{
+		uint32_t const num = 1U << shard_bits;
+		for (uint32_t i = 0; i < num; i++) {
+			shards[i].~shard();
+		}
+		mem::free(shards);
+	}
+
+	// -- Fundamental operations
+
+	uhash hash_of(const Key &key) const
+	{
+		uhash const hash = (uhash)hash_with_seed<Hash>(key, seed);
+		return hash ? hash : 1;
+	}
+
+	shard &shard_of(uhash hash) const
+	{
+		return shards[shard_bits ? hash >> (32 - shard_bits) : 0];
+	}
+
+	static bool validate(const shard &s, uint32_t sequence)
+	{
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return s.sequence.load(std::memory_order_relaxed) == sequence;
+	}
+
+	// Copy the entry at `src` to the `sizeof(key_val)` bytes at `dst`
+	static void load_entry(void *dst, const std::atomic<word> *src)
+	{
+		word words[entry_words];
+		for (uint32_t i = 0; i < entry_words; i++)
+			words[i] = src[i].load(std::memory_order_relaxed);
+		memcpy(dst, words, sizeof(key_val));
+	}
+
+	static void store_entry(std::atomic<word> *dst, const void *src)
+	{
+		word words[entry_words];
+		memcpy(words, src, sizeof(key_val));
+		for (uint32_t i = 0; i < entry_words; i++)
+			dst[i].store(words[i], std::memory_order_relaxed);
+	}
+
+	// Probe without locking, returns 1 if found, 0 if not found and -1 if
+	// a writer interfered and the read must be retried.
+	static int find_optimistic(const shard &s, const Key &key, uhash hash, uint32_t sequence, Val &val)
+	{
+		// Acquire so that the contents of a newly published table are visible
+		const table *const t = s.current.load(std::memory_order_acquire);
+		if (!t)
+			return validate(s, sequence) ? 0 : -1;
+
+		const std::atomic<uhash> *const hb = t->hashes();
+		usize const mask = t->capacity - 1;
+		usize index = hash & mask;
+
+		for (usize scan = 0; scan <= mask; scan++) {
+			uhash const hval = hb[index].load(std::memory_order_relaxed);
+
+			if (hval == 0 || ((index - hval) & mask) < scan)
+				return validate(s, sequence) ? 0 : -1;
+
+			if (hval == hash) {
+				// Compare a validated copy so torn entries are never looked at
+				alignas(key_val) char copy[sizeof(key_val)];
+				load_entry(copy, t->entry(index));
+				if (!validate(s, sequence))
+					return -1;
+
+				const key_val &kv = *(const key_val*)copy;
+				if (kv.key == key) {
+					val = kv.val;
+					return 1;
+				}
+			}
+
+			index = (index + 1) & mask;
+		}
+
+		return -1;
+	}
+
+	// Slot of `key` in `t` or `t->capacity` if it's not found, must hold the lock
+	static usize find_slot_locked(const table *t, const Key &key, uhash hash)
+	{
+		if (!t)
+			return 0;
+
+		const std::atomic<uhash> *const hb = t->hashes();
+		usize const mask = t->capacity - 1;
+		usize index = hash & mask;
+
+		for (usize scan = 0; scan <= mask; scan++) {
+			uhash const hval = hb[index].load(std::memory_order_relaxed);
+
+			if (hval == 0 || ((index - hval) & mask) < scan)
+				break;
+
+			if (hval == hash) {
+				alignas(key_val) char copy[sizeof(key_val)];
+				load_entry(copy, t->entry(index));
+				if (((const key_val*)copy)->key == key)
+					return index;
+			}
+
+			index = (index + 1) & mask;
+		}
+
+		return t->capacity;
+	}
+
+	// Place an entry known to be missing from `t` Robin Hood style, returns its slot
+	static usize insert_new(table *t, const key_val &kv, uhash hash)
+	{
+		std::atomic<uhash> *const hb = t->hashes();
+		usize const mask = t->capacity - 1;
+		usize index = hash & mask;
+		usize scan = 0;
+
+		alignas(key_val) char carry[sizeof(key_val)];
+		memcpy(carry, (const void*)&kv, sizeof(key_val));
+		uhash carry_hash = hash;
+		usize slot = t->capacity;
+
+		for (;;) {
+			uhash const hval = hb[index].load(std::memory_order_relaxed);
+
+			if (hval == 0) {
+				store_entry(t->entry(index), carry);
+				hb[index].store(carry_hash, std::memory_order_relaxed);
+				if (slot == t->capacity)
+					slot = index;
+				break;
+			}
+
+			// Current slot has shorter scan distance -> swap
+			usize const sref = (index - hval) & mask;
+			if (sref < scan) {
+				alignas(key_val) char displaced[sizeof(key_val)];
+				load_entry(displaced, t->entry(index));
+				store_entry(t->entry(index), carry);
+				hb[index].store(carry_hash, std::memory_order_relaxed);
+				memcpy(carry, displaced, sizeof(key_val));
+				carry_hash = hval;
+				scan = sref;
+				if (slot == t->capacity)
+					slot = index;
+			}
+
+			index = (index + 1) & mask;
+			scan++;
+		}
+
+		t->count++;
+		return slot;
+	}
+
+	// Build a table twice the size of the current one and publish it
+	table *grow(shard &s)
+	{
+		table *const old = s.current.load(std::memory_order_relaxed);
+		usize const capacity = old ? old->capacity * 2 : 8;
+
+		uint64_t const hashes_size = align_up((uint64_t)sizeof(uhash) * capacity, (uint64_t)alignof(word));
+		size_t const size = sizeof(table) + (size_t)hashes_size + sizeof(key_val) * capacity;
+		table *t = (table*)mem::alloc_using(&s.retirer, size, 64);
+		p_assert(t != nullptr);
+		t->capacity = capacity;
+		t->count = 0;
+
+		std::atomic<uhash> *const hb = t->hashes();
+		for (usize i = 0; i < capacity; i++)
+			new (&hb[i]) std::atomic<uhash>(0);
+
+		if (old) {
+			const std::atomic<uhash> *const old_hb = old->hashes();
+			for (usize i = 0; i < old->capacity; i++) {
+				uhash const hval = old_hb[i].load(std::memory_order_relaxed);
+				if (hval != 0) {
+					alignas(key_val) char copy[sizeof(key_val)];
+					load_entry(copy, old->entry(i));
+					insert_new(t, *(const key_val*)copy, hval);
+				}
+			}
+		}
+
+		s.current.store(t, std::memory_order_release);
+		mem::free(old);
+		return t;
+	}
+
+	// Returns the slot of `key` and whether it was inserted, a new entry is
+	// initialized with `val`. Must be called in a `write_scope`.
+	bool insert_locked(shard &s, const Key &key, uhash hash, const Val &val, usize &slot)
+	{
+		table *t = s.current.load(std::memory_order_relaxed);
+		slot = find_slot_locked(t, key, hash);
+		if (t && slot < t->capacity)
+			return false;
+
+		if (!t || t->count * 2 >= t->capacity)
+			t = grow(s);
+
+		key_val const kv = { key, val };
+		slot = insert_new(t, kv, hash);
+		return true;
+	}
+
+	bool find_with_hash(const Key &key, uhash hash, Val &val) const
+	{
+		shard &s = shard_of(hash);
+
+		for (uint32_t attempt = 0; attempt < max_optimistic_reads; attempt++) {
+			uint32_t const sequence = s.sequence.load(std::memory_order_acquire);
+			if (sequence & 1)
+				continue;
+
+			int const result = find_optimistic(s, key, hash, sequence, val);
+			if (result >= 0)
+				return result != 0;
+		}
+
+		std::lock_guard<std::mutex> lock(s.mutex);
+		const table *const t = s.current.load(std::memory_order_relaxed);
+		usize const slot = find_slot_locked(t, key, hash);
+		if (!t || slot == t->capacity)
+			return false;
+
+		alignas(key_val) char copy[sizeof(key_val)];
+		load_entry(copy, t->entry(slot));
+		val = ((const key_val*)copy)->val;
+		return true;
+	}
+
+	// Insert `key` if it doesn't exist, returns the stored value either way
+	bool insert_with_hash(const Key &key, uhash hash, const Val &val, Val *stored)
+	{
+		shard &s = shard_of(hash);
+		write_scope scope(s);
+
+		usize slot;
+		bool inserted = insert_locked(s, key, hash, val, slot);
+		if (stored) {
+			alignas(key_val) char copy[sizeof(key_val)];
+			load_entry(copy, s.current.load(std::memory_order_relaxed)->entry(slot));
+			*stored = ((const key_val*)copy)->val;
+		}
+		return inserted;
+	}
+
+	// Copy the value of `key` to `val`, returns false if it's not found
+	bool find(const Key &key, Val &val) const
+	{
+		return find_with_hash(key, hash_of(key), val);
+	}
+
+	bool contains(const Key &key) const
+	{
+		Val val;
+		return find(key, val);
+	}
+
+	// Insert if the key doesn't exist, if multiple threads insert the same
+	// key the first one wins. Returns true if the value was inserted.
+	bool insert(const Key &key, const Val &val)
+	{
+		return insert_with_hash(key, hash_of(key), val, nullptr);
+	}
+
+	// Returns the existing value of `key` or inserts `val`, the common case
+	// of the key existing doesn't lock.
+	Val find_or_insert(const Key &key, const Val &val)
+	{
+		uhash const hash = hash_of(key);
+		Val result;
+		if (!find_with_hash(key, hash, result))
+			insert_with_hash(key, hash, val, &result);
+		return result;
+	}
+
+	bool insert_or_assign(const Key &key, const Val &val)
+	{
+		uhash const hash = hash_of(key);
+		shard &s = shard_of(hash);
+		write_scope scope(s);
+
+		usize slot;
+		bool inserted = insert_locked(s, key, hash, val, slot);
+		if (!inserted) {
+			key_val const kv = { key, val };
+			store_entry(s.current.load(std::memory_order_relaxed)->entry(slot), &kv);
+		}
+		return inserted;
+	}
+
+	bool erase(const Key &key)
+	{
+		uhash const hash = hash_of(key);
+		shard &s = shard_of(hash);
+		write_scope scope(s);
+
+		table *const t = s.current.load(std::memory_order_relaxed);
+		usize slot = find_slot_locked(t, key, hash);
+		if (!t || slot == t->capacity)
+			return false;
+
+		// Shift the following run back by one slot, it ends before an empty
+		// or zero scan distance cell
+		std::atomic<uhash> *const hb = t->hashes();
+		usize const mask = t->capacity - 1;
+		for (;;) {
+			usize const next = (slot + 1) & mask;
+			uhash const hval = hb[next].load(std::memory_order_relaxed);
+			if (hval == 0 || ((next - hval) & mask) == 0)
+				break;
+
+			alignas(key_val) char copy[sizeof(key_val)];
+			load_entry(copy, t->entry(next));
+			store_entry(t->entry(slot), copy);
+			hb[slot].store(hval, std::memory_order_relaxed);
+			slot = next;
+		}
+
+		hb[slot].store(0, std::memory_order_relaxed);
+		t->count--;
+		return true;
+	}
+
+	// Total number of entries, only exact if there are no concurrent writers
+	usize size() const
+	{
+		usize num = 0;
+		uint32_t const count = 1U << shard_bits;
+		for (uint32_t i = 0; i < count; i++) {
+			std::lock_guard<std::mutex> lock(shards[i].mutex);
+			const table *const t = shards[i].current.load(std::memory_order_relaxed);
+			if (t)
+				num += t->count;
+		}
+		return num;
+	}
+
+	// Free the tables retired by growing, no other thread may access the map
+	void reclaim()
+	{
+		uint32_t const count = 1U << shard_bits;
+		for (uint32_t i = 0; i < count; i++) {
+			shards[i].retirer.reclaim();
+		}
+	}
+};
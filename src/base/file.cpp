@@ -0,0 +1,118 @@
+#include "file.h"
+#include <stdio.h>
+
+#if defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#include <Windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+mapped_file::mapped_file()
+	: data(nullptr)
+	, size(0)
+	, handle(nullptr)
+{
+}
+
+mapped_file::~mapped_file()
+{
+	close();
+}
+
+#if defined(_WIN32)
+
+bool mapped_file::open(const char *path)
+{
+	close();
+
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (mapping == NULL)
+		return false;
+
+	void *ptr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (ptr == NULL) {
+		CloseHandle(mapping);
+		return false;
+	}
+
+	data = ptr;
+	size = (size_t)file_size.QuadPart;
+	handle = mapping;
+	return true;
+}
+
+void mapped_file::close()
+{
+	if (data) {
+		UnmapViewOfFile(data);
+		CloseHandle((HANDLE)handle);
+	}
+
+	data = nullptr;
+	size = 0;
+	handle = nullptr;
+}
+
+#else
+
+bool mapped_file::open(const char *path)
+{
+	close();
+
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0) {
+		::close(fd);
+		return false;
+	}
+
+	void *ptr = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (ptr == MAP_FAILED)
+		return false;
+
+	data = ptr;
+	size = (size_t)st.st_size;
+	return true;
+}
+
+void mapped_file::close()
+{
+	if (data)
+		munmap((void*)data, size);
+
+	data = nullptr;
+	size = 0;
+	handle = nullptr;
+}
+
+#endif
+
+bool write_file(const char *path, const void *data, size_t size)
+{
+	FILE *f = fopen(path, "wb");
+	if (!f)
+		return false;
+
+	bool ok = fwrite(data, 1, size, f) == size;
+	ok = fclose(f) == 0 && ok;
+	return ok;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "base.h"
+
+// Read-only memory mapping of a whole file
+struct mapped_file
+{
+	mapped_file(const mapped_file&) = delete;
+	mapped_file &operator=(const mapped_file&) = delete;
+
+	mapped_file();
+	~mapped_file();
+
+	// Map the file at `path`, returns false on error. Any previous mapping is closed.
+	bool open(const char *path);
+
+	void close();
+
+	const void *data;
+	size_t size;
+
+	// Platform specific handle, unused on POSIX
+	void *handle;
+};
+
+// Write `size` bytes from `data` to a new file at `path`, returns false on error
+bool write_file(const char *path, const void *data, size_t size);
@@ -0,0 +1,442 @@
+#pragma once
+
+#include "base.h"
+#include "memory.h"
+
+#if p_sse2
+	#include <emmintrin.h>
+#endif
+
+// Counts the keys less than `key` in a short sorted run, used for the last
+// steps of the `flat_map` search. Specialized for 32-bit integers to compare
+// four keys per SSE2 instruction.
+template <typename Key>
+struct flat_key_search
+{
+	static size_t count_less(const Key *keys, size_t num, const Key &key)
+	{
+		size_t n = 0;
+		while (n < num && keys[n] < key)
+			n++;
+		return n;
+	}
+};
+
+#if p_sse2
+
+// `bias` maps unsigned to signed order for `_mm_cmplt_epi32`
+template <uint32_t Bias>
+inline size_t flat_count_less_i32(const uint32_t *keys, size_t num, uint32_t key)
+{
+	__m128i const bias = _mm_set1_epi32((int)Bias);
+	__m128i const k = _mm_xor_si128(_mm_set1_epi32((int)key), bias);
+	__m128i acc = _mm_setzero_si128();
+
+	size_t i = 0;
+	for (; i + 4 <= num; i += 4) {
+		__m128i v = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(keys + i)), bias);
+		acc = _mm_sub_epi32(acc, _mm_cmplt_epi32(v, k));
+	}
+
+	acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+	acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+	size_t n = (size_t)_mm_cvtsi128_si32(acc);
+
+	for (; i < num; i++) {
+		if ((int32_t)(keys[i] ^ Bias) < (int32_t)(key ^ Bias))
+			n++;
+	}
+	return n;
+}
+
+template <>
+struct flat_key_search<uint32_t>
+{
+	static size_t count_less(const uint32_t *keys, size_t num, uint32_t key)
+	{
+		return flat_count_less_i32<0x80000000U>(keys, num, key);
+	}
+};
+
+template <>
+struct flat_key_search<int32_t>
+{
+	static size_t count_less(const int32_t *keys, size_t num, int32_t key)
+	{
+		return flat_count_less_i32<0>((const uint32_t*)keys, num, (uint32_t)key);
+	}
+};
+
+#endif
+
+// Number of keys scanned linearly at the end of a `flat_map` lookup
+constexpr size_t flat_map_linear_size = 16;
+
+// Sorted map stored as two contiguous arrays of keys and values
+//
+// Lookups binary search the dense key array down to a run of
+// `flat_map_linear_size` keys that is scanned linearly (with SIMD where
+// possible). Inserting and erasing shift the following entries, so prefer
+// this for tables that are built once or appended to in order and then
+// queried, eg. source location ranges. Appending a key larger than the
+// current last key is O(1).
+//
+// As the keys and values are stored apart the iterators return a pair of
+// references `{ key, val }` by value: `it->key` and `it->val` work as with
+// `hash_map` but range-for loops need `auto` or `const auto&` instead of `auto&`.
+template <typename Key, typename Val>
+struct flat_map
+{
+	struct reference
+	{
+		const Key &key;
+		Val &val;
+
+		reference(const Key &key, Val &val) : key(key), val(val) { }
+	};
+
+	struct const_reference
+	{
+		const Key &key;
+		const Val &val;
+
+		const_reference(const Key &key, const Val &val) : key(key), val(val) { }
+	};
+
+	template <typename Ref>
+	struct arrow_proxy
+	{
+		Ref ref;
+
+		Ref *operator->() { return &ref; }
+	};
+
+	template <typename It, typename Map, typename Ref>
+	struct iterator_base
+	{
+		Map *map;
+		size_t index;
+
+		iterator_base()
+		{
+		}
+
+		iterator_base(Map *map, size_t index)
+			: map(map)
+			, index(index)
+		{
+		}
+
+		bool operator!=(const It &rhs) const
+		{
+			p_assert(map == rhs.map);
+			return index != rhs.index;
+		}
+
+		bool operator==(const It &rhs) const
+		{
+			p_assert(map == rhs.map);
+			return index == rhs.index;
+		}
+
+		It& operator++()
+		{
+			index++;
+			return static_cast<It&>(*this);
+		}
+
+		It& operator--()
+		{
+			index--;
+			return static_cast<It&>(*this);
+		}
+
+		It operator++(int)
+		{
+			It copy = static_cast<It&>(*this);
+			index++;
+			return copy;
+		}
+
+		It operator--(int)
+		{
+			It copy = static_cast<It&>(*this);
+			index--;
+			return copy;
+		}
+
+		Ref operator*() const { return Ref(map->keys[index], map->vals[index]); }
+		arrow_proxy<Ref> operator->() const { return arrow_proxy<Ref>{ Ref(map->keys[index], map->vals[index]) }; }
+	};
+
+	struct iterator : iterator_base<iterator, flat_map, reference>
+	{
+		iterator() : iterator_base<iterator, flat_map, reference>() { }
+		iterator(flat_map *m, size_t i) : iterator_base<iterator, flat_map, reference>(m, i) { }
+	};
+
+	struct const_iterator : iterator_base<const_iterator, const flat_map, const_reference>
+	{
+		const_iterator() : iterator_base<const_iterator, const flat_map, const_reference>() { }
+		const_iterator(iterator it) : iterator_base<const_iterator, const flat_map, const_reference>(it.map, it.index) { }
+		const_iterator(const flat_map *m, size_t i) : iterator_base<const_iterator, const flat_map, const_reference>(m, i) { }
+	};
+
+	Key *keys;
+	Val *vals;
+	size_t count;
+	size_t capacity;
+	mem::allocator *ator;
+
+	flat_map()
+		: keys(nullptr)
+		, vals(nullptr)
+		, count(0)
+		, capacity(0)
+		, ator(nullptr)
+	{
+	}
+
+	flat_map(const flat_map &rhs)
+		: keys(nullptr)
+		, vals(nullptr)
+		, count(0)
+		, capacity(0)
+		, ator(nullptr)
+	{
+		if (rhs.count) {
+			grow(rhs.count);
+			copy_n(keys, rhs.keys, rhs.count);
+			copy_n(vals, rhs.vals, rhs.count);
+			count = rhs.count;
+		}
+	}
+
+	flat_map(flat_map &&rhs)
+		: keys(rhs.keys)
+		, vals(rhs.vals)
+		, count(rhs.count)
+		, capacity(rhs.capacity)
+		, ator(rhs.ator)
+	{
+		rhs.keys = nullptr;
+		rhs.vals = nullptr;
+		rhs.count = 0;
+		rhs.capacity = 0;
+		rhs.ator = nullptr;
+	}
+
+	~flat_map()
+	{
+		destroy_n(keys, count);
+		destroy_n(vals, count);
+		if (keys)
+			mem::free(keys);
+	}
+
+	flat_map &operator=(const flat_map &rhs)
+	{
+		this->~flat_map();
+		new (this) flat_map(rhs);
+		return *this;
+	}
+
+	flat_map &operator=(flat_map &&rhs)
+	{
+		this->~flat_map();
+		new (this) flat_map(std::move(rhs));
+		return *this;
+	}
+
+	// -- Fundamental operations
+
+	template <typename T>
+	static void copy_n(T *dst, const T *src, size_t num)
+	{
+		if (p_trivially_copyable(T)) {
+			memcpy((void*)dst, (const void*)src, num * sizeof(T));
+		} else {
+			for (size_t i = 0; i < num; i++)
+				new (&dst[i]) T(src[i]);
+		}
+	}
+
+	template <typename T>
+	static void destroy_n(T *ptr, size_t num)
+	{
+		if (!std::is_trivially_destructible<T>::value) {
+			for (size_t i = 0; i < num; i++)
+				ptr[i].~T();
+		}
+	}
+
+	// Keys and values share one allocation, values after the keys
+	void grow(size_t new_capacity)
+	{
+		size_t const vals_offset = (size_t)align_up((uint64_t)(sizeof(Key) * new_capacity), (uint64_t)alignof(Val));
+		size_t const alloc_size = vals_offset + sizeof(Val) * new_capacity;
+		char *alloc = (char*)mem::alloc_using(ator, alloc_size, (size_t)at_least((uint64_t)alignof(Key), (uint64_t)alignof(Val)));
+		p_assert(alloc != nullptr);
+
+		Key *new_keys = (Key*)alloc;
+		Val *new_vals = (Val*)(alloc + vals_offset);
+		relocate_n(new_keys, keys, count);
+		relocate_n(new_vals, vals, count);
+
+		if (keys)
+			mem::free(keys);
+		keys = new_keys;
+		vals = new_vals;
+		capacity = new_capacity;
+	}
+
+	// Index of the first key not less than `key`
+	size_t lower_bound_index(const Key &key) const
+	{
+		const Key *base = keys;
+		size_t num = count;
+
+		while (num > flat_map_linear_size) {
+			size_t const half = num / 2;
+			if (base[half] < key) {
+				base += half + 1;
+				num -= half + 1;
+			} else {
+				num = half;
+			}
+		}
+
+		return (size_t)(base - keys) + flat_key_search<Key>::count_less(base, num, key);
+	}
+
+	// Index of the first key greater than `key`
+	size_t upper_bound_index(const Key &key) const
+	{
+		size_t index = lower_bound_index(key);
+		if (index < count && !(key < keys[index]))
+			index++;
+		return index;
+	}
+
+	size_t find_index(const Key &key) const
+	{
+		size_t const index = lower_bound_index(key);
+		if (index < count && !(key < keys[index]))
+			return index;
+		return count;
+	}
+
+	// Find the position of `key` and returns `false` if it exists, otherwise
+	// makes room for a new entry at `index` that must be constructed.
+	bool insert_slot(const Key &key, size_t &index)
+	{
+		// Appending in order skips the search
+		if (count == 0 || keys[count - 1] < key) {
+			index = count;
+		} else {
+			index = lower_bound_index(key);
+			if (!(key < keys[index]))
+				return false;
+		}
+
+		if (count == capacity)
+			grow(capacity ? capacity * 2 : 8);
+
+		relocate_n_backward(keys + index + 1, keys + index, count - index);
+		relocate_n_backward(vals + index + 1, vals + index, count - index);
+		count++;
+		return true;
+	}
+
+	template <typename K, typename... Args>
+	bool emplace_impl(K &&key, Args&&... args)
+	{
+		size_t index;
+		bool inserted = insert_slot(key, index);
+		if (inserted) {
+			new (&keys[index]) Key(std::forward<typename std::remove_reference<K>::type>(key));
+		} else {
+			vals[index].~Val();
+		}
+		new (&vals[index]) Val(std::forward<Args>(args)...);
+		return inserted;
+	}
+
+	template <typename K, typename... Args>
+	bool try_emplace_impl(size_t &index, K &&key, Args&&... args)
+	{
+		bool inserted = insert_slot(key, index);
+		if (inserted) {
+			new (&keys[index]) Key(std::forward<typename std::remove_reference<K>::type>(key));
+			new (&vals[index]) Val(std::forward<Args>(args)...);
+		}
+		return inserted;
+	}
+
+	void erase_index(size_t index)
+	{
+		keys[index].~Key();
+		vals[index].~Val();
+		relocate_n(keys + index, keys + index + 1, count - index - 1);
+		relocate_n(vals + index, vals + index + 1, count - index - 1);
+		count--;
+	}
+
+	bool insert(const Key  &key, const Val  &val) { return emplace_impl(          key,            val); }
+	bool insert(const Key  &key,       Val &&val) { return emplace_impl(          key,  std::move(val)); }
+	bool insert(      Key &&key, const Val  &val) { return emplace_impl(std::move(key),           val); }
+	bool insert(      Key &&key,       Val &&val) { return emplace_impl(std::move(key), std::move(val)); }
+
+	template <typename... Args> bool emplace(const Key  &key, Args&&... args) { return emplace_impl(          key,  std::forward<Args>(args)...); }
+	template <typename... Args> bool emplace(      Key &&key, Args&&... args) { return emplace_impl(std::move(key), std::forward<Args>(args)...); }
+
+	template <typename... Args> bool try_emplace(const Key  &key, Args&&... args) { size_t ix; return try_emplace_impl(ix,           key,  std::forward<Args>(args)...); }
+	template <typename... Args> bool try_emplace(      Key &&key, Args&&... args) { size_t ix; return try_emplace_impl(ix, std::move(key), std::forward<Args>(args)...); }
+
+	Val& operator[](const Key  &key) { size_t ix; try_emplace_impl(ix,           key);  return vals[ix]; }
+	Val& operator[](      Key &&key) { size_t ix; try_emplace_impl(ix, std::move(key)); return vals[ix]; }
+
+	iterator erase(const_iterator it)
+	{
+		size_t const index = it.index;
+		erase_index(index);
+		return iterator(this, index);
+	}
+
+	bool erase(const Key &key)
+	{
+		size_t const index = find_index(key);
+		if (index == count) return false;
+		erase_index(index);
+		return true;
+	}
+
+	iterator find(const Key &key) { return iterator(this, find_index(key)); }
+	const_iterator find(const Key &key) const { return const_iterator(this, find_index(key)); }
+
+	// First entry with a key not less than `key`
+	iterator lower_bound(const Key &key) { return iterator(this, lower_bound_index(key)); }
+	const_iterator lower_bound(const Key &key) const { return const_iterator(this, lower_bound_index(key)); }
+
+	// First entry with a key greater than `key`
+	iterator upper_bound(const Key &key) { return iterator(this, upper_bound_index(key)); }
+	const_iterator upper_bound(const Key &key) const { return const_iterator(this, upper_bound_index(key)); }
+
+	void reserve(size_t size)
+	{
+		if (size > capacity)
+			grow(size);
+	}
+
+	void clear()
+	{
+		destroy_n(keys, count);
+		destroy_n(vals, count);
+		count = 0;
+	}
+
+	const_iterator begin() const { return const_iterator(this, 0); }
+	iterator begin() { return iterator(this, 0); }
+	const_iterator end() const { return const_iterator(this, count); }
+	iterator end() { return iterator(this, count); }
+};
@@ -0,0 +1,181 @@
+#pragma once
+
+#include "hash_map.h"
+#include "file.h"
+
+// Flat image of a hash_map or hash_set with trivially copyable entries
+//
+// The image starts with a `hash_image_header` followed by the `kvbuf` and
+// `hbuf` arrays laid out exactly like in hash_container, so a read-only
+// `frozen_hash_map` can probe a memory mapped image directly without any
+// parsing or rehashing. All offsets are relative to the start of the image.
+//
+// The image uses the native byte order and sizes, and it must be read with
+// the same `Hash` that was used to build the original table. The table seed
+// is stored in the header so seeded hashes find the keys again.
+
+struct hash_image_header
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t key_val_size;
+	uint32_t key_val_align;
+	uint32_t count;
+	uint32_t capacity;
+	uint32_t seed;
+	uint32_t reserved;
+	uint64_t kvbuf_offset;
+	uint64_t hbuf_offset;
+	uint64_t size;
+};
+
+constexpr uint32_t hash_image_magic = 0x48534846; // "FHSH"
+constexpr uint32_t hash_image_version = 2;
+
+template <typename KeyVal>
+hash_image_header hash_image_layout(usize count, usize capacity, uhash seed)
+{
+	hash_image_header h;
+	h.magic = hash_image_magic;
+	h.version = hash_image_version;
+	h.key_val_size = (uint32_t)sizeof(KeyVal);
+	h.key_val_align = (uint32_t)alignof(KeyVal);
+	h.count = count;
+	h.capacity = capacity;
+	h.seed = seed;
+	h.reserved = 0;
+	h.kvbuf_offset = align_up((uint64_t)sizeof(hash_image_header), (uint64_t)at_least((uint64_t)alignof(KeyVal), 16));
+	h.hbuf_offset = h.kvbuf_offset + align_up((uint64_t)sizeof(KeyVal) * capacity, (uint64_t)alignof(usize));
+	h.size = h.hbuf_offset + (uint64_t)sizeof(uhash) * capacity;
+	return h;
+}
+
+template <typename KeyVal>
+size_t hash_image_size(const hash_container<KeyVal> &hc)
+{
+	return (size_t)hash_image_layout<KeyVal>(hc.count, hc.capacity, hc.seed).size;
+}
+
+// Write the image of `hc` to `dst`, which must have room for `hash_image_size(hc)`
+// bytes and be aligned to at least 16 bytes. Empty slots and padding are zeroed
+// so the same table always results in the same image.
+template <typename KeyVal>
+void write_hash_image(const hash_container<KeyVal> &hc, void *dst)
+{
+	static_assert(p_trivially_copyable(KeyVal), "Hash images require trivially copyable entries");
+
+	hash_image_header h = hash_image_layout<KeyVal>(hc.count, hc.capacity, hc.seed);
+	char *image = (char*)dst;
+	memset(image, 0, (size_t)h.size);
+	memcpy(image, &h, sizeof(h));
+
+	uhash *const hb = (uhash*)(image + h.hbuf_offset);
+	KeyVal *const kvb = (KeyVal*)(image + h.kvbuf_offset);
+	const KeyVal *const src_kvb = (const KeyVal*)hc.kvbuf;
+	usize const cap = hc.capacity;
+
+	if (cap > 0)
+		memcpy(hb, hc.hbuf, sizeof(uhash) * cap);
+
+	for (usize i = find_used_hash_slot(hb, 0, cap); i < cap; i = find_used_hash_slot(hb, i + 1, cap)) {
+		memcpy((void*)&kvb[i], (const void*)&src_kvb[i], sizeof(KeyVal));
+	}
+}
+
+// Write the image of `hc` to a file at `path`, returns false on error
+template <typename KeyVal>
+bool save_hash_image(const hash_container<KeyVal> &hc, const char *path)
+{
+	size_t size = hash_image_size(hc);
+	void *image = mem::alloc_using(hc.ator, size, 64);
+	if (!image)
+		return false;
+
+	write_hash_image(hc, image);
+	bool ok = write_file(path, image, size);
+	mem::free(image);
+	return ok;
+}
+
+template <typename KeyVal>
+struct frozen_hash_base
+{
+	frozen_hash_base()
+		: hbuf(nullptr)
+		, kvbuf(nullptr)
+		, count(0)
+		, capacity(0)
+		, seed(0)
+	{
+	}
+
+	const uhash *hbuf;
+	const KeyVal *kvbuf;
+	usize count;
+	usize capacity;
+	uhash seed;
+	mapped_file file;
+
+	// Use an image in memory without copying it, the memory must outlive the view.
+	// Returns false if the image is not valid for this table type.
+	bool load(const void *image, size_t size)
+	{
+		const hash_image_header *h = (const hash_image_header*)image;
+		if (size < sizeof(hash_image_header)) return false;
+		if (((uintptr_t)image & 15) != 0) return false;
+		if (h->magic != hash_image_magic || h->version != hash_image_version) return false;
+		if (h->key_val_size != sizeof(KeyVal) || h->key_val_align != alignof(KeyVal)) return false;
+		if ((h->capacity & (h->capacity - 1)) != 0) return false;
+		if (h->count > h->capacity || (uint64_t)h->count * 2 > h->capacity) return false;
+
+		hash_image_header layout = hash_image_layout<KeyVal>(h->count, h->capacity, h->seed);
+		if (h->kvbuf_offset != layout.kvbuf_offset || h->hbuf_offset != layout.hbuf_offset) return false;
+		if (h->size != layout.size || h->size > size) return false;
+
+		hbuf = (const uhash*)((const char*)image + h->hbuf_offset);
+		kvbuf = (const KeyVal*)((const char*)image + h->kvbuf_offset);
+		count = h->count;
+		capacity = h->capacity;
+		seed = h->seed;
+		return true;
+	}
+
+	// Map the image file at `path` for the lifetime of the view
+	bool open(const char *path)
+	{
+		if (!file.open(path))
+			return false;
+
+		if (!load(file.data, file.size)) {
+			file.close();
+			return false;
+		}
+
+		return true;
+	}
+};
+
+template <typename Key, typename Val, typename Hash = default_hash<Key>>
+struct frozen_hash_map : frozen_hash_base<map_key_val<Key, Val>>
+{
+	typedef frozen_hash_base<map_key_val<Key, Val>> base;
+
+	// Returns a pointer to the value of `key` or nullptr if it's not found
+	const Val *find(const Key &key) const
+	{
+		usize slot = find_hash_slot(base::hbuf, base::kvbuf, base::capacity, key, (uhash)hash_with_seed<Hash>(key, base::seed));
+		return slot < base::capacity ? &base::kvbuf[slot].val : nullptr;
+	}
+};
+
+template <typename Key, typename Hash = default_hash<Key>>
+struct frozen_hash_set : frozen_hash_base<set_key_val<Key>>
+{
+	typedef frozen_hash_base<set_key_val<Key>> base;
+
+	bool contains(const Key &key) const
+	{
+		usize slot = find_hash_slot(base::hbuf, base::kvbuf, base::capacity, key, (uhash)hash_with_seed<Hash>(key, base::seed));
+		return slot < base::capacity;
+	}
+};
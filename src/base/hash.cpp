@@ -0,0 +1,81 @@
+#include "hash.h"
+
+static inline uint64_t hash_read64(const uint8_t *p)
+{
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline uint64_t hash_read32(const uint8_t *p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+uint64_t hash_bytes64(const void *data, size_t size, uint64_t seed)
+{
+	const uint64_t s0 = 0xa0761d6478bd642fULL;
+	const uint64_t s1 = 0xe7037ed1a0b428dbULL;
+	const uint64_t s2 = 0x8ebc6af09c88c6e3ULL;
+
+	const uint8_t *p = (const uint8_t*)data;
+	uint64_t a, b;
+
+	seed ^= hash_mum(seed ^ s0, s1);
+
+	if (size <= 16) {
+		if (size >= 4) {
+			size_t mid = (size >> 3) << 2;
+			a = (hash_read32(p) << 32) | hash_read32(p + mid);
+			b = (hash_read32(p + size - 4) << 32) | hash_read32(p + size - 4 - mid);
+		} else if (size > 0) {
+			a = ((uint64_t)p[0] << 16) | ((uint64_t)p[size >> 1] << 8) | p[size - 1];
+			b = 0;
+		} else {
+			a = b = 0;
+		}
+	} else {
+		size_t left = size;
+
+		// Two independent lanes for long inputs
+		if (left > 32) {
+			uint64_t seed2 = seed;
+			do {
+				seed = hash_mum(hash_read64(p) ^ s1, hash_read64(p + 8) ^ seed);
+				seed2 = hash_mum(hash_read64(p + 16) ^ s2, hash_read64(p + 24) ^ seed2);
+				p += 32;
+				left -= 32;
+			} while (left > 32);
+			seed ^= seed2;
+		}
+
+		while (left > 16) {
+			seed = hash_mum(hash_read64(p) ^ s1, hash_read64(p + 8) ^ seed);
+			p += 16;
+			left -= 16;
+		}
+
+		// Last 16 bytes, may overlap with the already consumed ones
+		a = hash_read64(p + left - 16);
+		b = hash_read64(p + left - 8);
+	}
+
+	a ^= s1;
+	b ^= seed;
+	hash_mul128(a, b);
+	return hash_mum(a ^ s0 ^ (uint64_t)size, b ^ s1);
+}
+
+static thread_local uint64_t t_seed_state;
+
+uhash hash_random_seed()
+{
+	// Weyl sequence started from the clock and the address of the per-thread state,
+	// scrambled so consecutive seeds are unrelated
+	if (t_seed_state == 0)
+		t_seed_state = hash_int64(get_time_ns() ^ (uint64_t)(uintptr_t)&t_seed_state) | 1;
+	t_seed_state += 0x9e3779b97f4a7c15ULL;
+	return (uhash)hash_int64(t_seed_state);
+}
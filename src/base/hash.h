@@ -0,0 +1,170 @@
+#pragma once
+
+#include "base.h"
+
+#if p_compiler == p_msvc
+	#include <intrin.h>
+#endif
+
+typedef unsigned usize;
+typedef unsigned uhash;
+
+// Hash functions used by `default_hash`
+//
+// Integers are hashed with a bijective multiply-xorshift finalizer so every
+// input bit affects every output bit, including the low bits that are used
+// for the slot index. Byte strings are hashed with a wyhash-style function
+// that consumes 16 bytes per 64x64->128 bit multiply.
+
+inline uint32_t hash_int32(uint32_t x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352dU;
+	x ^= x >> 15;
+	x *= 0x846ca68bU;
+	x ^= x >> 16;
+	return x;
+}
+
+inline uint64_t hash_int64(uint64_t x)
+{
+	x ^= x >> 32;
+	x *= 0xd6e8feb86659fd93ULL;
+	x ^= x >> 32;
+	x *= 0xd6e8feb86659fd93ULL;
+	x ^= x >> 32;
+	return x;
+}
+
+// Full 128-bit product of `a` and `b`, returned as low and high halves in `a` and `b`
+inline void hash_mul128(uint64_t &a, uint64_t &b)
+{
+#if defined(__SIZEOF_INT128__)
+	unsigned __int128 r = (unsigned __int128)a * b;
+	a = (uint64_t)r;
+	b = (uint64_t)(r >> 64);
+#elif p_compiler == p_msvc && defined(_M_X64)
+	uint64_t hi;
+	a = _umul128(a, b, &hi);
+	b = hi;
+#else
+	uint64_t ha = a >> 32, hb = b >> 32, la = (uint32_t)a, lb = (uint32_t)b;
+	uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+	uint64_t t = rl + (rm0 << 32);
+	uint64_t c = t < rl;
+	uint64_t lo = t + (rm1 << 32);
+	c += lo < t;
+	a = lo;
+	b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+inline uint64_t hash_mum(uint64_t a, uint64_t b)
+{
+	hash_mul128(a, b);
+	return a ^ b;
+}
+
+uint64_t hash_bytes64(const void *data, size_t size, uint64_t seed = 0);
+
+inline uhash hash_bytes(const void *data, size_t size, uint64_t seed = 0)
+{
+	return (uhash)hash_bytes64(data, size, seed);
+}
+
+// Non-owning reference to a byte string, hashed and compared by content
+struct string_ref
+{
+	const char *data;
+	size_t length;
+
+	string_ref() : data(nullptr), length(0) { }
+	string_ref(const char *data, size_t length) : data(data), length(length) { }
+	explicit string_ref(const char *str) : data(str), length(strlen(str)) { }
+
+	bool operator==(const string_ref &rhs) const
+	{
+		return length == rhs.length && memcmp(data, rhs.data, length) == 0;
+	}
+
+	bool operator!=(const string_ref &rhs) const
+	{
+		return !(*this == rhs);
+	}
+};
+
+// Default hash functions for the hash containers, specialized for integers,
+// enums, pointers and `string_ref`
+//
+// These are seeded: the containers pass a random per-table seed so that
+// keys colliding in one table don't collide in another, see `is_seeded_hash`.
+// The hashes are 64-bit so tables with 64-bit hash words keep every bit,
+// tables with 32-bit words use the low half.
+template <typename T, typename Enable = void>
+struct default_hash;
+
+template <typename T>
+struct default_hash<T, typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type>
+{
+	static const bool seeded = true;
+
+	uint64_t operator()(T value, uhash seed = 0) const
+	{
+		if (sizeof(T) <= sizeof(uint32_t))
+			return hash_int32((uint32_t)value ^ seed);
+		else
+			return hash_int64((uint64_t)value ^ (seed * 0x9e3779b97f4a7c15ULL));
+	}
+};
+
+template <typename T>
+struct default_hash<T*>
+{
+	static const bool seeded = true;
+
+	uint64_t operator()(const T *value, uhash seed = 0) const
+	{
+		return hash_int64((uint64_t)(uintptr_t)value ^ (seed * 0x9e3779b97f4a7c15ULL));
+	}
+};
+
+template <>
+struct default_hash<string_ref>
+{
+	static const bool seeded = true;
+
+	uint64_t operator()(const string_ref &value, uhash seed = 0) const
+	{
+		return hash_bytes64(value.data, value.length, seed);
+	}
+};
+
+// Hash functors that define `static const bool seeded = true` are called
+// with the table seed as a second argument, others only with the key.
+template <typename Hash, typename Enable = void>
+struct is_seeded_hash : std::false_type { };
+
+template <typename Hash>
+struct is_seeded_hash<Hash, typename std::enable_if<Hash::seeded>::type> : std::true_type { };
+
+template <typename Hash, typename K>
+inline uint64_t hash_with_seed(const K &key, uhash seed, std::true_type)
+{
+	return Hash()(key, seed);
+}
+
+template <typename Hash, typename K>
+inline uint64_t hash_with_seed(const K &key, uhash, std::false_type)
+{
+	return Hash()(key);
+}
+
+template <typename Hash, typename K>
+inline uint64_t hash_with_seed(const K &key, uhash seed)
+{
+	return hash_with_seed<Hash>(key, seed, is_seeded_hash<Hash>());
+}
+
+// Returns a new unpredictable seed for a table, cheap enough to call for
+// every constructed container (no locking, per-thread state)
+uhash hash_random_seed();
@@ -2,13 +2,26 @@
 
 #include "base.h"
 #include "memory.h"
+#include "hash.h"
 #include <string.h>
 #include <new>
 #include <utility>
 #include <type_traits>
 
-typedef unsigned usize;
-typedef unsigned uhash;
+#if p_sse2
+	#include <emmintrin.h>
+#endif
+
+// Define as 1 to count the rehashes of every table and the time spent in them,
+// see `hash_stats`. Must be the same for every translation unit.
+#ifndef p_hash_counters
+	#define p_hash_counters 0
+#endif
+
+// Longest probe distance allowed for a new key in a table with a seeded hash
+// before the table is reseeded. With at most 50% load and a decent hash the
+// longest probe grows roughly logarithmically and stays far below this.
+static const usize hash_probe_limit = 64;
 
 inline usize next_pow2(usize val)
 {
@@ -21,14 +34,140 @@ inline usize next_pow2(usize val)
 	return x + 1;
 }
 
+inline uint64_t next_pow2(uint64_t val)
+{
+	uint64_t x = val - 1;
+	x |= x >> 1;
+	x |= x >> 2;
+	x |= x >> 4;
+	x |= x >> 8;
+	x |= x >> 16;
+	x |= x >> 32;
+	return x + 1;
+}
+
 template <typename T>
 void cswap(T &a, T &b)
 {
-	T tmp(std::move(a));
-	a.~T();
-	new (&a) T(std::move(b));
-	b.~T();
-	new (&b) T(std::move(tmp));
+	if (p_trivially_relocatable(T)) {
+		alignas(T) char tmp[sizeof(T)];
+		memcpy(tmp, (const void*)&a, sizeof(T));
+		memcpy((void*)&a, (const void*)&b, sizeof(T));
+		memcpy((void*)&b, tmp, sizeof(T));
+	} else {
+		T tmp(std::move(a));
+		a.~T();
+		new (&a) T(std::move(b));
+		b.~T();
+		new (&b) T(std::move(tmp));
+	}
+}
+
+// Returns the index of the first non-zero hash in `hb[begin .. end)` or `end`
+// if there is none. Empty runs are skipped 16 slots at a time.
+inline usize find_used_hash_slot(const uhash *hb, usize begin, usize end)
+{
+	usize ix = begin;
+
+	// Fast path for dense tables
+	if (ix < end && hb[ix] != 0)
+		return ix;
+
+#if p_sse2
+	__m128i const zero = _mm_setzero_si128();
+	for (; ix + 16 <= end; ix += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i*)(hb + ix + 0));
+		__m128i b = _mm_loadu_si128((const __m128i*)(hb + ix + 4));
+		__m128i c = _mm_loadu_si128((const __m128i*)(hb + ix + 8));
+		__m128i d = _mm_loadu_si128((const __m128i*)(hb + ix + 12));
+		__m128i any = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(any, zero)) != 0xffff)
+			break;
+	}
+#else
+	for (; ix + 4 <= end; ix += 4) {
+		if ((hb[ix + 0] | hb[ix + 1] | hb[ix + 2] | hb[ix + 3]) != 0)
+			break;
+	}
+#endif
+
+	while (ix < end && hb[ix] == 0)
+		ix++;
+
+	return ix;
+}
+
+// 64-bit hash version of the above, skips 8 slots at a time
+inline uint64_t find_used_hash_slot(const uint64_t *hb, uint64_t begin, uint64_t end)
+{
+	uint64_t ix = begin;
+
+	if (ix < end && hb[ix] != 0)
+		return ix;
+
+#if p_sse2
+	__m128i const zero = _mm_setzero_si128();
+	for (; ix + 8 <= end; ix += 8) {
+		__m128i a = _mm_loadu_si128((const __m128i*)(hb + ix + 0));
+		__m128i b = _mm_loadu_si128((const __m128i*)(hb + ix + 2));
+		__m128i c = _mm_loadu_si128((const __m128i*)(hb + ix + 4));
+		__m128i d = _mm_loadu_si128((const __m128i*)(hb + ix + 6));
+		__m128i any = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(any, zero)) != 0xffff)
+			break;
+	}
+#else
+	for (; ix + 4 <= end; ix += 4) {
+		if ((hb[ix + 0] | hb[ix + 1] | hb[ix + 2] | hb[ix + 3]) != 0)
+			break;
+	}
+#endif
+
+	while (ix < end && hb[ix] == 0)
+		ix++;
+
+	return ix;
+}
+
+// Returns the slot index of `key` in a Robin Hood table laid out as
+// `hb[capacity]` and `kvb[capacity]` or `capacity` if it's not found.
+template <typename Word, typename KeyVal, typename K>
+Word find_hash_slot(const Word *hb, const KeyVal *kvb, Word capacity, const K &key, Word hash_or_zero)
+{
+	Word const hash = hash_or_zero ? hash_or_zero : 1;
+	Word const mask = capacity - 1;
+
+	if (capacity == 0)
+		return 0;
+
+	Word index = hash & mask;
+	Word scan = 0;
+
+	// Scan before any swapping has happened
+	for (;;) {
+		Word const hval = hb[index];
+		const KeyVal &kvref = kvb[index];
+
+		// Found the key
+		if (hval == hash && key == kvref.key) {
+			return index;
+		}
+
+		// Found an empty cell
+		if (hval == 0) {
+			return capacity;
+		}
+
+		Word const sref = (index - hval) & mask;
+
+		// Current slot has shorter scan distance -> would have been swapped
+		if (sref < scan) {
+			return capacity;
+		}
+
+		index = (index + 1) & mask;
+		scan++;
+	}
 }
 
 struct always_false
@@ -40,14 +179,53 @@ struct always_false
 	}
 };
 
+// Snapshot of the shape of a hash table returned by `hash_container::stats()`
+struct hash_stats
+{
+	static const usize histogram_size = 16;
+
+	uint64_t count;
+	uint64_t capacity;
+	double load_factor;
+
+	// Probe distance of an entry is `(index - hash) & mask`, the number of
+	// slots it is displaced from its ideal slot
+	double mean_probe;
+	uint64_t max_probe;
+
+	// Number of entries per probe distance, the last bucket also counts
+	// all the longer distances
+	uint64_t probe_histogram[histogram_size];
+
+	// Bytes allocated for the table and the part of it taken by empty slots
+	size_t memory_used;
+	size_t memory_wasted;
+
+	// Only counted if `p_hash_counters` is enabled
+	uint32_t rehash_count;
+	uint64_t rehash_time_ns;
+};
+
+// Word is the type of the sizes, indices and stored hashes of a table: the
+// default 32-bit `usize` keeps the table compact, `uint64_t` allows tables
+// with more than 2^31 slots and keeps 64 bits of every hash.
+template <typename Word>
 struct hash_base
 {
+	typedef Word size_type;
+	typedef Word hash_type;
+
 	hash_base()
 		: count(0)
 		, capacity(0)
 		, hbuf(nullptr)
 		, kvbuf(nullptr)
 		, ator(nullptr)
+		, seed(hash_random_seed())
+#if p_hash_counters
+		, rehash_count(0)
+		, rehash_time_ns(0)
+#endif
 	{
 	}
 
@@ -57,6 +235,11 @@ struct hash_base
 		, hbuf(hb.hbuf)
 		, kvbuf(hb.kvbuf)
 		, ator(hb.ator)
+		, seed(hb.seed)
+#if p_hash_counters
+		, rehash_count(hb.rehash_count)
+		, rehash_time_ns(hb.rehash_time_ns)
+#endif
 	{
 
 		hb.count = 0;
@@ -66,10 +249,15 @@ struct hash_base
 		hb.ator = nullptr;
 	}
 
-	hash_base(usize count, usize capacity)
+	hash_base(size_type count, size_type capacity, uhash seed)
 		: count(count)
 		, capacity(capacity)
 		, ator(nullptr)
+		, seed(seed)
+#if p_hash_counters
+		, rehash_count(0)
+		, rehash_time_ns(0)
+#endif
 	{
 	}
 
@@ -79,25 +267,33 @@ struct hash_base
 			mem::free(kvbuf);
 	}
 
-	usize count;
-	usize capacity;
-	uhash *hbuf;
+	size_type count;
+	size_type capacity;
+	hash_type *hbuf;
 	void  *kvbuf;
 	mem::allocator *ator;
 
+	// Seed passed to seeded hash functions, the stored hashes depend on it
+	uhash seed;
+
+#if p_hash_counters
+	uint32_t rehash_count;
+	uint64_t rehash_time_ns;
+#endif
+
 	// -- Iterators
 
 	template <typename It>
 	struct iterator_base
 	{
 		const hash_base *base;
-		usize index;
+		size_type index;
 
 		iterator_base()
 		{
 		}
 
-		iterator_base(const hash_base *base, usize index)
+		iterator_base(const hash_base *base, size_type index)
 			: base(base)
 			, index(index)
 		{
@@ -117,21 +313,14 @@ struct hash_base
 
 		It& operator++()
 		{
-			uhash *const hb = base->hbuf;
-			usize const cap = base->capacity;
-			usize ix = index + 1;
-
-			while (ix < cap && hb[ix] == 0)
-				ix++;
-
-			index = ix;
+			index = find_used_hash_slot(base->hbuf, index + 1, base->capacity);
 			return static_cast<It&>(*this);
 		}
 
 		It& operator--()
 		{
-			uhash *const hb = base->hbuf;
-			usize ix = index - 1;
+			hash_type *const hb = base->hbuf;
+			size_type ix = index - 1;
 
 			while (ix >= 0 && hb[ix] == 0)
 				ix--;
@@ -155,70 +344,87 @@ struct hash_base
 		}
 	};
 
-	usize find_first_used_slot(usize begin = 0)
+	size_type find_first_used_slot(size_type begin = 0)
 	{
-		uhash *const hb = hbuf;
-		usize const cap = capacity;
-		usize i;
-		for (i = begin; i < cap; i++) {
-			if (hb[i] != 0)
-				break;
-		}
-		return i;
+		return find_used_hash_slot(hbuf, begin, capacity);
 	}
 };
 
-template <typename KeyVal>
-struct hash_container : hash_base
+template <typename KeyVal, typename Word = usize>
+struct hash_container : hash_base<Word>
 {
 	typedef KeyVal key_val;
+	typedef hash_base<Word> hbase;
+	typedef typename hbase::size_type size_type;
+	typedef typename hbase::hash_type hash_type;
+
+	using hbase::count;
+	using hbase::capacity;
+	using hbase::hbuf;
+	using hbase::kvbuf;
+	using hbase::ator;
+	using hbase::seed;
+#if p_hash_counters
+	using hbase::rehash_count;
+	using hbase::rehash_time_ns;
+#endif
 
 	hash_container()
-		: hash_base()
+		: hbase()
 	{
 	}
 
+	// Allocate the table once for `expected_count` entries from `ator`
+	hash_container(size_type expected_count, mem::allocator *ator)
+		: hbase()
+	{
+		this->ator = ator;
+		if (expected_count > 0)
+			reserve(expected_count);
+	}
+
 	hash_container(const hash_container &rhs)
-		: hash_base(rhs.count, rhs.capacity)
+		: hbase(rhs.count, rhs.capacity, rhs.seed)
 	{
 		if (rhs.count) {
-			size_t alloc_size = (sizeof(key_val) + sizeof(uhash)) * capacity + sizeof(uhash);
-			size_t alloc_align = at_least(alignof(key_val), alignof(uhash));
+			size_t alloc_size = (sizeof(key_val) + sizeof(hash_type)) * capacity + sizeof(hash_type);
+			size_t alloc_align = at_least(alignof(key_val), alignof(hash_type));
 			void *alloc = mem::alloc_using(ator, alloc_size, alloc_align);
 			kvbuf = alloc;
-			hbuf = (uhash*)((char*)kvbuf + align_up(sizeof(key_val) * capacity, alignof(usize)));
+			hbuf = (hash_type*)((char*)kvbuf + align_up(sizeof(key_val) * capacity, alignof(size_type)));
 
 			if (p_trivially_copyable(key_val)) {
 				memcpy(alloc, rhs.kvbuf, alloc_size);
 			} else {
-				uhash *const hb = hbuf;
+				hash_type *const hb = hbuf;
 				key_val *const kvb = (key_val*)kvbuf;
-				const uhash *const rhb = rhs.hbuf;
+				const hash_type *const rhb = rhs.hbuf;
 				const key_val *const rkvb = (const key_val*)rhs.kvbuf;
-				for (usize i = 0; i < capacity; i++) {
-					uhash hash = hb[i] = rhb[i];
+				for (size_type i = 0; i < capacity; i++) {
+					hash_type hash = hb[i] = rhb[i];
 					if (hash) {
 						new (&kvb[i]) key_val(rkvb[i]);
 					}
 				}
 			}
 		} else {
+			capacity = 0;
 			hbuf = nullptr;
 			kvbuf = nullptr;
 		}
 	}
 
 	hash_container(hash_container &&rhs)
-		: hash_base(std::move(rhs))
+		: hbase(std::move(rhs))
 	{
 	}
 
 	~hash_container()
 	{
 		if (!p_trivially_copyable(key_val)) {
-			uhash *const hb = hbuf;
+			hash_type *const hb = hbuf;
 			key_val *const kvb = (key_val*)kvbuf;
-			for (usize i = 0; i < capacity; i++) {
+			for (size_type i = 0; i < capacity; i++) {
 				if (hb[i]) {
 					kvb[i].~key_val();
 				}
@@ -244,43 +450,75 @@ struct hash_container : hash_base
 	// -- Fundamental operations
 
 	// Rehash the container
-	void rehash_impl(usize new_size)
+	void rehash_impl(size_type new_size)
 	{
-		uhash *const hb = hbuf;
-		key_val *const kvb = (key_val*)kvbuf;
-		usize const old_cap = capacity;
+#if p_hash_counters
+		uint64_t begin_ns = get_time_ns();
+#endif
+
+		hash_type *hb = hbuf;
+		key_val *kvb = (key_val*)kvbuf;
+		size_type const old_cap = capacity;
+		size_type const new_cap = new_size ? new_size * 2 : 8;
+
+		size_t alloc_size = (sizeof(key_val) + sizeof(hash_type)) * new_cap + sizeof(hash_type);
+		size_t alloc_align = at_least(alignof(key_val), alignof(hash_type));
+		void *alloc;
+
+		// Grow in place if the allocator can extend the table, eg. when it's the
+		// latest allocation of a `linear_allocator`. The old entries are moved to
+		// a scratch copy freed right after the rehash, which an arena rolls back,
+		// so a table growing by doubling only leaves the final one behind.
+		if (kvb && mem::try_extend(kvb, alloc_size)) {
+			size_t scratch_size = (sizeof(key_val) + sizeof(hash_type)) * old_cap + sizeof(hash_type);
+			key_val *scratch = (key_val*)mem::alloc_using(ator, scratch_size, alloc_align);
+			p_assert(scratch != nullptr);
+			hash_type *scratch_hb = (hash_type*)((char*)scratch + align_up(sizeof(key_val) * old_cap, alignof(size_type)));
+			memcpy(scratch_hb, hb, sizeof(hash_type) * old_cap);
+			for (size_type i = 0; i < old_cap; i++) {
+				if (hb[i] != 0)
+					relocate(&scratch[i], &kvb[i]);
+			}
 
-		capacity = new_size ? new_size * 2 : 8;
+			alloc = kvb;
+			hb = scratch_hb;
+			kvb = scratch;
+		} else {
+			alloc = mem::alloc_using(ator, alloc_size, alloc_align);
+		}
+
+		capacity = new_cap;
 		count = 0;
 
-		size_t alloc_size = (sizeof(key_val) + sizeof(uhash)) * capacity + sizeof(uhash);
-		size_t alloc_align = at_least(alignof(key_val), alignof(uhash));
-		void *alloc = mem::alloc_using(ator, alloc_size, alloc_align);
 		kvbuf = alloc;
-		hbuf = (uhash*)((char*)kvbuf + align_up(sizeof(key_val) * capacity, alignof(usize)));
-		memset(hbuf, 0, sizeof(uhash) * capacity);
+		hbuf = (hash_type*)((char*)kvbuf + align_up(sizeof(key_val) * capacity, alignof(size_type)));
+		memset(hbuf, 0, sizeof(hash_type) * capacity);
 
-		for (usize i = 0; i < old_cap; i++) {
-			uhash const hval = hb[i];
+		for (size_type i = 0; i < old_cap; i++) {
+			hash_type const hval = hb[i];
 			if (hval != 0) {
 				key_val *kv;
 				bool created = insert_with_hash_ptr(always_false(), hval, kv);
 				p_assert(created);
-				new (kv) key_val(std::move(kvb[i]));
-				kvb[i].~key_val();
+				relocate(kv, &kvb[i]);
 			}
 		}
 
 		if (kvb)
 			mem::free((void*)kvb);
+
+#if p_hash_counters
+		rehash_count++;
+		rehash_time_ns += get_time_ns() - begin_ns;
+#endif
 	}
 
 	// Erase with slot index
-	void erase_slot(usize slot_index)
+	void erase_slot(size_type slot_index)
 	{
-		uhash *const hb = hbuf;
+		hash_type *const hb = hbuf;
 		key_val *const kvb = (key_val*)kvbuf;
-		usize const mask = capacity - 1;
+		size_type const mask = capacity - 1;
 
 		p_assert(slot_index < capacity);
 		p_assert(hb[slot_index] != 0);
@@ -289,48 +527,62 @@ struct hash_container : hash_base
 
 		kvb[slot_index].~key_val();
 
-		usize index = slot_index;
-
-		// Shift entries back until there's an empty or zero scan distance cell
+		// Find the run of entries that need to be shifted back: it ends
+		// before an empty or zero scan distance cell
+		size_type end = slot_index;
 		for (;;) {
-			usize const next_index = (index + 1) & mask;
-			uhash hval = hb[next_index];
+			size_type const next_index = (end + 1) & mask;
+			hash_type const hval = hb[next_index];
 
 			if (hval == 0 || ((hval - next_index) & mask) == 0)
-			{
-				hb[index] = 0;
-				return;
-			}
+				break;
 
-			hb[index] = hval;
-			new (&kvb[index]) key_val(std::move(kvb[next_index]));
-			kvb[next_index].~key_val();
+			end = next_index;
+		}
 
-			index = next_index;
+		// Shift the run `(slot_index, end]` back by one slot
+		if (end >= slot_index) {
+			size_type const num = end - slot_index;
+			memmove(hb + slot_index, hb + slot_index + 1, num * sizeof(hash_type));
+			relocate_n(kvb + slot_index, kvb + slot_index + 1, num);
+		} else {
+			// The run wraps around the end of the table
+			size_type const num = mask - slot_index;
+			memmove(hb + slot_index, hb + slot_index + 1, num * sizeof(hash_type));
+			relocate_n(kvb + slot_index, kvb + slot_index + 1, num);
+			hb[mask] = hb[0];
+			relocate(&kvb[mask], &kvb[0]);
+			memmove(hb, hb + 1, end * sizeof(hash_type));
+			relocate_n(kvb, kvb + 1, end);
 		}
+
+		hb[end] = 0;
 	}
 
+	// Returns `true` and a slot for a new entry in `kv` or `false` and the existing one.
+	// If a new key would end up further than `probe_limit` from its ideal slot
+	// nothing is inserted and `kv` is set to null.
 	template <typename K>
-	bool insert_with_hash_ptr(const K &key, uhash hash_or_zero, key_val *&kv)
+	bool insert_with_hash_ptr(const K &key, hash_type hash_or_zero, key_val *&kv, size_type probe_limit = ~(size_type)0)
 	{
 		if (count * 2 >= capacity)
 			rehash_impl(capacity);
 
-		uhash const hash = hash_or_zero ? hash_or_zero : 1;
-		uhash *const hb = hbuf;
+		hash_type const hash = hash_or_zero ? hash_or_zero : 1;
+		hash_type *const hb = hbuf;
 		key_val *const kvb = (key_val*)kvbuf;
-		usize const mask = capacity - 1;
+		size_type const mask = capacity - 1;
 
-		usize index = hash & mask;
-		usize scan = 0;
+		size_type index = hash & mask;
+		size_type scan = 0;
 
 		alignas(key_val) char swapbuf[sizeof(key_val)];
-		uhash swaphash;
+		hash_type swaphash;
 
 		// Scan before any swapping has happened
 		for (;;) {
-			uhash &href = hb[index];
-			uhash const hval = href;
+			hash_type &href = hb[index];
+			hash_type const hval = href;
 			key_val &kvref = kvb[index];
 
 			// Found the key
@@ -347,13 +599,12 @@ struct hash_container : hash_base
 				return true;
 			}
 
-			usize const sref = (index - hval) & mask;
+			size_type const sref = (index - hval) & mask;
 
 			// Current slot has shorter scan distance -> insert here
 			if (sref < scan) {
-				new (swapbuf) key_val(std::move(kvref));
+				relocate((key_val*)swapbuf, &kvref);
 				swaphash = hval;
-				kvref.~key_val();
 				kv = &kvref;
 				href = hash;
 				scan = sref;
@@ -363,24 +614,28 @@ struct hash_container : hash_base
 
 			index = (index + 1) & mask;
 			scan++;
+
+			if (scan > probe_limit) {
+				kv = nullptr;
+				return false;
+			}
 		}
 
 		// Element was swapped, find it a new place
 		for (;;) {
 
-			uhash &href = hb[index];
-			uhash const hval = href;
+			hash_type &href = hb[index];
+			hash_type const hval = href;
 			key_val &kvref = kvb[index];
 
 			// Found an empty slot, finish
 			if (hval == 0) {
-				new (&kvref) key_val(std::move(*(key_val*)swapbuf));
+				relocate(&kvref, (key_val*)swapbuf);
 				href = swaphash;
-				(*(key_val*)swapbuf).~key_val();
 				return true;
 			}
 
-			usize const sref = (index - hval) & mask;
+			size_type const sref = (index - hval) & mask;
 
 			// Current slot has shorter scan distance -> swap
 			if (sref < scan) {
@@ -394,63 +649,151 @@ struct hash_container : hash_base
 		}
 	}
 
-	template <typename K>
-	usize find_slot_with_hash(const K &key, uhash hash_or_zero)
+	// Insert `key` hashed with `Hash`. A run of colliding keys longer than
+	// `hash_probe_limit` with a seeded hash is most likely the work of an adversary,
+	// so the table is reseeded once to scatter them.
+	template <typename Hash, typename K>
+	bool insert_with_hash_fn(const K &key, key_val *&kv)
 	{
-		uhash const hash = hash_or_zero ? hash_or_zero : 1;
-		uhash *const hb = hbuf;
+		size_type limit = is_seeded_hash<Hash>::value ? hash_probe_limit : ~(size_type)0;
+		for (;;) {
+			bool inserted = insert_with_hash_ptr(key, (hash_type)hash_with_seed<Hash>(key, seed), kv, limit);
+			if (kv) return inserted;
+			reseed_impl<Hash>(hash_random_seed());
+			limit = ~(size_type)0;
+		}
+	}
+
+	// Re-hash all the keys with `new_seed` and rebuild the table
+	template <typename Hash>
+	void reseed_impl(uhash new_seed)
+	{
+		hash_type *const hb = hbuf;
 		key_val *const kvb = (key_val*)kvbuf;
-		usize const mask = capacity - 1;
+		size_type const cap = capacity;
 
-		if (capacity == 0)
-			return 0;
+		seed = new_seed;
+		for (size_type i = 0; i < cap; i++) {
+			if (hb[i] != 0) {
+				hash_type const hash = (hash_type)hash_with_seed<Hash>(kvb[i].key, seed);
+				hb[i] = hash ? hash : 1;
+			}
+		}
+		rehash_impl(cap / 2);
+	}
 
-		usize index = hash & mask;
-		usize scan = 0;
+	template <typename Hash, typename K>
+	size_type find_slot_with_hash_fn(const K &key) const
+	{
+		return find_hash_slot(hbuf, (const key_val*)kvbuf, capacity, key, (hash_type)hash_with_seed<Hash>(key, seed));
+	}
 
-		// Scan before any swapping has happened
-		for (;;) {
-			uhash const hval = hb[index];
-			key_val &kvref = kvb[index];
+	template <typename K>
+	size_type find_slot_with_hash(const K &key, hash_type hash_or_zero) const
+	{
+		return find_hash_slot(hbuf, (const key_val*)kvbuf, capacity, key, hash_or_zero);
+	}
 
-			// Found the key
-			if (hval == hash && key == kvref.key) {
-				return index;
-			}
+	// Call `func(kv)` for every entry in slot order
+	template <typename Func>
+	void for_each_impl(Func &func)
+	{
+		hash_type *const hb = hbuf;
+		key_val *const kvb = (key_val*)kvbuf;
+		size_type const cap = capacity;
 
-			// Found an empty cell
-			if (hval == 0) {
-				return capacity;
-			}
+		for (size_type i = find_used_hash_slot(hb, 0, cap); i < cap; i = find_used_hash_slot(hb, i + 1, cap)) {
+			func(kvb[i]);
+		}
+	}
 
-			usize const sref = (index - hval) & mask;
+	// Erase every entry where `pred(kv)` returns true in a single pass over the table,
+	// returns the number of erased entries.
+	template <typename Pred>
+	size_type erase_if_impl(Pred &pred)
+	{
+		hash_type *const hb = hbuf;
+		key_val *const kvb = (key_val*)kvbuf;
+		size_type const mask = capacity - 1;
+		size_type const old_count = count;
 
-			// Current slot has shorter scan distance -> would have been swapped
-			if (sref < scan) {
-				return capacity;
+		if (count == 0)
+			return 0;
+
+		// Start after an empty slot: erase_slot() shifts entries back only within
+		// runs of used slots, so no already visited entry can be shifted into
+		// the slots that are yet to be visited.
+		size_type start = 0;
+		while (hb[start] != 0)
+			start++;
+
+		for (size_type step = 1; step <= mask; ) {
+			size_type const index = (start + step) & mask;
+			if (hb[index] != 0 && pred(kvb[index])) {
+				// The next entry of the run may have been shifted to `index`
+				erase_slot(index);
+			} else {
+				step++;
 			}
+		}
 
-			index = (index + 1) & mask;
-			scan++;
+		return old_count - count;
+	}
+
+	hash_stats stats() const
+	{
+		hash_stats s;
+		memset(&s, 0, sizeof(s));
+
+		const hash_type *const hb = hbuf;
+		size_type const cap = capacity;
+		size_type const mask = cap - 1;
+
+		s.count = count;
+		s.capacity = cap;
+		s.load_factor = cap ? (double)count / (double)cap : 0.0;
+
+		uint64_t total_probe = 0;
+		for (size_type i = find_used_hash_slot(hb, 0, cap); i < cap; i = find_used_hash_slot(hb, i + 1, cap)) {
+			size_type const probe = (i - hb[i]) & mask;
+			total_probe += probe;
+			if (probe > s.max_probe) s.max_probe = probe;
+			s.probe_histogram[at_most((uint64_t)probe, (uint64_t)hash_stats::histogram_size - 1)]++;
+		}
+		s.mean_probe = count ? (double)total_probe / (double)count : 0.0;
+
+		if (cap) {
+			s.memory_used = (sizeof(key_val) + sizeof(hash_type)) * cap + sizeof(hash_type);
+			s.memory_wasted = (sizeof(key_val) + sizeof(hash_type)) * (cap - count);
 		}
+
+#if p_hash_counters
+		s.rehash_count = rehash_count;
+		s.rehash_time_ns = rehash_time_ns;
+#endif
+
+		return s;
 	}
 
-	void reserve(usize size)
+	// Size the table so that `size` entries fit without rehashing
+	void reserve(size_type size)
 	{
-		usize const pow2 = next_pow2(size + 1);
+		size_type const pow2 = next_pow2(size + 1);
 		if (pow2 * 2 > capacity)
 			rehash_impl(pow2);
 	}
 
+	// Remove all the entries, keeps the table allocated for reuse
 	void clear()
 	{
 		if (p_trivially_copyable(key_val)) {
-			memset(hbuf, 0, capacity * sizeof(uhash));
+			if (capacity > 0)
+				memset(hbuf, 0, capacity * sizeof(hash_type));
 		} else {
 			key_val *const kvb = (key_val*)kvbuf;
-			uhash *const hb = hbuf;
-			usize const cap = capacity;
-			for (usize i = 0; i < cap; i++) {
+			hash_type *const hb = hbuf;
+			size_type const cap = capacity;
+			for (size_type i = 0; i < cap; i++) {
 				if (hb[i]) {
 					kvb[i].~key_val();
 					hb[i] = 0;
@@ -458,11 +801,20 @@ struct hash_container : hash_base
 			}
 		}
 
-		capacity = 0;
 		count = 0;
 	}
 };
 
+// Number of elements in `[first, last)` for presizing tables built from ranges
+template <typename It>
+size_t hash_range_count(It first, It last)
+{
+	size_t num = 0;
+	for (; first != last; ++first)
+		num++;
+	return num;
+}
+
 template <typename Key>
 struct set_key_val
 {
@@ -476,95 +828,188 @@ struct map_key_val
 	Val val;
 };
 
-template <typename T>
-struct default_hash;
+template <typename Key>
+struct is_trivially_relocatable<set_key_val<Key>>
+	: std::integral_constant<bool, p_trivially_relocatable(Key)>
+{
+};
 
-template <typename Key, typename Val, typename Hash = default_hash<Key>>
-struct hash_map : hash_container<map_key_val<Key, Val>>
+template <typename Key, typename Val>
+struct is_trivially_relocatable<map_key_val<Key, Val>>
+	: std::integral_constant<bool, p_trivially_relocatable(Key) && p_trivially_relocatable(Val)>
+{
+};
+
+template <typename Key, typename Val, typename Hash = default_hash<Key>, typename Word = usize>
+struct hash_map : hash_container<map_key_val<Key, Val>, Word>
 {
-	typedef hash_container<map_key_val<Key, Val>> base;
+	typedef hash_container<map_key_val<Key, Val>, Word> base;
 	typedef typename base::key_val key_val;
 	typedef map_key_val<const Key, Val> value_type;
 
-	struct iterator : hash_base::iterator_base<iterator>
+	struct iterator : hash_base<Word>::template iterator_base<iterator>
 	{
-		iterator() : hash_base::iterator_base<iterator>() { }
-		iterator(const hash_base *h, usize i) : hash_base::iterator_base<iterator>(h, i) { }
+		iterator() : hash_base<Word>::template iterator_base<iterator>() { }
+		iterator(const hash_base<Word> *h, Word i) : hash_base<Word>::template iterator_base<iterator>(h, i) { }
 
 		value_type *operator->() { return &((value_type*)this->base->kvbuf)[this->index]; }
 		value_type &operator*()  { return ((value_type*)this->base->kvbuf)[this->index]; }
 	};
 
-	struct const_iterator : hash_base::iterator_base<const_iterator>
+	struct const_iterator : hash_base<Word>::template iterator_base<const_iterator>
 	{
-		const_iterator() : hash_base::iterator_base<const_iterator>() { }
-		const_iterator(iterator it) : hash_base::iterator_base<const_iterator>(it.base, it.index) { }
-		const_iterator(const hash_base *h, usize i) : hash_base::iterator_base<const_iterator>(h, i) { }
+		const_iterator() : hash_base<Word>::template iterator_base<const_iterator>() { }
+		const_iterator(iterator it) : hash_base<Word>::template iterator_base<const_iterator>(it.base, it.index) { }
+		const_iterator(const hash_base<Word> *h, Word i) : hash_base<Word>::template iterator_base<const_iterator>(h, i) { }
 
 		const value_type *operator->() { return &((const value_type*)this->base->kvbuf)[this->index]; }
 		const value_type &operator*()  { return ((const value_type*)this->base->kvbuf)[this->index]; }
 	};
 
-	template <typename K, typename V>
-	bool insert_impl(K &&key, V &&value)
+	hash_map()
+	{
+	}
+
+	// Presize for `expected_count` entries, with a linear allocator as `ator`
+	// the table stays in its first allocation unless it outgrows the count
+	explicit hash_map(Word expected_count, mem::allocator *ator = nullptr)
+		: base(expected_count, ator)
+	{
+	}
+
+	// Build from a range of entries with `key` and `val` members with a single
+	// table allocation, later duplicate keys replace the earlier values
+	template <typename It>
+	hash_map(It first, It last, mem::allocator *ator = nullptr)
+		: base((Word)hash_range_count(first, last), ator)
+	{
+		for (; first != last; ++first)
+			insert(first->key, first->val);
+	}
+
+	// Construct the value in place from `args`, replacing the previous value if
+	// the key exists. `args` must not refer to the previous value.
+	template <typename K, typename... Args>
+	bool emplace_impl(K &&key, Args&&... args)
 	{
 		key_val *kv;
-		bool inserted = base::insert_with_hash_ptr(key, Hash()(key), kv);
+		bool inserted = base::template insert_with_hash_fn<Hash>(key, kv);
 		if (inserted) {
 			new (&kv->key) Key(std::forward<typename std::remove_reference<K>::type>(key));
 		} else {
 			kv->val.~Val();
 		}
-		new (&kv->val) Val(std::forward<typename std::remove_reference<V>::type>(value));
+		new (&kv->val) Val(std::forward<Args>(args)...);
 		return inserted;
 	}
 
-	template <typename K>
-	bool insert_ptr_impl(K &&key, key_val *&kv)
+	// Construct the value in place from `args` only if the key doesn't exist,
+	// otherwise `args` are left untouched
+	template <typename K, typename... Args>
+	bool try_emplace_impl(key_val *&kv, K &&key, Args&&... args)
+	{
+		bool inserted = base::template insert_with_hash_fn<Hash>(key, kv);
+		if (inserted) {
+			new (&kv->key) Key(std::forward<typename std::remove_reference<K>::type>(key));
+			new (&kv->val) Val(std::forward<Args>(args)...);
+		}
+		return inserted;
+	}
+
+	// Construct the value if the key doesn't exist, otherwise assign over the old value
+	template <typename K, typename V>
+	bool insert_or_assign_impl(K &&key, V &&value)
 	{
-		bool inserted = base::insert_with_hash_ptr(key, Hash()(key), kv);
+		key_val *kv;
+		bool inserted = base::template insert_with_hash_fn<Hash>(key, kv);
 		if (inserted) {
 			new (&kv->key) Key(std::forward<typename std::remove_reference<K>::type>(key));
-			new (&kv->val) Val();
+			new (&kv->val) Val(std::forward<V>(value));
+		} else {
+			kv->val = std::forward<V>(value);
 		}
 		return inserted;
 	}
 
+	template <typename K, typename V>
+	bool insert_impl(K &&key, V &&value)
+	{
+		return emplace_impl(std::forward<K>(key), std::forward<V>(value));
+	}
+
+	template <typename K>
+	bool insert_ptr_impl(K &&key, key_val *&kv)
+	{
+		return try_emplace_impl(kv, std::forward<K>(key));
+	}
+
+	// `insert()` and `emplace()` overwrite the value of an existing key, unlike
+	// the standard containers: the old value is destroyed before the new one is
+	// constructed in its place, so the arguments must not refer to the old value.
+	// Use `try_emplace()` to keep an existing value or `insert_or_assign()` to
+	// assign over it.
 	bool insert(const Key  &key, const Val  &val) { return insert_impl(          key,            val); }
 	bool insert(const Key  &key,       Val &&val) { return insert_impl(          key,  std::move(val)); }
 	bool insert(      Key &&key, const Val  &val) { return insert_impl(std::move(key),           val); }
 	bool insert(      Key &&key,       Val &&val) { return insert_impl(std::move(key), std::move(val)); }
 
-	bool insert_ptr(const Key  &key, const Val *&val) { key_val *kv; bool i = insert_ptr_impl(key,            kv); val = kv->val; return i; }
-	bool insert_ptr(      Key &&key, const Val *&val) { key_val *kv; bool i = insert_ptr_impl(std::move(key), kv); val = kv->val; return i; }
+	bool insert_ptr(const Key  &key, Val *&val) { key_val *kv; bool i = insert_ptr_impl(key,            kv); val = &kv->val; return i; }
+	bool insert_ptr(      Key &&key, Val *&val) { key_val *kv; bool i = insert_ptr_impl(std::move(key), kv); val = &kv->val; return i; }
+
+	template <typename... Args> bool emplace(const Key  &key, Args&&... args) { return emplace_impl(          key,  std::forward<Args>(args)...); }
+	template <typename... Args> bool emplace(      Key &&key, Args&&... args) { return emplace_impl(std::move(key), std::forward<Args>(args)...); }
+
+	template <typename... Args> bool try_emplace(const Key  &key, Args&&... args) { key_val *kv; return try_emplace_impl(kv,           key,  std::forward<Args>(args)...); }
+	template <typename... Args> bool try_emplace(      Key &&key, Args&&... args) { key_val *kv; return try_emplace_impl(kv, std::move(key), std::forward<Args>(args)...); }
+
+	bool insert_or_assign(const Key  &key, const Val  &val) { return insert_or_assign_impl(          key,            val); }
+	bool insert_or_assign(const Key  &key,       Val &&val) { return insert_or_assign_impl(          key,  std::move(val)); }
+	bool insert_or_assign(      Key &&key, const Val  &val) { return insert_or_assign_impl(std::move(key),           val); }
+	bool insert_or_assign(      Key &&key,       Val &&val) { return insert_or_assign_impl(std::move(key), std::move(val)); }
 
 	Val& operator[](const Key  &key) { key_val *kv; insert_ptr_impl(key,            kv); return kv->val; }
 	Val& operator[](      Key &&key) { key_val *kv; insert_ptr_impl(std::move(key), kv); return kv->val; }
 
 	iterator erase(const_iterator it)
 	{
-		usize const slot = it.index;
+		Word const slot = it.index;
 		base::erase_slot(slot);
 		return iterator(this, base::find_first_used_slot(slot));
 	}
 
 	bool erase(const Key &key)
 	{
-		usize slot = base::find_slot_with_hash(key, Hash()(key));
+		Word slot = base::template find_slot_with_hash_fn<Hash>(key);
 		if (slot == base::capacity) return false;
 		base::erase_slot(slot);
 		return true;
 	}
 
+	// Call `func(value_type&)` for every entry
+	template <typename Func>
+	void for_each(Func func)
+	{
+		auto fn = [&](key_val &kv) { func(*(value_type*)&kv); };
+		base::for_each_impl(fn);
+	}
+
+	// Erase every entry where `pred(value_type&)` returns true, returns the number erased
+	template <typename Pred>
+	Word erase_if(Pred pred)
+	{
+		auto fn = [&](key_val &kv) -> bool { return pred(*(value_type*)&kv); };
+		return base::erase_if_impl(fn);
+	}
+
 	iterator find(const Key &key)
 	{
-		usize slot = base::find_slot_with_hash(key, Hash()(key));
+		Word slot = base::template find_slot_with_hash_fn<Hash>(key);
 		return iterator(this, slot);
 	}
 
 	const_iterator find(const Key &key) const
 	{
-		usize slot = base::find_slot_with_hash(key, Hash()(key));
+		Word slot = base::template find_slot_with_hash_fn<Hash>(key);
 		return const_iterator(this, slot);
 	}
 
@@ -575,17 +1020,17 @@ struct hash_map : hash_container<map_key_val<Key, Val>>
 	iterator end() { return iterator(this, base::capacity); }
 };
 
-template <typename Key, typename Hash = default_hash<Key>>
-struct hash_set : hash_container<set_key_val<Key>>
+template <typename Key, typename Hash = default_hash<Key>, typename Word = usize>
+struct hash_set : hash_container<set_key_val<Key>, Word>
 {
-	typedef hash_container<set_key_val<Key>> base;
+	typedef hash_container<set_key_val<Key>, Word> base;
 	typedef typename base::key_val key_val;
 	typedef Key value_type;
 
-	struct const_iterator : hash_base::iterator_base<const_iterator>
+	struct const_iterator : hash_base<Word>::template iterator_base<const_iterator>
 	{
-		const_iterator() : hash_base::iterator_base<const_iterator>() { }
-		const_iterator(const hash_base *h, usize i) : hash_base::iterator_base<const_iterator>(h, i) { }
+		const_iterator() : hash_base<Word>::template iterator_base<const_iterator>() { }
+		const_iterator(const hash_base<Word> *h, Word i) : hash_base<Word>::template iterator_base<const_iterator>(h, i) { }
 
 		const value_type *operator->() { return &((key_val*)this->base->kvbuf)[this->index].key; }
 		const value_type &operator*()  { return ((key_val*)this->base->kvbuf)[this->index].key; }
@@ -593,11 +1038,30 @@ struct hash_set : hash_container<set_key_val<Key>>
 
 	typedef const_iterator iterator;
 
+	hash_set()
+	{
+	}
+
+	// Presize for `expected_count` keys, see `hash_map`
+	explicit hash_set(Word expected_count, mem::allocator *ator = nullptr)
+		: base(expected_count, ator)
+	{
+	}
+
+	// Build from a range of keys with a single table allocation
+	template <typename It>
+	hash_set(It first, It last, mem::allocator *ator = nullptr)
+		: base((Word)hash_range_count(first, last), ator)
+	{
+		for (; first != last; ++first)
+			insert(*first);
+	}
+
 	template <typename K>
 	bool insert_impl(K &&key)
 	{
 		key_val *kv;
-		bool inserted = base::insert_with_hash_ptr(key, Hash()(key), kv);
+		bool inserted = base::template insert_with_hash_fn<Hash>(key, kv);
 		if (inserted) {
 			new (&kv->key) Key(std::forward<typename std::remove_reference<K>::type>(key));
 		}
@@ -609,14 +1073,14 @@ struct hash_set : hash_container<set_key_val<Key>>
 
 	iterator erase(const_iterator it)
 	{
-		usize const slot = it.index;
+		Word const slot = it.index;
 		base::erase_slot(slot);
 		return iterator(this, base::find_first_used_slot(slot));
 	}
 
 	bool erase(const Key &key)
 	{
-		usize slot = base::find_slot_with_hash(key, Hash()(key));
+		Word slot = base::template find_slot_with_hash_fn<Hash>(key);
 		if (slot == base::capacity) return false;
 		base::erase_slot(slot);
 		return true;
@@ -624,10 +1088,51 @@ struct hash_set : hash_container<set_key_val<Key>>
 
 	const_iterator find(const Key &key) const
 	{
-		usize slot = base::find_slot_with_hash(key, Hash()(key));
+		Word slot = base::template find_slot_with_hash_fn<Hash>(key);
 		return const_iterator(this, slot);
 	}
 
+	// Heterogeneous lookup with a key of another type `K`: `Hash` must hash it
+	// to the same value as the equal `Key` and `k == key` must compare it to a
+	// stored key. Useful when the keys refer to storage outside of the set.
+	template <typename K>
+	const_iterator find_as(const K &key) const
+	{
+		Word slot = base::template find_slot_with_hash_fn<Hash>(key);
+		return const_iterator(this, slot);
+	}
+
+	// Insert the key returned by `make()` if there is no key equal to `key`,
+	// see `find_as()`. Returns `true` if inserted, `result` points to the new
+	// or the existing key.
+	template <typename K, typename Make>
+	bool insert_as(const K &key, Make make, const Key *&result)
+	{
+		key_val *kv;
+		bool inserted = base::template insert_with_hash_fn<Hash>(key, kv);
+		if (inserted) {
+			new (&kv->key) Key(make());
+		}
+		result = &kv->key;
+		return inserted;
+	}
+
+	// Call `func(const Key&)` for every key
+	template <typename Func>
+	void for_each(Func func)
+	{
+		auto fn = [&](key_val &kv) { func((const Key&)kv.key); };
+		base::for_each_impl(fn);
+	}
+
+	// Erase every key where `pred(const Key&)` returns true, returns the number erased
+	template <typename Pred>
+	Word erase_if(Pred pred)
+	{
+		auto fn = [&](key_val &kv) -> bool { return pred((const Key&)kv.key); };
+		return base::erase_if_impl(fn);
+	}
+
 	const_iterator begin() const { return const_iterator(this, base::find_first_used_slot()); }
 	iterator begin() { return iterator(this, base::find_first_used_slot()); }
 	const_iterator end() const { return const_iterator(this, base::capacity); }
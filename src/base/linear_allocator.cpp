@@ -5,6 +5,7 @@ linear_allocator::linear_allocator()
 	: memory(nullptr)
 	, pos(0)
 	, capacity(0)
+	, last_pos(0)
 	, ator(nullptr)
 {
 }
@@ -45,6 +46,7 @@ void linear_allocator::reset()
 	memory = nullptr;
 	pos = 0;
 	capacity = 0;
+	last_pos = 0;
 }
 
 void *linear_allocator::allocator_allocate(uint32_t thread, size_t size, size_t alignment)
@@ -53,4 +55,26 @@ void *linear_allocator::allocator_allocate(uint32_t thread, size_t size, size_t
 }
 void linear_allocator::allocator_free(uint32_t thread, void *pointer, size_t size, size_t alignment)
 {
+	// Freeing the latest allocation rolls it back so the space can be reused,
+	// including its alignment padding so an allocation before it ends at `pos`
+	// again and can be extended
+	char *ptr = (char*)pointer;
+	if (ptr >= (char*)memory && ptr + size == (char*)memory + pos) {
+		size_t const begin = ptr - (char*)memory;
+		pos = last_pos <= begin ? last_pos : begin;
+		last_pos = pos;
+	}
+}
+bool linear_allocator::allocator_extend(uint32_t thread, void *pointer, size_t size, size_t new_size, size_t alignment)
+{
+	// Only the latest allocation can grow, as long as it fits in the current block
+	char *ptr = (char*)pointer;
+	if (ptr >= (char*)memory && ptr + size == (char*)memory + pos) {
+		size_t const begin = ptr - (char*)memory;
+		if (begin + new_size <= capacity) {
+			pos = begin + new_size;
+			return true;
+		}
+	}
+	return false;
 }
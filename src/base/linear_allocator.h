@@ -13,6 +13,7 @@ struct linear_allocator : mem::allocator
 
 	virtual void *allocator_allocate(uint32_t thread, size_t size, size_t alignment) override;
 	virtual void allocator_free(uint32_t thread, void *pointer, size_t size, size_t alignment) override;
+	virtual bool allocator_extend(uint32_t thread, void *pointer, size_t size, size_t new_size, size_t alignment) override;
 
 	void *alloc(size_t size, size_t alignment)
 	{
@@ -22,10 +23,24 @@ struct linear_allocator : mem::allocator
 		}
 
 		void *mem = (char*)memory + alloc_pos;
+		last_pos = pos;
 		pos = alloc_pos + size;
 		return mem;
 	}
 
+	// Copy an array of `count` elements to a new cache line aligned allocation
+	// of `new_capacity` elements. The old array is left in place until `reset()`.
+	template <typename T>
+	T *realloc_array(T *data, size_t count, size_t new_capacity)
+	{
+		static_assert(p_trivially_copyable(T), "Array elements are copied with memcpy()");
+		p_assert(count <= new_capacity);
+		T *new_data = (T*)alloc(sizeof(T) * new_capacity, (size_t)at_least((uint64_t)alignof(T), (uint64_t)64));
+		if (count > 0)
+			memcpy((void*)new_data, (const void*)data, sizeof(T) * count);
+		return new_data;
+	}
+
 	size_t grow(size_t size, size_t alignment);
 
 	void reset();
@@ -33,5 +48,8 @@ struct linear_allocator : mem::allocator
 	void *memory;
 	size_t pos;
 	size_t capacity;
+
+	// Position before the alignment padding of the latest allocation
+	size_t last_pos;
 	mem::allocator *ator;
 };
@@ -1,4 +1,5 @@
 #include "memory.h"
+#include "bit_math.h"
 #include <stdlib.h>
 #include <mutex>
 #include <atomic>
@@ -34,7 +35,8 @@ struct stdlib_allocator : allocator
 {
 	virtual void *allocator_allocate(uint32_t thread, size_t size, size_t alignment) override
 	{
-		return ::aligned_alloc(alignment, size);
+		// C11 requires the size to be a multiple of the alignment
+		return ::aligned_alloc(alignment, (size_t)align_up((uint64_t)size, (uint64_t)alignment));
 	}
 	virtual void allocator_free(uint32_t thread, void *pointer, size_t size, size_t alignment) override
 	{
@@ -68,14 +70,22 @@ thread_data *get_thread_data()
 	return td;
 }
 
+// The size is split in 32+11 bits and the alignment is stored as a power
+// of two to keep the header at two pointers on 64-bit platforms
 struct block_header
 {
 	allocator *alloc;
-	uint32_t size;
-	uint16_t alignment;
-	uint16_t offset;
+	uint32_t size_lo;
+	uint32_t size_hi : 11;
+	uint32_t alignment_log2 : 5;
+	uint32_t offset : 16;
+
+	size_t size() const { return (size_t)((uint64_t)size_hi << 32 | size_lo); }
+	size_t alignment() const { return (size_t)1 << alignment_log2; }
 };
 
+constexpr uint64_t max_alloc_size = ((uint64_t)1 << 43) - 1;
+
 static_assert(alignof(block_header) == alignof(void*), "block_header must be pointer-aligned");
 
 }
@@ -107,14 +117,15 @@ void *alloc_using(allocator *alloc, size_t size, size_t alignment, size_t header
 	block_header *hd = (block_header*)(ptr + prefix_size - header - sizeof(block_header));
 
 	size_t offset = (char*)hd - (char*)ptr;
-	p_assert(actual_size <= UINT32_MAX);
+	p_assert((uint64_t)actual_size <= max_alloc_size);
 	p_assert(offset <= UINT16_MAX);
 	p_assert(actual_alignment <= UINT16_MAX);
 
 	hd->alloc = alloc;
-	hd->size = (uint32_t)actual_size;
-	hd->alignment = (uint16_t)actual_alignment;
-	hd->offset = (uint16_t)offset;
+	hd->size_lo = (uint32_t)actual_size;
+	hd->size_hi = (uint32_t)((uint64_t)actual_size >> 32);
+	hd->alignment_log2 = find_msb((uint32_t)actual_alignment);
+	hd->offset = (uint32_t)offset;
 
 	return (char*)hd + sizeof(block_header);
 }
@@ -127,14 +138,39 @@ void free(void *pointer)
 	thread_data *td = get_thread_data();
 	char *base = (char*)pointer - sizeof(block_header);
 	block_header *hd = (block_header*)base;
-	hd->alloc->allocator_free(td->thread_index, base - hd->offset, hd->size, hd->alignment);
+	hd->alloc->allocator_free(td->thread_index, base - hd->offset, hd->size(), hd->alignment());
+}
+
+bool try_extend(void *pointer, size_t new_size)
+{
+	if (pointer == nullptr)
+		return false;
+
+	char *base = (char*)pointer - sizeof(block_header);
+	block_header *hd = (block_header*)base;
+	size_t const size = hd->size();
+	size_t const user_size = size - hd->offset - sizeof(block_header);
+	if (new_size <= user_size)
+		return true;
+
+	size_t const new_actual_size = size + (new_size - user_size);
+	if ((uint64_t)new_actual_size > max_alloc_size)
+		return false;
+
+	thread_data *td = get_thread_data();
+	if (!hd->alloc->allocator_extend(td->thread_index, base - hd->offset, size, new_actual_size, hd->alignment()))
+		return false;
+
+	hd->size_lo = (uint32_t)new_actual_size;
+	hd->size_hi = (uint32_t)((uint64_t)new_actual_size >> 32);
+	return true;
 }
 
 size_t get_size(const void *pointer)
 {
 	char *base = (char*)pointer - sizeof(block_header);
 	block_header *hd = (block_header*)base;
-	return hd->size - hd->offset - sizeof(block_header);
+	return hd->size() - hd->offset - sizeof(block_header);
 }
 
 allocator *get_standard_allocator()
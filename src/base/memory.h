@@ -10,7 +10,8 @@ namespace mem {
 // * Around 16 bytes per allocation + overhead of the actual allocator
 // * Indirect call per allocation or free
 //
-// The maximum supported total allocation size is UINT32_MAX (around 4GB)
+// The maximum supported total allocation size is 2^43-1 bytes (around 8TB) on
+// 64-bit platforms
 //
 // The allocated memory contains the information necessary to be able to
 // free itself, so the pointers can be passed further without the allocator!
@@ -46,6 +47,11 @@ void *alloc_using(allocator *alloc, size_t size, size_t alignment = 8, size_t he
 // Note: The allocator that the pointer was allocated with must be still valid.
 void free(void *pointer);
 
+// Try to grow the allocation at `pointer` to `new_size` bytes (excluding the header)
+// without moving it. Returns `false` if the allocator can't extend it in place,
+// in which case the allocation is left untouched.
+bool try_extend(void *pointer, size_t new_size);
+
 // Retrieve the size in bytes of the pointer allocated with `mem::alloc/realloc/_using`
 // Returns the total user visible size of the allocation (size + header)
 size_t get_size(const void *pointer);
@@ -85,6 +91,15 @@ struct allocator
 	// Free previously allocated pointer. `size` and `alignment` are the same as when allocated.
 	// * thread: Thread index of the _calling_ thread, not the one which allocated the pointer!
 	virtual void allocator_free(uint32_t thread, void *pointer, size_t size, size_t alignment) = 0;
+
+	// Optional methods:
+
+	// Grow the allocation at `pointer` from `size` to `new_size` bytes without moving it.
+	// Return `false` if it's not possible, which is the default.
+	virtual bool allocator_extend(uint32_t thread, void *pointer, size_t size, size_t new_size, size_t alignment)
+	{
+		return false;
+	}
 };
 
 }
@@ -0,0 +1,274 @@
+#pragma once
+
+#include "hash_map.h"
+#include "node_pool.h"
+
+// Hash map with pointer-stable entries
+//
+// The Robin Hood probe table only contains the hashes and pointers to the
+// entries, which are allocated from a `node_pool`. Inserting, erasing and
+// rehashing only move the pointers, so references to keys and values stay
+// valid until the entry is erased. Prefer this over `hash_map` for values
+// that are large or expensive to move, or that are referred to by pointer.
+template <typename Key, typename Val, typename Hash = default_hash<Key>, typename Word = usize>
+struct node_hash_map : hash_container<set_key_val<map_key_val<Key, Val>*>, Word>
+{
+	typedef map_key_val<Key, Val> key_val;
+	typedef map_key_val<const Key, Val> value_type;
+	typedef set_key_val<key_val*> index_key_val;
+	typedef hash_container<index_key_val, Word> base;
+
+	// Compares the lookup key against the entry pointed to by an index slot
+	struct key_ref
+	{
+		const Key &key;
+
+		explicit key_ref(const Key &key)
+			: key(key)
+		{
+		}
+
+		bool operator==(const key_val *kv) const
+		{
+			return kv->key == key;
+		}
+	};
+
+	// Hashes both lookup keys and the entries when reseeding the index
+	struct node_hash
+	{
+		static const bool seeded = is_seeded_hash<Hash>::value;
+
+		uint64_t operator()(const key_ref &ref, uhash seed = 0) const { return hash_with_seed<Hash>(ref.key, seed); }
+		uint64_t operator()(const key_val *kv, uhash seed = 0) const { return hash_with_seed<Hash>(kv->key, seed); }
+	};
+
+	struct iterator : hash_base<Word>::template iterator_base<iterator>
+	{
+		iterator() : hash_base<Word>::template iterator_base<iterator>() { }
+		iterator(const hash_base<Word> *h, Word i) : hash_base<Word>::template iterator_base<iterator>(h, i) { }
+
+		value_type *operator->() { return (value_type*)((index_key_val*)this->base->kvbuf)[this->index].key; }
+		value_type &operator*()  { return *(value_type*)((index_key_val*)this->base->kvbuf)[this->index].key; }
+	};
+
+	struct const_iterator : hash_base<Word>::template iterator_base<const_iterator>
+	{
+		const_iterator() : hash_base<Word>::template iterator_base<const_iterator>() { }
+		const_iterator(iterator it) : hash_base<Word>::template iterator_base<const_iterator>(it.base, it.index) { }
+		const_iterator(const hash_base<Word> *h, Word i) : hash_base<Word>::template iterator_base<const_iterator>(h, i) { }
+
+		const value_type *operator->() { return (const value_type*)((index_key_val*)this->base->kvbuf)[this->index].key; }
+		const value_type &operator*()  { return *(const value_type*)((index_key_val*)this->base->kvbuf)[this->index].key; }
+	};
+
+	node_pool pool;
+
+	node_hash_map()
+		: base()
+		, pool(sizeof(key_val), alignof(key_val))
+	{
+	}
+
+	// The copied index points to the entries of `rhs`, replace them with copies
+	node_hash_map(const node_hash_map &rhs)
+		: base(rhs)
+		, pool(sizeof(key_val), alignof(key_val))
+	{
+		typename base::hash_type *const hb = base::hbuf;
+		index_key_val *const ikvb = (index_key_val*)base::kvbuf;
+		Word const cap = base::capacity;
+		for (Word i = find_used_hash_slot(hb, 0, cap); i < cap; i = find_used_hash_slot(hb, i + 1, cap)) {
+			ikvb[i].key = new (pool.alloc()) key_val(*ikvb[i].key);
+		}
+	}
+
+	node_hash_map(node_hash_map &&rhs)
+		: base(std::move(rhs))
+		, pool(std::move(rhs.pool))
+	{
+	}
+
+	~node_hash_map()
+	{
+		destroy_nodes();
+	}
+
+	node_hash_map &operator=(const node_hash_map &rhs)
+	{
+		this->~node_hash_map();
+		new (this) node_hash_map(rhs);
+		return *this;
+	}
+
+	node_hash_map &operator=(node_hash_map &&rhs)
+	{
+		this->~node_hash_map();
+		new (this) node_hash_map(std::move(rhs));
+		return *this;
+	}
+
+	// -- Fundamental operations
+
+	void destroy_nodes()
+	{
+		if (!std::is_trivially_destructible<key_val>::value) {
+			typename base::hash_type *const hb = base::hbuf;
+			index_key_val *const ikvb = (index_key_val*)base::kvbuf;
+			Word const cap = base::capacity;
+			for (Word i = find_used_hash_slot(hb, 0, cap); i < cap; i = find_used_hash_slot(hb, i + 1, cap)) {
+				ikvb[i].key->~key_val();
+			}
+		}
+	}
+
+	// Find the entry of `key` or insert an index slot for a new entry, in which
+	// case `kv` points to uninitialized storage that must be constructed.
+	template <typename K>
+	bool insert_node(const K &key, key_val *&kv)
+	{
+		index_key_val *ikv;
+		bool inserted = base::template insert_with_hash_fn<node_hash>(key_ref(key), ikv);
+		if (inserted) {
+			pool.ator = base::ator;
+			ikv->key = (key_val*)pool.alloc();
+		}
+		kv = ikv->key;
+		return inserted;
+	}
+
+	// Construct the value in place from `args`, replacing the previous value if the key exists
+	template <typename K, typename... Args>
+	bool emplace_impl(K &&key, Args&&... args)
+	{
+		key_val *kv;
+		bool inserted = insert_node(key, kv);
+		if (inserted) {
+			new (&kv->key) Key(std::forward<typename std::remove_reference<K>::type>(key));
+		} else {
+			kv->val.~Val();
+		}
+		new (&kv->val) Val(std::forward<Args>(args)...);
+		return inserted;
+	}
+
+	// Construct the value in place from `args` only if the key doesn't exist,
+	// otherwise `args` are left untouched
+	template <typename K, typename... Args>
+	bool try_emplace_impl(key_val *&kv, K &&key, Args&&... args)
+	{
+		bool inserted = insert_node(key, kv);
+		if (inserted) {
+			new (&kv->key) Key(std::forward<typename std::remove_reference<K>::type>(key));
+			new (&kv->val) Val(std::forward<Args>(args)...);
+		}
+		return inserted;
+	}
+
+	// Construct the value if the key doesn't exist, otherwise assign over the old value
+	template <typename K, typename V>
+	bool insert_or_assign_impl(K &&key, V &&value)
+	{
+		key_val *kv;
+		bool inserted = insert_node(key, kv);
+		if (inserted) {
+			new (&kv->key) Key(std::forward<typename std::remove_reference<K>::type>(key));
+			new (&kv->val) Val(std::forward<V>(value));
+		} else {
+			kv->val = std::forward<V>(value);
+		}
+		return inserted;
+	}
+
+	void erase_node(Word slot)
+	{
+		key_val *kv = ((index_key_val*)base::kvbuf)[slot].key;
+		base::erase_slot(slot);
+		kv->~key_val();
+		pool.free(kv);
+	}
+
+	bool insert(const Key  &key, const Val  &val) { return emplace_impl(          key,            val); }
+	bool insert(const Key  &key,       Val &&val) { return emplace_impl(          key,  std::move(val)); }
+	bool insert(      Key &&key, const Val  &val) { return emplace_impl(std::move(key),           val); }
+	bool insert(      Key &&key,       Val &&val) { return emplace_impl(std::move(key), std::move(val)); }
+
+	// The returned pointer stays valid until the key is erased
+	bool insert_ptr(const Key  &key, Val *&val) { key_val *kv; bool i = try_emplace_impl(kv,           key);  val = &kv->val; return i; }
+	bool insert_ptr(      Key &&key, Val *&val) { key_val *kv; bool i = try_emplace_impl(kv, std::move(key)); val = &kv->val; return i; }
+
+	template <typename... Args> bool emplace(const Key  &key, Args&&... args) { return emplace_impl(          key,  std::forward<Args>(args)...); }
+	template <typename... Args> bool emplace(      Key &&key, Args&&... args) { return emplace_impl(std::move(key), std::forward<Args>(args)...); }
+
+	template <typename... Args> bool try_emplace(const Key  &key, Args&&... args) { key_val *kv; return try_emplace_impl(kv,           key,  std::forward<Args>(args)...); }
+	template <typename... Args> bool try_emplace(      Key &&key, Args&&... args) { key_val *kv; return try_emplace_impl(kv, std::move(key), std::forward<Args>(args)...); }
+
+	bool insert_or_assign(const Key  &key, const Val  &val) { return insert_or_assign_impl(          key,            val); }
+	bool insert_or_assign(const Key  &key,       Val &&val) { return insert_or_assign_impl(          key,  std::move(val)); }
+	bool insert_or_assign(      Key &&key, const Val  &val) { return insert_or_assign_impl(std::move(key),           val); }
+	bool insert_or_assign(      Key &&key,       Val &&val) { return insert_or_assign_impl(std::move(key), std::move(val)); }
+
+	Val& operator[](const Key  &key) { key_val *kv; try_emplace_impl(kv,           key);  return kv->val; }
+	Val& operator[](      Key &&key) { key_val *kv; try_emplace_impl(kv, std::move(key)); return kv->val; }
+
+	iterator erase(const_iterator it)
+	{
+		Word const slot = it.index;
+		erase_node(slot);
+		return iterator(this, base::find_first_used_slot(slot));
+	}
+
+	bool erase(const Key &key)
+	{
+		Word slot = base::template find_slot_with_hash_fn<node_hash>(key_ref(key));
+		if (slot == base::capacity) return false;
+		erase_node(slot);
+		return true;
+	}
+
+	// Call `func(value_type&)` for every entry
+	template <typename Func>
+	void for_each(Func func)
+	{
+		auto fn = [&](index_key_val &ikv) { func(*(value_type*)ikv.key); };
+		base::for_each_impl(fn);
+	}
+
+	// Erase every entry where `pred(value_type&)` returns true, returns the number erased
+	template <typename Pred>
+	Word erase_if(Pred pred)
+	{
+		auto fn = [&](index_key_val &ikv) -> bool {
+			key_val *kv = ikv.key;
+			if (!pred(*(value_type*)kv)) return false;
+			kv->~key_val();
+			pool.free(kv);
+			return true;
+		};
+		return base::erase_if_impl(fn);
+	}
+
+	iterator find(const Key &key)
+	{
+		Word slot = base::template find_slot_with_hash_fn<node_hash>(key_ref(key));
+		return iterator(this, slot);
+	}
+
+	const_iterator find(const Key &key) const
+	{
+		Word slot = base::template find_slot_with_hash_fn<node_hash>(key_ref(key));
+		return const_iterator(this, slot);
+	}
+
+	void clear()
+	{
+		destroy_nodes();
+		base::clear();
+		pool.reset();
+	}
+
+	const_iterator begin() const { return const_iterator(this, base::find_first_used_slot()); }
+	iterator begin() { return iterator(this, base::find_first_used_slot()); }
+	const_iterator end() const { return const_iterator(this, base::capacity); }
+	iterator end() { return iterator(this, base::capacity); }
+};
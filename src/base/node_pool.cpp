@@ -0,0 +1,70 @@
+#include "node_pool.h"
+
+constexpr size_t node_pool_min_block_slots = 8;
+constexpr size_t node_pool_max_block_slots = 1024;
+
+node_pool::node_pool(size_t size, size_t align)
+	: free_list(nullptr)
+	, block_pos(nullptr)
+	, block_end(nullptr)
+	, blocks(nullptr)
+	, block_slots(0)
+	, ator(nullptr)
+{
+	// Free slots store the free list link in place
+	slot_align = at_least(align, alignof(void*));
+	slot_size = align_up(at_least(size, sizeof(void*)), slot_align);
+}
+
+node_pool::node_pool(node_pool &&rhs)
+	: free_list(rhs.free_list)
+	, block_pos(rhs.block_pos)
+	, block_end(rhs.block_end)
+	, blocks(rhs.blocks)
+	, slot_size(rhs.slot_size)
+	, slot_align(rhs.slot_align)
+	, block_slots(rhs.block_slots)
+	, ator(rhs.ator)
+{
+	rhs.free_list = nullptr;
+	rhs.block_pos = nullptr;
+	rhs.block_end = nullptr;
+	rhs.blocks = nullptr;
+	rhs.block_slots = 0;
+}
+
+node_pool::~node_pool()
+{
+	reset();
+}
+
+void node_pool::grow()
+{
+	block_slots = block_slots ? at_most(block_slots * 2, node_pool_max_block_slots) : node_pool_min_block_slots;
+
+	// Blocks are linked through a pointer in the header before the first slot
+	char *block = (char*)mem::alloc_using(ator, slot_size * block_slots, slot_align, sizeof(void*));
+	p_assert(block != nullptr);
+
+	*(void**)block = blocks;
+	blocks = block;
+
+	block_pos = block + sizeof(void*);
+	block_end = block_pos + slot_size * block_slots;
+}
+
+void node_pool::reset()
+{
+	void *block = blocks;
+	while (block) {
+		void *next = *(void**)block;
+		mem::free(block);
+		block = next;
+	}
+
+	free_list = nullptr;
+	block_pos = nullptr;
+	block_end = nullptr;
+	blocks = nullptr;
+	block_slots = 0;
+}
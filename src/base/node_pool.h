@@ -0,0 +1,57 @@
+#pragma once
+
+#include <base/base.h>
+#include <base/memory.h>
+
+// Pool of fixed size slots for node based containers
+//
+// Slots are carved linearly from blocks allocated with `mem::alloc_using()`,
+// the block size doubles up to `node_pool_max_block_slots` slots. Freed slots
+// are pushed to an intrusive free list and reused before carving new ones.
+// The blocks are only returned to the allocator in `reset()`, so the slots
+// never move and the pool can be moved by copying its fields.
+struct node_pool
+{
+	node_pool(const node_pool&) = delete;
+	node_pool &operator=(const node_pool&) = delete;
+
+	node_pool(size_t slot_size, size_t slot_align);
+	node_pool(node_pool &&rhs);
+	~node_pool();
+
+	void *alloc()
+	{
+		void *slot = free_list;
+		if (slot) {
+			free_list = *(void**)slot;
+			return slot;
+		}
+
+		if (block_pos == block_end)
+			grow();
+
+		slot = block_pos;
+		block_pos += slot_size;
+		return slot;
+	}
+
+	void free(void *slot)
+	{
+		*(void**)slot = free_list;
+		free_list = slot;
+	}
+
+	void grow();
+
+	// Free all the blocks, does not run any destructors
+	void reset();
+
+	void *free_list;
+	char *block_pos;
+	char *block_end;
+	void *blocks;
+	size_t slot_size;
+	size_t slot_align;
+	size_t block_slots;
+	mem::allocator *ator;
+};
@@ -0,0 +1,279 @@
+#pragma once
+
+#include "hash_map.h"
+
+// Hash map that iterates in insertion order
+//
+// The entries are stored densely in insertion order and the Robin Hood
+// probe table only contains the hashes and 32-bit indices to the entries.
+// Iteration is a linear walk over the entries and rehashing only moves
+// the small index table.
+//
+// Erasing keeps the order by shifting the following entries back, which
+// makes it O(n): prefer this for tables that mostly grow.
+template <typename Key, typename Val, typename Hash = default_hash<Key>>
+struct ordered_hash_map
+{
+	typedef map_key_val<Key, Val> key_val;
+	typedef map_key_val<const Key, Val> value_type;
+	typedef set_key_val<uint32_t> index_key_val;
+
+	typedef value_type *iterator;
+	typedef const value_type *const_iterator;
+
+	// Compares the lookup key against the entry pointed to by an index slot
+	struct entry_ref
+	{
+		const Key &key;
+		const key_val *entries;
+
+		entry_ref(const Key &key, const key_val *entries)
+			: key(key)
+			, entries(entries)
+		{
+		}
+
+		bool operator==(uint32_t index) const
+		{
+			return entries[index].key == key;
+		}
+	};
+
+	hash_container<index_key_val> index;
+	key_val *entries;
+	usize count;
+	usize capacity;
+	mem::allocator *ator;
+
+	ordered_hash_map()
+		: entries(nullptr)
+		, count(0)
+		, capacity(0)
+		, ator(nullptr)
+	{
+	}
+
+	ordered_hash_map(const ordered_hash_map &rhs)
+		: index(rhs.index)
+		, entries(nullptr)
+		, count(rhs.count)
+		, capacity(rhs.count)
+		, ator(rhs.ator)
+	{
+		if (count) {
+			entries = (key_val*)mem::alloc_using(ator, sizeof(key_val) * capacity, alignof(key_val));
+			if (p_trivially_copyable(key_val)) {
+				memcpy((void*)entries, (const void*)rhs.entries, sizeof(key_val) * count);
+			} else {
+				for (usize i = 0; i < count; i++) {
+					new (&entries[i]) key_val(rhs.entries[i]);
+				}
+			}
+		}
+	}
+
+	ordered_hash_map(ordered_hash_map &&rhs)
+		: index(std::move(rhs.index))
+		, entries(rhs.entries)
+		, count(rhs.count)
+		, capacity(rhs.capacity)
+		, ator(rhs.ator)
+	{
+		rhs.entries = nullptr;
+		rhs.count = 0;
+		rhs.capacity = 0;
+		rhs.ator = nullptr;
+	}
+
+	~ordered_hash_map()
+	{
+		if (!p_trivially_copyable(key_val)) {
+			for (usize i = 0; i < count; i++) {
+				entries[i].~key_val();
+			}
+		}
+		if (entries)
+			mem::free(entries);
+	}
+
+	ordered_hash_map &operator=(const ordered_hash_map &rhs)
+	{
+		this->~ordered_hash_map();
+		new (this) ordered_hash_map(rhs);
+		return *this;
+	}
+
+	ordered_hash_map &operator=(ordered_hash_map &&rhs)
+	{
+		this->~ordered_hash_map();
+		new (this) ordered_hash_map(std::move(rhs));
+		return *this;
+	}
+
+	// -- Fundamental operations
+
+	void grow_entries(usize new_capacity)
+	{
+		key_val *new_entries = (key_val*)mem::alloc_using(ator, sizeof(key_val) * new_capacity, alignof(key_val));
+		p_assert(new_entries != nullptr);
+		relocate_n(new_entries, entries, count);
+		if (entries)
+			mem::free(entries);
+		entries = new_entries;
+		capacity = new_capacity;
+	}
+
+	// Re-hash the keys of the entries with `new_seed` and rebuild the index,
+	// see `hash_container::insert_with_hash_fn()`
+	void reseed_index(uhash new_seed)
+	{
+		uhash *const hb = index.hbuf;
+		index_key_val *const ikvb = (index_key_val*)index.kvbuf;
+		usize const cap = index.capacity;
+
+		index.seed = new_seed;
+		for (usize i = 0; i < cap; i++) {
+			if (hb[i] != 0) {
+				uhash const hash = (uhash)hash_with_seed<Hash>(entries[ikvb[i].key].key, new_seed);
+				hb[i] = hash ? hash : 1;
+			}
+		}
+		index.rehash_impl(cap / 2);
+	}
+
+	// Find the index slot and returns `false` if the key was found, otherwise
+	// inserts a new slot referring to `count` and makes room for the entry.
+	template <typename K>
+	bool insert_entry(const K &key, uint32_t &entry_index)
+	{
+		index_key_val *ikv;
+		index.ator = ator;
+		usize limit = is_seeded_hash<Hash>::value ? hash_probe_limit : ~(usize)0;
+		bool inserted;
+		for (;;) {
+			inserted = index.insert_with_hash_ptr(entry_ref(key, entries), (uhash)hash_with_seed<Hash>(key, index.seed), ikv, limit);
+			if (ikv) break;
+			reseed_index(hash_random_seed());
+			limit = ~(usize)0;
+		}
+		if (inserted) {
+			if (count == capacity)
+				grow_entries(capacity ? capacity * 2 : 8);
+			ikv->key = (uint32_t)count;
+		}
+		entry_index = ikv->key;
+		return inserted;
+	}
+
+	uint32_t find_entry(const Key &key) const
+	{
+		usize slot = index.find_slot_with_hash(entry_ref(key, entries), (uhash)hash_with_seed<Hash>(key, index.seed));
+		if (slot == index.capacity) return (uint32_t)count;
+		return ((const index_key_val*)index.kvbuf)[slot].key;
+	}
+
+	void erase_entry(const Key &key)
+	{
+		usize slot = index.find_slot_with_hash(entry_ref(key, entries), (uhash)hash_with_seed<Hash>(key, index.seed));
+		p_assert(slot != index.capacity);
+		uint32_t const entry_index = ((const index_key_val*)index.kvbuf)[slot].key;
+		index.erase_slot(slot);
+
+		entries[entry_index].~key_val();
+		relocate_n(entries + entry_index, entries + entry_index + 1, count - entry_index - 1);
+		count--;
+
+		// Re-point the indices of the shifted entries
+		if (entry_index != count) {
+			uhash *const hb = index.hbuf;
+			index_key_val *const ikvb = (index_key_val*)index.kvbuf;
+			usize const cap = index.capacity;
+			for (usize i = 0; i < cap; i++) {
+				if (hb[i] != 0 && ikvb[i].key > entry_index)
+					ikvb[i].key--;
+			}
+		}
+	}
+
+	template <typename K, typename... Args>
+	bool emplace_impl(K &&key, Args&&... args)
+	{
+		uint32_t ix;
+		bool inserted = insert_entry(key, ix);
+		if (inserted) {
+			new (&entries[ix].key) Key(std::forward<typename std::remove_reference<K>::type>(key));
+			count++;
+		} else {
+			entries[ix].val.~Val();
+		}
+		new (&entries[ix].val) Val(std::forward<Args>(args)...);
+		return inserted;
+	}
+
+	template <typename K, typename... Args>
+	bool try_emplace_impl(uint32_t &ix, K &&key, Args&&... args)
+	{
+		bool inserted = insert_entry(key, ix);
+		if (inserted) {
+			new (&entries[ix].key) Key(std::forward<typename std::remove_reference<K>::type>(key));
+			new (&entries[ix].val) Val(std::forward<Args>(args)...);
+			count++;
+		}
+		return inserted;
+	}
+
+	bool insert(const Key  &key, const Val  &val) { return emplace_impl(          key,            val); }
+	bool insert(const Key  &key,       Val &&val) { return emplace_impl(          key,  std::move(val)); }
+	bool insert(      Key &&key, const Val  &val) { return emplace_impl(std::move(key),           val); }
+	bool insert(      Key &&key,       Val &&val) { return emplace_impl(std::move(key), std::move(val)); }
+
+	template <typename... Args> bool emplace(const Key  &key, Args&&... args) { return emplace_impl(          key,  std::forward<Args>(args)...); }
+	template <typename... Args> bool emplace(      Key &&key, Args&&... args) { return emplace_impl(std::move(key), std::forward<Args>(args)...); }
+
+	template <typename... Args> bool try_emplace(const Key  &key, Args&&... args) { uint32_t ix; return try_emplace_impl(ix,           key,  std::forward<Args>(args)...); }
+	template <typename... Args> bool try_emplace(      Key &&key, Args&&... args) { uint32_t ix; return try_emplace_impl(ix, std::move(key), std::forward<Args>(args)...); }
+
+	Val& operator[](const Key  &key) { uint32_t ix; try_emplace_impl(ix,           key);  return entries[ix].val; }
+	Val& operator[](      Key &&key) { uint32_t ix; try_emplace_impl(ix, std::move(key)); return entries[ix].val; }
+
+	iterator erase(const_iterator it)
+	{
+		usize const pos = it - begin();
+		erase_entry(it->key);
+		return begin() + pos;
+	}
+
+	bool erase(const Key &key)
+	{
+		if (find_entry(key) == count) return false;
+		erase_entry(key);
+		return true;
+	}
+
+	iterator find(const Key &key) { return begin() + find_entry(key); }
+	const_iterator find(const Key &key) const { return begin() + find_entry(key); }
+
+	void reserve(usize size)
+	{
+		index.ator = ator;
+		index.reserve(size);
+		if (size > capacity)
+			grow_entries(size);
+	}
+
+	void clear()
+	{
+		if (!p_trivially_copyable(key_val)) {
+			for (usize i = 0; i < count; i++) {
+				entries[i].~key_val();
+			}
+		}
+		count = 0;
+		index.clear();
+	}
+
+	const_iterator begin() const { return (const value_type*)entries; }
+	iterator begin() { return (value_type*)entries; }
+	const_iterator end() const { return (const value_type*)entries + count; }
+	iterator end() { return (value_type*)entries + count; }
+};
@@ -0,0 +1,108 @@
+#include <bench/bench.h>
+#include <base/concurrent_hash_map.h>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const uint32_t num_keys = 1 << 16;
+const uint32_t ops_per_thread = 1 << 19;
+
+// Baseline: the single-threaded map behind one global mutex
+struct locked_hash_map
+{
+	hash_map<uint32_t, uint32_t> map;
+	std::mutex mutex;
+
+	bool find(uint32_t key, uint32_t &val)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = map.find(key);
+		if (it == map.end()) return false;
+		val = it->val;
+		return true;
+	}
+
+	bool insert(uint32_t key, uint32_t val)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		return map.insert(key, val);
+	}
+};
+
+// Every thread does `ops_per_thread` operations on random keys, of which
+// `read_percent` are lookups and the rest inserts
+template <typename Map>
+uint64_t run_mixed(Map &map, uint32_t num_threads, uint32_t read_percent)
+{
+	std::vector<std::thread> threads;
+	std::atomic<uint64_t> found(0);
+
+	uint64_t begin = bench_time_ns();
+	for (uint32_t t = 0; t < num_threads; t++) {
+		threads.emplace_back([&, t]() {
+			uint32_t state = 0x9e3779b9U * (t + 1);
+			uint64_t local_found = 0;
+			for (uint32_t i = 0; i < ops_per_thread; i++) {
+				state ^= state << 13;
+				state ^= state >> 17;
+				state ^= state << 5;
+				uint32_t key = state % num_keys;
+				if (state % 100 < read_percent) {
+					uint32_t val;
+					local_found += map.find(key, val) ? 1 : 0;
+				} else {
+					map.insert(key, i);
+				}
+			}
+			found += local_found;
+		});
+	}
+
+	for (auto &thread : threads) {
+		thread.join();
+	}
+
+	bench_consume(found.load());
+	return bench_time_ns() - begin;
+}
+
+template <typename Map>
+void populate(Map &map)
+{
+	for (uint32_t i = 0; i < num_keys; i += 2) {
+		map.insert(i, i);
+	}
+}
+
+}
+
+bench_case(concurrent_hash_map_scaling)
+{
+	uint32_t max_threads = at_most(at_least(std::thread::hardware_concurrency(), 1U), 16U);
+	const uint32_t read_percents[] = { 100, 90, 50 };
+	char label[128];
+
+	for (uint32_t read_percent : read_percents) {
+		for (uint32_t threads = 1; threads <= max_threads; threads *= 2) {
+			uint64_t total_ops = (uint64_t)threads * ops_per_thread;
+
+			{
+				concurrent_hash_map<uint32_t, uint32_t> map;
+				populate(map);
+				uint64_t time = run_mixed(map, threads, read_percent);
+				snprintf(label, sizeof(label), "sharded  %3u%% read %2u threads", read_percent, threads);
+				bench_report(label, total_ops, time);
+			}
+
+			{
+				locked_hash_map map;
+				populate(map);
+				uint64_t time = run_mixed(map, threads, read_percent);
+				snprintf(label, sizeof(label), "mutex    %3u%% read %2u threads", read_percent, threads);
+				bench_report(label, total_ops, time);
+			}
+		}
+	}
+}
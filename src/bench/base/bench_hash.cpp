@@ -0,0 +1,146 @@
+#include <bench/bench.h>
+#include <base/hash_map.h>
+#include <compiler/symbol.h>
+#include <stdio.h>
+
+namespace {
+
+struct identity_hash
+{
+	uhash operator()(uint32_t i) { return i; }
+};
+
+struct multiplicative_hash
+{
+	uhash operator()(uint32_t i) { return i * 2654435761U; }
+};
+
+// Largest deviation from 0.5 of the probability that an output bit flips
+// when a single input bit is flipped
+template <typename Func>
+double avalanche_bias(Func func)
+{
+	const uint32_t num_samples = 4096;
+	static uint32_t flips[32][32];
+	memset(flips, 0, sizeof(flips));
+
+	uint64_t state = 1;
+	for (uint32_t s = 0; s < num_samples; s++) {
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		uint32_t input = (uint32_t)(state >> 32);
+		uint32_t base = func(input);
+		for (uint32_t i = 0; i < 32; i++) {
+			uint32_t diff = base ^ func(input ^ (1U << i));
+			for (uint32_t o = 0; o < 32; o++) {
+				flips[i][o] += (diff >> o) & 1;
+			}
+		}
+	}
+
+	double worst = 0.0;
+	for (uint32_t i = 0; i < 32; i++) {
+		for (uint32_t o = 0; o < 32; o++) {
+			double p = (double)flips[i][o] / (double)num_samples;
+			double bias = p > 0.5 ? p - 0.5 : 0.5 - p;
+			if (bias > worst) worst = bias;
+		}
+	}
+	return worst;
+}
+
+template <typename Hash>
+void report_probe_lengths(const char *name, const char *keys, uint32_t (*key_fn)(uint32_t))
+{
+	hash_set<uint32_t, Hash> set;
+	const uint32_t num = 1 << 16;
+	for (uint32_t i = 0; i < num; i++) {
+		set.insert(key_fn(i));
+	}
+
+	hash_stats s = set.stats();
+	printf("  %-16s %-12s mean probe %8.2f  max probe %6llu\n", name, keys, s.mean_probe, (unsigned long long)s.max_probe);
+}
+
+uint32_t sequential_key(uint32_t i) { return i; }
+uint32_t strided_key(uint32_t i) { return i << 12; }
+uint32_t random_key(uint32_t i) { return hash_int32(i ^ 0x5bd1e995U); }
+
+template <typename Hash>
+void report_all_probe_lengths(const char *name)
+{
+	report_probe_lengths<Hash>(name, "sequential", &sequential_key);
+	report_probe_lengths<Hash>(name, "strided", &strided_key);
+	report_probe_lengths<Hash>(name, "random", &random_key);
+}
+
+}
+
+bench_case(hash_quality)
+{
+	printf("  avalanche worst bias (0 is ideal, 0.5 is no mixing)\n");
+	printf("  %-16s %.3f\n", "identity", avalanche_bias([](uint32_t x) { return x; }));
+	printf("  %-16s %.3f\n", "multiplicative", avalanche_bias([](uint32_t x) { return x * 2654435761U; }));
+	printf("  %-16s %.3f\n", "symbol_hash", avalanche_bias([](uint32_t x) { return symbol_hash((const char*)&x, 4); }));
+	printf("  %-16s %.3f\n", "hash_int32", avalanche_bias([](uint32_t x) { return hash_int32(x); }));
+	printf("  %-16s %.3f\n", "hash_bytes", avalanche_bias([](uint32_t x) { return hash_bytes(&x, 4); }));
+
+	report_all_probe_lengths<identity_hash>("identity");
+	report_all_probe_lengths<multiplicative_hash>("multiplicative");
+	report_all_probe_lengths<default_hash<uint32_t>>("default_hash");
+}
+
+bench_case(hash_speed)
+{
+	const uint32_t num = 1 << 24;
+
+	{
+		bench_timer t;
+		uint32_t acc = 0;
+		for (uint32_t i = 0; i < num; i++) acc += hash_int32(i);
+		bench_consume(acc);
+		t.report("hash_int32", num);
+	}
+
+	{
+		bench_timer t;
+		uint64_t acc = 0;
+		for (uint32_t i = 0; i < num; i++) acc += hash_int64(i);
+		bench_consume(acc);
+		t.report("hash_int64", num);
+	}
+
+	static char data[4096];
+	for (uint32_t i = 0; i < sizeof(data); i++) {
+		data[i] = (char)(i * 31);
+	}
+
+	uint32_t sizes[] = { 4, 8, 16, 32, 256, 4096 };
+	for (uint32_t size : sizes) {
+		uint32_t rounds = num / (size / 4 + 4);
+		char label[64];
+
+		{
+			bench_timer t;
+			uint64_t acc = 0;
+			for (uint32_t i = 0; i < rounds; i++) {
+				data[0] = (char)i;
+				acc += hash_bytes64(data, size);
+			}
+			bench_consume(acc);
+			snprintf(label, sizeof(label), "hash_bytes %u bytes", size);
+			t.report(label, rounds);
+		}
+
+		{
+			bench_timer t;
+			uint64_t acc = 0;
+			for (uint32_t i = 0; i < rounds; i++) {
+				data[0] = (char)i;
+				acc += symbol_hash(data, size);
+			}
+			bench_consume(acc);
+			snprintf(label, sizeof(label), "symbol_hash %u bytes", size);
+			t.report(label, rounds);
+		}
+	}
+}
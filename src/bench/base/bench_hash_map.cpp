@@ -0,0 +1,196 @@
+#include <bench/bench.h>
+#include <base/hash_map.h>
+#include <base/node_hash_map.h>
+#include <stdio.h>
+
+namespace {
+
+// Key owning a heap allocation: not trivially copyable, but safe to memcpy
+template <bool Relocatable>
+struct owned_key
+{
+	uint32_t *data;
+
+	struct hash {
+		uhash operator()(const owned_key &k) {
+			return *k.data * 2654435761U;
+		}
+	};
+
+	explicit owned_key(uint32_t v)
+		: data((uint32_t*)mem::alloc(sizeof(uint32_t)))
+	{
+		*data = v;
+	}
+
+	owned_key(const owned_key &k)
+		: data((uint32_t*)mem::alloc(sizeof(uint32_t)))
+	{
+		*data = *k.data;
+	}
+
+	owned_key(owned_key &&k)
+		: data(k.data)
+	{
+		k.data = nullptr;
+	}
+
+	~owned_key()
+	{
+		mem::free(data);
+	}
+
+	bool operator==(const owned_key &k) const
+	{
+		return *data == *k.data;
+	}
+};
+
+}
+
+template <>
+struct is_trivially_relocatable<owned_key<true>> : std::true_type
+{
+};
+
+template <bool Relocatable>
+static void bench_owned_keys(const char *name, uint32_t num)
+{
+	typedef owned_key<Relocatable> key;
+	char label[128];
+
+	hash_map<key, uint32_t, typename key::hash> map;
+
+	{
+		bench_timer t;
+		for (uint32_t i = 0; i < num; i++) {
+			map.insert(key(i), i);
+		}
+		snprintf(label, sizeof(label), "%s insert (with rehash)", name);
+		t.report(label, num);
+	}
+
+	{
+		bench_timer t;
+		map.reserve(map.capacity);
+		snprintf(label, sizeof(label), "%s rehash", name);
+		t.report(label, num);
+	}
+
+	{
+		bench_timer t;
+		for (uint32_t i = 0; i < num; i += 2) {
+			map.erase(key(i));
+		}
+		snprintf(label, sizeof(label), "%s erase half", name);
+		t.report(label, num / 2);
+	}
+
+	bench_consume(map.count);
+}
+
+bench_case(hash_map_non_pod_keys)
+{
+	uint32_t num = 1000000;
+	bench_owned_keys<false>("move+dtor", num);
+	bench_owned_keys<true>("relocatable", num);
+}
+
+struct int_hash
+{
+	uhash operator()(uint32_t i) {
+		return i * 2654435761U;
+	}
+};
+
+bench_case(hash_map_sparse_iteration)
+{
+	uint32_t num = 1 << 20;
+	hash_map<uint32_t, uint32_t, int_hash> map;
+
+	for (uint32_t i = 0; i < num; i++) {
+		map.insert(i, i);
+	}
+
+	{
+		bench_timer t;
+		map.erase_if([](map_key_val<const uint32_t, uint32_t> &kv) { return kv.key % 64 != 0; });
+		t.report("erase_if 63/64", num);
+	}
+
+	uint32_t rounds = 100;
+
+	{
+		bench_timer t;
+		uint64_t sum = 0;
+		for (uint32_t r = 0; r < rounds; r++) {
+			for (auto &pair : map) {
+				sum += pair.val;
+			}
+		}
+		bench_consume(sum);
+		t.report("iterator (per slot)", (uint64_t)map.capacity * rounds);
+	}
+
+	{
+		bench_timer t;
+		uint64_t sum = 0;
+		for (uint32_t r = 0; r < rounds; r++) {
+			map.for_each([&](map_key_val<const uint32_t, uint32_t> &kv) { sum += kv.val; });
+		}
+		bench_consume(sum);
+		t.report("for_each (per slot)", (uint64_t)map.capacity * rounds);
+	}
+}
+
+struct large_value
+{
+	uint32_t data[64];
+};
+
+template <typename Map>
+static void bench_large_values(const char *name, uint32_t num)
+{
+	char label[128];
+	Map map;
+	large_value value;
+	memset(&value, 0, sizeof(value));
+
+	{
+		bench_timer t;
+		for (uint32_t i = 0; i < num; i++) {
+			value.data[0] = i;
+			map.insert(i, value);
+		}
+		snprintf(label, sizeof(label), "%s insert 256 byte values", name);
+		t.report(label, num);
+	}
+
+	{
+		bench_timer t;
+		for (uint32_t i = 0; i < num; i += 2) {
+			map.erase(i);
+		}
+		snprintf(label, sizeof(label), "%s erase half", name);
+		t.report(label, num / 2);
+	}
+
+	{
+		bench_timer t;
+		uint32_t sum = 0;
+		for (uint32_t i = 0; i < num; i++) {
+			auto it = map.find(i);
+			if (it != map.end()) sum += it->val.data[0];
+		}
+		snprintf(label, sizeof(label), "%s find", name);
+		t.report(label, num);
+		bench_consume(sum);
+	}
+}
+
+bench_case(hash_map_large_values)
+{
+	uint32_t num = 200000;
+	bench_large_values<hash_map<uint32_t, large_value, int_hash>>("hash_map", num);
+	bench_large_values<node_hash_map<uint32_t, large_value, int_hash>>("node_hash_map", num);
+}
@@ -0,0 +1,122 @@
+#include <bench/bench.h>
+#include <base/flat_map.h>
+#include <base/btree_map.h>
+#include <stdio.h>
+#include <map>
+
+namespace {
+
+// Thin wrapper to give `std::map` the same interface as the maps here
+struct std_map
+{
+	std::map<uint32_t, uint32_t> map;
+
+	void insert(uint32_t key, uint32_t val) { map[key] = val; }
+
+	bool find(uint32_t key, uint32_t &val)
+	{
+		auto it = map.find(key);
+		if (it == map.end()) return false;
+		val = it->second;
+		return true;
+	}
+
+	uint64_t scan(uint32_t begin, uint32_t num)
+	{
+		uint64_t sum = 0;
+		auto it = map.lower_bound(begin);
+		for (uint32_t i = 0; i < num && it != map.end(); i++, ++it)
+			sum += it->second;
+		return sum;
+	}
+};
+
+template <typename Map>
+struct wrap_map
+{
+	Map map;
+
+	void insert(uint32_t key, uint32_t val) { map.insert(key, val); }
+
+	bool find(uint32_t key, uint32_t &val)
+	{
+		auto it = map.find(key);
+		if (it == map.end()) return false;
+		val = it->val;
+		return true;
+	}
+
+	uint64_t scan(uint32_t begin, uint32_t num)
+	{
+		uint64_t sum = 0;
+		auto it = map.lower_bound(begin);
+		for (uint32_t i = 0; i < num && it != map.end(); i++, ++it)
+			sum += it->val;
+		return sum;
+	}
+};
+
+uint32_t scramble(uint32_t i)
+{
+	return i * 2654435761U;
+}
+
+}
+
+template <typename Map>
+static void bench_sorted(const char *name, uint32_t num, bool in_order)
+{
+	char label[128];
+	Map map;
+
+	{
+		bench_timer t;
+		for (uint32_t i = 0; i < num; i++) {
+			uint32_t key = in_order ? i : scramble(i) % num;
+			map.insert(key, i);
+		}
+		snprintf(label, sizeof(label), "%s insert %s", name, in_order ? "in order" : "random");
+		t.report(label, num);
+	}
+
+	{
+		bench_timer t;
+		uint64_t sum = 0;
+		for (uint32_t i = 0; i < num; i++) {
+			uint32_t val;
+			if (map.find(scramble(i + 1) % (num * 2), val))
+				sum += val;
+		}
+		bench_consume(sum);
+		snprintf(label, sizeof(label), "%s find random (50%% hit)", name);
+		t.report(label, num);
+	}
+
+	{
+		uint32_t scans = num / 64, length = 64;
+		bench_timer t;
+		uint64_t sum = 0;
+		for (uint32_t i = 0; i < scans; i++) {
+			sum += map.scan(scramble(i) % num, length);
+		}
+		bench_consume(sum);
+		snprintf(label, sizeof(label), "%s range scan (per entry)", name);
+		t.report(label, (uint64_t)scans * length);
+	}
+}
+
+bench_case(sorted_map_random)
+{
+	uint32_t num = 100000;
+	bench_sorted<std_map>("std::map", num, false);
+	bench_sorted<wrap_map<btree_map<uint32_t, uint32_t>>>("btree_map", num, false);
+	bench_sorted<wrap_map<flat_map<uint32_t, uint32_t>>>("flat_map", num, false);
+}
+
+bench_case(sorted_map_in_order)
+{
+	uint32_t num = 1000000;
+	bench_sorted<std_map>("std::map", num, true);
+	bench_sorted<wrap_map<btree_map<uint32_t, uint32_t>>>("btree_map", num, true);
+	bench_sorted<wrap_map<flat_map<uint32_t, uint32_t>>>("flat_map", num, true);
+}
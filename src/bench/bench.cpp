@@ -0,0 +1,50 @@
+#include "bench.h"
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+
+bench_case_struct g_benches[256];
+uint32_t g_num_benches = 0;
+
+volatile uint64_t g_bench_sink;
+
+bench_case_struct::bench_case_struct(const char *name, void (*func)())
+	: name(name)
+	, func(func)
+{
+}
+
+int add_bench(const bench_case_struct &s)
+{
+	g_benches[g_num_benches++] = s;
+	return g_num_benches;
+}
+
+uint64_t bench_time_ns()
+{
+	auto now = std::chrono::steady_clock::now().time_since_epoch();
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+void bench_report(const char *label, uint64_t num_ops, uint64_t time_ns)
+{
+	double per_op = num_ops ? (double)time_ns / (double)num_ops : 0.0;
+	printf("  %-40s %10.2f ns/op %10.2f ms\n", label, per_op, (double)time_ns * 1e-6);
+}
+
+void bench_consume(uint64_t value)
+{
+	g_bench_sink = g_bench_sink + value;
+}
+
+void run_benches(const char *filter)
+{
+	for (uint32_t i = 0; i < g_num_benches; i++) {
+		auto &bench = g_benches[i];
+		if (filter && !strstr(bench.name, filter))
+			continue;
+
+		printf("%s\n", bench.name);
+		bench.func();
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <base/base.h>
+
+struct bench_case_struct
+{
+	const char *name;
+	void (*func)();
+
+	bench_case_struct() { }
+	bench_case_struct(const char *name, void (*func)());
+};
+
+int add_bench(const bench_case_struct &s);
+
+#define bench_case(name) \
+	void bench_##name(); \
+	int dummy_bench_##name = add_bench(bench_case_struct(#name, bench_##name)); \
+	void bench_##name()
+
+// Monotonic time in nanoseconds
+uint64_t bench_time_ns();
+
+// Print the time per operation of a measured loop
+void bench_report(const char *label, uint64_t num_ops, uint64_t time_ns);
+
+// Keep the optimizer from removing the computation of `value`
+void bench_consume(uint64_t value);
+
+struct bench_timer
+{
+	uint64_t begin;
+
+	bench_timer() : begin(bench_time_ns()) { }
+
+	void report(const char *label, uint64_t num_ops)
+	{
+		bench_report(label, num_ops, bench_time_ns() - begin);
+	}
+};
+
+// Run the benchmarks whose name contains `filter`, or all if it's null
+void run_benches(const char *filter);
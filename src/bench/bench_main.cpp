@@ -0,0 +1,7 @@
+#include "bench.h"
+
+int main(int argc, char **argv)
+{
+	run_benches(argc > 1 ? argv[1] : nullptr);
+	return 0;
+}
@@ -0,0 +1,123 @@
+#include <bench/bench.h>
+#include <compiler/ast.h>
+#include <stdio.h>
+
+namespace {
+
+// Conventional pointer-based node for comparison
+struct pointer_node
+{
+	ast_kind kind;
+	uint32_t token;
+	symbol sym;
+	pointer_node *lhs;
+	pointer_node *rhs;
+};
+
+const uint32_t num_leaves = 1 << 20;
+const uint32_t leaves_per_tree = 64;
+
+uint32_t g_state = 0x2545f491U;
+
+uint32_t rnd()
+{
+	g_state ^= g_state << 13;
+	g_state ^= g_state >> 17;
+	g_state ^= g_state << 5;
+	return g_state;
+}
+
+// Build a random binary expression tree of `n` leaves in both representations
+ast_ref build_tree(ast &tree, linear_allocator &arena, pointer_node *&pnode, uint32_t n)
+{
+	if (n == 1) {
+		uint32_t sym = rnd() % 1000 + 1;
+		pnode = (pointer_node*)arena.alloc(sizeof(pointer_node), alignof(pointer_node));
+		*pnode = pointer_node{ ast_kind::identifier, 0, symbol{ sym }, nullptr, nullptr };
+		return tree.add(ast_kind::identifier, 0, sym, 0);
+	}
+
+	uint32_t left = 1 + rnd() % (n - 1);
+	pointer_node *pl, *pr;
+	ast_ref l = build_tree(tree, arena, pl, left);
+	ast_ref r = build_tree(tree, arena, pr, n - left);
+	pnode = (pointer_node*)arena.alloc(sizeof(pointer_node), alignof(pointer_node));
+	*pnode = pointer_node{ ast_kind::binary, 0, symbol{ 0 }, pl, pr };
+	return tree.add(ast_kind::binary, 0, l, r);
+}
+
+uint64_t walk_index(const ast &tree, ast_ref ref)
+{
+	if (tree.kind(ref) == ast_kind::identifier)
+		return tree.data[ref.index].lhs;
+	return walk_index(tree, tree.lhs(ref)) + walk_index(tree, tree.rhs(ref));
+}
+
+uint64_t walk_pointer(const pointer_node *node)
+{
+	if (node->kind == ast_kind::identifier)
+		return node->sym.index;
+	return walk_pointer(node->lhs) + walk_pointer(node->rhs);
+}
+
+}
+
+bench_case(ast_walk)
+{
+	const uint32_t rounds = 10;
+	const uint32_t num_trees = num_leaves / leaves_per_tree;
+
+	linear_allocator index_arena;
+	linear_allocator pointer_arena;
+	ast tree(&index_arena);
+
+	ast_ref *roots = (ast_ref*)mem::alloc(sizeof(ast_ref) * num_trees);
+	pointer_node **proots = (pointer_node**)mem::alloc(sizeof(pointer_node*) * num_trees);
+	for (uint32_t i = 0; i < num_trees; i++)
+		roots[i] = build_tree(tree, pointer_arena, proots[i], leaves_per_tree);
+
+	size_t index_bytes = (size_t)tree.count * (sizeof(uint8_t) + sizeof(uint32_t) + sizeof(ast_data))
+		+ (size_t)tree.extra_count * sizeof(uint32_t);
+	size_t pointer_bytes = (size_t)(tree.count - 1) * sizeof(pointer_node);
+	printf("  %-40s %10.2f MB\n", "index nodes", (double)index_bytes * 1e-6);
+	printf("  %-40s %10.2f MB\n", "pointer nodes", (double)pointer_bytes * 1e-6);
+
+	{
+		bench_timer t;
+		for (uint32_t r = 0; r < rounds; r++) {
+			uint64_t sum = 0;
+			for (uint32_t i = 0; i < num_trees; i++)
+				sum += walk_index(tree, roots[i]);
+			bench_consume(sum);
+		}
+		t.report("recursive walk, index nodes", (uint64_t)tree.count * rounds);
+	}
+
+	{
+		bench_timer t;
+		for (uint32_t r = 0; r < rounds; r++) {
+			uint64_t sum = 0;
+			for (uint32_t i = 0; i < num_trees; i++)
+				sum += walk_pointer(proots[i]);
+			bench_consume(sum);
+		}
+		t.report("recursive walk, pointer nodes", (uint64_t)tree.count * rounds);
+	}
+
+	// Passes that don't care about the structure scan the dense kinds
+	{
+		bench_timer t;
+		for (uint32_t r = 0; r < rounds; r++) {
+			uint64_t sum = 0;
+			for (uint32_t i = 0; i < tree.count; i++) {
+				if (tree.kinds[i] == (uint8_t)ast_kind::identifier)
+					sum += tree.data[i].lhs;
+			}
+			bench_consume(sum);
+		}
+		t.report("linear kinds scan, index nodes", (uint64_t)tree.count * rounds);
+	}
+
+	mem::free(roots);
+	mem::free(proots);
+}
@@ -0,0 +1,244 @@
+#include <bench/bench.h>
+#include <compiler/lexer.h>
+#include <compiler/token_buffer.h>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+const uint32_t num_idents = 4096;
+
+// Pseudo-random C-ish source: functions with declarations, expressions,
+// calls, literals and comments over a pool of identifiers
+std::string make_corpus(uint32_t target_size)
+{
+	std::string idents[num_idents];
+	char buf[64];
+	for (uint32_t i = 0; i < num_idents; i++) {
+		const char *prefixes[] = { "x", "count", "node_", "buffer_index_", "get_symbol_string_for_" };
+		snprintf(buf, sizeof(buf), "%s%u", prefixes[i % 5], i * 2654435761U % 100000);
+		idents[i] = buf;
+	}
+
+	const char *types[] = { "int", "float", "char", "bool", "double" };
+	const char *ops[] = { " + ", " - ", " * ", " / ", " << ", " & ", " == ", " != ", " && ", " || " };
+
+	uint32_t state = 0x12345678U;
+	auto rnd = [&](uint32_t n) {
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return state % n;
+	};
+
+	std::string src;
+	src.reserve(target_size + 4096);
+	while (src.size() < target_size) {
+		src += "// Function doing some work\nstatic ";
+		src += types[rnd(5)];
+		src += " ";
+		src += idents[rnd(num_idents)];
+		src += "(const char *";
+		src += idents[rnd(num_idents)];
+		src += ", int ";
+		src += idents[rnd(num_idents)];
+		src += ")\n{\n";
+
+		uint32_t statements = 4 + rnd(12);
+		for (uint32_t s = 0; s < statements; s++) {
+			src += "\t";
+			switch (rnd(5)) {
+			case 0:
+				src += types[rnd(5)];
+				src += " ";
+				src += idents[rnd(num_idents)];
+				src += " = ";
+				src += std::to_string(rnd(100000));
+				src += ";\n";
+				break;
+			case 1:
+				src += "if (";
+				src += idents[rnd(num_idents)];
+				src += ops[rnd(10)];
+				src += idents[rnd(num_idents)];
+				src += ") {\n\t\t";
+				src += idents[rnd(num_idents)];
+				src += " += 1.5f;\n\t}\n";
+				break;
+			case 2:
+				src += idents[rnd(num_idents)];
+				src += "(\"string literal\", ";
+				src += idents[rnd(num_idents)];
+				src += "[";
+				src += std::to_string(rnd(64));
+				src += "]);\n";
+				break;
+			case 3:
+				src += "/* Block comment explaining\n\t * the next statement */\n\t";
+				src += idents[rnd(num_idents)];
+				src += "->";
+				src += idents[rnd(num_idents)];
+				src += " = 0x";
+				src += std::to_string(rnd(0xffff));
+				src += ";\n";
+				break;
+			default:
+				src += "return ";
+				src += idents[rnd(num_idents)];
+				src += ops[rnd(10)];
+				src += idents[rnd(num_idents)];
+				src += ";\n";
+				break;
+			}
+		}
+		src += "}\n\n";
+	}
+	return src;
+}
+
+uint64_t lex_file(const source_file *file, symbol_cahce *cache, uint64_t &num_tokens)
+{
+	lexer lex(file, cache);
+	uint64_t sum = 0;
+	uint64_t count = 0;
+	for (;;) {
+		token t = lex.next();
+		if (t.kind == token_kind::end)
+			break;
+		sum += t.sym.index + (uint32_t)t.kind;
+		count++;
+	}
+	num_tokens = count;
+	return sum;
+}
+
+void report_throughput(const char *label, uint64_t num_tokens, uint64_t num_bytes, uint64_t time_ns)
+{
+	bench_report(label, num_tokens, time_ns);
+	double seconds = (double)time_ns * 1e-9;
+	printf("  %-40s %10.2f Mtok/s %8.2f MB/s\n", "", (double)num_tokens / seconds * 1e-6,
+		(double)num_bytes / seconds * 1e-6);
+}
+
+}
+
+bench_case(lexer_tokens)
+{
+	const uint32_t rounds = 5;
+	std::string corpus = make_corpus(16 << 20);
+	source_manager sources;
+	source_file *file = sources.add_memory("corpus", corpus.data(), (uint32_t)corpus.size());
+
+	// Warm up and intern all the identifiers once
+	uint64_t num_tokens = 0;
+	bench_consume(lex_file(file, nullptr, num_tokens));
+
+	{
+		uint64_t begin = bench_time_ns();
+		for (uint32_t r = 0; r < rounds; r++)
+			bench_consume(lex_file(file, nullptr, num_tokens));
+		report_throughput("lex, intern_symbol()", num_tokens * rounds, corpus.size() * rounds, bench_time_ns() - begin);
+	}
+
+	{
+		symbol_cahce cache(12);
+		uint64_t begin = bench_time_ns();
+		for (uint32_t r = 0; r < rounds; r++)
+			bench_consume(lex_file(file, &cache, num_tokens));
+		report_throughput("lex, symbol_cahce", num_tokens * rounds, corpus.size() * rounds, bench_time_ns() - begin);
+	}
+
+	// What the fused hash saves: hashing every identifier again after lexing
+	{
+		uint64_t begin = bench_time_ns();
+		for (uint32_t r = 0; r < rounds; r++) {
+			lexer lex(file);
+			uint64_t sum = 0;
+			for (;;) {
+				token t = lex.next();
+				if (t.kind == token_kind::end)
+					break;
+				if (t.kind == token_kind::identifier)
+					sum += symbol_hash(file->data + t.offset, t.length);
+			}
+			bench_consume(sum);
+		}
+		report_throughput("lex + symbol_hash() per identifier", num_tokens * rounds, corpus.size() * rounds, bench_time_ns() - begin);
+	}
+}
+
+bench_case(lexer_token_buffer)
+{
+	const uint32_t rounds = 5;
+	std::string corpus = make_corpus(16 << 20);
+	source_manager sources;
+	source_file *file = sources.add_memory("corpus", corpus.data(), (uint32_t)corpus.size());
+	uint64_t num_tokens = 0;
+	bench_consume(lex_file(file, nullptr, num_tokens));
+
+	linear_allocator arena;
+	{
+		uint64_t begin = bench_time_ns();
+		for (uint32_t r = 0; r < rounds; r++) {
+			arena.reset();
+			token_buffer tokens(&arena);
+			lexer lex(file);
+			tokens.lex_all(lex);
+			bench_consume(tokens.count);
+		}
+		report_throughput("lex to token_buffer", num_tokens * rounds, corpus.size() * rounds, bench_time_ns() - begin);
+	}
+
+	{
+		uint64_t begin = bench_time_ns();
+		for (uint32_t r = 0; r < rounds; r++) {
+			std::vector<token> tokens;
+			lexer lex(file);
+			for (;;) {
+				token t = lex.next();
+				tokens.push_back(t);
+				if (t.kind == token_kind::end)
+					break;
+			}
+			bench_consume(tokens.size());
+		}
+		report_throughput("lex to std::vector<token>", num_tokens * rounds, corpus.size() * rounds, bench_time_ns() - begin);
+	}
+
+	// Parser-like pass that mostly looks at the kinds
+	arena.reset();
+	token_buffer tokens(&arena);
+	lexer lex(file);
+	tokens.lex_all(lex);
+
+	std::vector<token> aos;
+	for (uint32_t i = 0; i < tokens.count; i++)
+		aos.push_back(tokens.get(i));
+
+	{
+		uint64_t begin = bench_time_ns();
+		for (uint32_t r = 0; r < rounds; r++) {
+			uint64_t sum = 0;
+			for (uint32_t i = 0; i < tokens.count; i++) {
+				if (tokens.kinds[i] == (uint8_t)token_kind::identifier)
+					sum += tokens.values[i];
+			}
+			bench_consume(sum);
+		}
+		bench_report("scan token_buffer kinds", (uint64_t)tokens.count * rounds, bench_time_ns() - begin);
+	}
+
+	{
+		uint64_t begin = bench_time_ns();
+		for (uint32_t r = 0; r < rounds; r++) {
+			uint64_t sum = 0;
+			for (const token &t : aos) {
+				if (t.kind == token_kind::identifier)
+					sum += t.sym.index;
+			}
+			bench_consume(sum);
+		}
+		bench_report("scan std::vector<token>", (uint64_t)aos.size() * rounds, bench_time_ns() - begin);
+	}
+}
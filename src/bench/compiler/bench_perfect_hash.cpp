@@ -0,0 +1,96 @@
+#include <bench/bench.h>
+#include <base/hash_map.h>
+#include <compiler/perfect_hash.h>
+#include <stdlib.h>
+
+namespace {
+
+constexpr const char *keywords[] = {
+	"auto", "break", "case", "char", "const", "continue", "default", "do",
+	"double", "else", "enum", "extern", "float", "for", "goto", "if",
+	"inline", "int", "long", "register", "restrict", "return", "short", "signed",
+	"sizeof", "static", "struct", "switch", "typedef", "union", "unsigned", "void",
+	"volatile", "while", "bool", "true", "false", "nullptr", "template", "typename",
+};
+
+constexpr auto keyword_set = make_perfect_hash_set(keywords);
+
+struct token
+{
+	const char *str;
+	uint32_t length;
+	uint32_t hash;
+
+	struct hash_fn {
+		uhash operator()(const token &t) {
+			return t.hash;
+		}
+	};
+
+	bool operator==(const token &t) const
+	{
+		return length == t.length && memcmp(str, t.str, length) == 0;
+	}
+};
+
+}
+
+bench_case(perfect_hash_keywords)
+{
+	const uint32_t num_keywords = sizeof(keywords) / sizeof(*keywords);
+	const uint32_t num_idents = 256;
+	const uint32_t num_tokens = 1 << 20;
+	const uint32_t rounds = 20;
+
+	static char ident_data[num_idents][12];
+	for (uint32_t i = 0; i < num_idents; i++) {
+		uint32_t len = 2 + (uint32_t)rand() % 9;
+		for (uint32_t j = 0; j < len; j++)
+			ident_data[i][j] = "abcdefghijklmnopqrstuvwxyz_"[rand() % 27];
+		ident_data[i][len] = '\0';
+	}
+
+	// Keyword-heavy stream: roughly half of the tokens are keywords
+	token *tokens = (token*)mem::alloc(sizeof(token) * num_tokens);
+	for (uint32_t i = 0; i < num_tokens; i++) {
+		const char *str = rand() % 2 ? keywords[rand() % num_keywords] : ident_data[rand() % num_idents];
+		tokens[i].str = str;
+		tokens[i].length = (uint32_t)strlen(str);
+		tokens[i].hash = symbol_hash(str, tokens[i].length);
+	}
+
+	hash_set<token, token::hash_fn> set;
+	for (uint32_t i = 0; i < num_keywords; i++) {
+		token t;
+		t.str = keywords[i];
+		t.length = (uint32_t)strlen(keywords[i]);
+		t.hash = symbol_hash(t.str, t.length);
+		set.insert(t);
+	}
+
+	{
+		bench_timer t;
+		uint64_t found = 0;
+		for (uint32_t r = 0; r < rounds; r++) {
+			for (uint32_t i = 0; i < num_tokens; i++) {
+				found += set.find(tokens[i]) != set.end();
+			}
+		}
+		bench_consume(found);
+		t.report("hash_set", (uint64_t)num_tokens * rounds);
+	}
+
+	{
+		bench_timer t;
+		uint64_t found = 0;
+		for (uint32_t r = 0; r < rounds; r++) {
+			for (uint32_t i = 0; i < num_tokens; i++) {
+				found += keyword_set.contains(tokens[i].str, tokens[i].length, tokens[i].hash);
+			}
+		}
+		bench_consume(found);
+		t.report("perfect_hash_set", (uint64_t)num_tokens * rounds);
+	}
+
+	mem::free(tokens);
+}
@@ -0,0 +1,189 @@
+#include <bench/bench.h>
+#include <compiler/symbol.h>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const uint32_t num_shared = 1 << 14;
+const uint32_t ops_per_thread = 1 << 18;
+
+struct ident
+{
+	char data[24];
+	uint32_t length;
+	uint32_t hash;
+};
+
+// Identifiers shared by all the threads, like names from common headers
+std::vector<ident> make_idents(const char *prefix, uint32_t num)
+{
+	std::vector<ident> idents(num);
+	for (uint32_t i = 0; i < num; i++) {
+		ident &id = idents[i];
+		id.length = (uint32_t)snprintf(id.data, sizeof(id.data), "%s%u", prefix, i * 2654435761U);
+		id.hash = symbol_hash(id.data, id.length);
+	}
+	return idents;
+}
+
+// Every thread interns `ops_per_thread` identifiers of which `new_percent`
+// are unique to the thread and the rest are picked from `shared`
+uint64_t run_interning(const std::vector<ident> &shared, uint32_t num_threads, uint32_t new_percent, uint32_t round)
+{
+	std::vector<std::thread> threads;
+	std::vector<std::vector<ident>> own(num_threads);
+	char prefix[32];
+
+	for (uint32_t t = 0; t < num_threads; t++) {
+		snprintf(prefix, sizeof(prefix), "own_%u_%u_%u_", round, num_threads, t);
+		own[t] = make_idents(prefix, ops_per_thread * new_percent / 100 + 1);
+	}
+
+	uint64_t begin = bench_time_ns();
+	for (uint32_t t = 0; t < num_threads; t++) {
+		threads.emplace_back([&, t]() {
+			uint32_t state = 0x9e3779b9U * (t + 1);
+			uint32_t own_pos = 0;
+			uint64_t sum = 0;
+			for (uint32_t i = 0; i < ops_per_thread; i++) {
+				state ^= state << 13;
+				state ^= state >> 17;
+				state ^= state << 5;
+				const ident &id = state % 100 < new_percent ? own[t][own_pos++ % own[t].size()] : shared[state % num_shared];
+				sum += intern_symbol(id.data, id.length, id.hash).index;
+			}
+			bench_consume(sum);
+		});
+	}
+
+	for (auto &thread : threads) {
+		thread.join();
+	}
+
+	return bench_time_ns() - begin;
+}
+
+}
+
+bench_case(symbol_intern_scaling)
+{
+	uint32_t max_threads = at_most(at_least(std::thread::hardware_concurrency(), 1U), 16U);
+	const uint32_t new_percents[] = { 0, 10, 50 };
+	std::vector<ident> shared = make_idents("shared_", num_shared);
+	char label[128];
+	uint32_t round = 0;
+
+	for (const ident &id : shared) {
+		intern_symbol(id.data, id.length, id.hash);
+	}
+
+	for (uint32_t new_percent : new_percents) {
+		for (uint32_t threads = 1; threads <= max_threads; threads *= 2) {
+			uint64_t time = run_interning(shared, threads, new_percent, round++);
+			snprintf(label, sizeof(label), "intern %2u%% new %2u threads", new_percent, threads);
+			bench_report(label, (uint64_t)threads * ops_per_thread, time);
+		}
+	}
+}
+
+bench_case(symbol_cache)
+{
+	// Identifier stream where a few names repeat a lot, like in source files
+	std::vector<ident> idents = make_idents("cache_", 4096);
+	const uint32_t num = 1 << 20;
+	std::vector<uint32_t> order(num);
+	uint32_t state = 0x9e3779b9U;
+	for (uint32_t i = 0; i < num; i++) {
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		order[i] = (state & 0xff) * (state >> 8 & 0xf) % 4096;
+	}
+
+	for (const ident &id : idents) {
+		intern_symbol(id.data, id.length, id.hash);
+	}
+
+	{
+		bench_timer t;
+		uint64_t sum = 0;
+		for (uint32_t i = 0; i < num; i++) {
+			const ident &id = idents[order[i]];
+			sum += intern_symbol(id.data, id.length, id.hash).index;
+		}
+		bench_consume(sum);
+		t.report("intern_symbol", num);
+	}
+
+	const uint32_t set_bits[] = { 4, 7, 9, 11 };
+	char label[128];
+	for (uint32_t bits : set_bits) {
+		symbol_cahce cache(bits);
+		bench_timer t;
+		uint64_t sum = 0;
+		for (uint32_t i = 0; i < num; i++) {
+			const ident &id = idents[order[i]];
+			sum += cache.intern(id.data, id.length, id.hash).index;
+		}
+		bench_consume(sum);
+		snprintf(label, sizeof(label), "symbol_cahce %4u sets (%.1f%% hits)", 1U << bits, cache.hit_rate() * 100.0);
+		t.report(label, num);
+	}
+}
+
+// Cache misses queued and interned in sorted batches against interning each
+// miss immediately, with threads adding new symbols at the same time
+bench_case(symbol_deferred)
+{
+	uint32_t max_threads = at_most(at_least(std::thread::hardware_concurrency(), 1U), 16U);
+	const uint32_t batch_size = 4096;
+	const uint32_t num = 1 << 17;
+	char label[128];
+
+	for (uint32_t threads = 1; threads <= max_threads; threads *= 2) {
+		for (uint32_t deferred = 0; deferred < 2; deferred++) {
+			std::vector<std::vector<ident>> own(threads);
+			for (uint32_t t = 0; t < threads; t++) {
+				snprintf(label, sizeof(label), "deferred_%u_%u_%u_", deferred, threads, t);
+				own[t] = make_idents(label, num / 4);
+			}
+
+			std::vector<std::thread> workers;
+			uint64_t begin = bench_time_ns();
+			for (uint32_t t = 0; t < threads; t++) {
+				workers.emplace_back([&, t]() {
+					symbol_cahce cache;
+					std::vector<symbol> syms(num);
+					uint32_t state = 0x9e3779b9U * (t + 1);
+					uint64_t sum = 0;
+					for (uint32_t i = 0; i < num; i++) {
+						state ^= state << 13;
+						state ^= state >> 17;
+						state ^= state << 5;
+						const ident &id = own[t][state % own[t].size()];
+						if (deferred) {
+							cache.intern_deferred(&syms[i], id.data, id.length, id.hash);
+							if (cache.deferred_symbols.count == batch_size)
+								cache.resolve_deferred();
+						} else {
+							syms[i] = cache.intern(id.data, id.length, id.hash);
+						}
+					}
+					cache.resolve_deferred();
+					for (symbol sym : syms)
+						sum += sym.index;
+					bench_consume(sum);
+				});
+			}
+
+			for (auto &worker : workers) {
+				worker.join();
+			}
+
+			snprintf(label, sizeof(label), "%s %2u threads", deferred ? "deferred " : "immediate", threads);
+			bench_report(label, (uint64_t)threads * num, bench_time_ns() - begin);
+		}
+	}
+}
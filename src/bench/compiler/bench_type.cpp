@@ -0,0 +1,60 @@
+#include <bench/bench.h>
+#include <compiler/type.h>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const uint32_t num_types = 256;
+const uint32_t ops_per_thread = 1 << 20;
+
+// Type checking looks up the same few types over and over, eg. pointers to
+// the types of the variables in scope
+template <typename Intern>
+uint64_t run_lookups(type_table &types, uint32_t num_threads, Intern intern)
+{
+	std::vector<std::thread> threads;
+	uint64_t begin = bench_time_ns();
+	for (uint32_t t = 0; t < num_threads; t++) {
+		threads.emplace_back([&, t]() {
+			type_cache cache(&types);
+			uint32_t state = 0x9e3779b9U * (t + 1);
+			uint64_t sum = 0;
+			for (uint32_t i = 0; i < ops_per_thread; i++) {
+				state ^= state << 13;
+				state ^= state >> 17;
+				state ^= state << 5;
+				type_desc desc = make_array_type(basic_type(type_kind::int_type), state % num_types);
+				sum += intern(types, cache, desc).index;
+			}
+			bench_consume(sum);
+		});
+	}
+	for (auto &thread : threads)
+		thread.join();
+	return bench_time_ns() - begin;
+}
+
+}
+
+bench_case(type_intern)
+{
+	uint32_t max_threads = at_most(at_least(std::thread::hardware_concurrency(), 1U), 16U);
+	type_table types(mem::get_standard_allocator());
+	char label[128];
+
+	for (uint32_t threads = 1; threads <= max_threads; threads *= 2) {
+		uint64_t time = run_lookups(types, threads, [](type_table &table, type_cache &, const type_desc &desc) {
+			return table.intern(desc);
+		});
+		snprintf(label, sizeof(label), "type_table, %u threads", threads);
+		bench_report(label, (uint64_t)ops_per_thread * threads, time);
+
+		time = run_lookups(types, threads, [](type_table &, type_cache &cache, const type_desc &desc) {
+			return cache.intern(desc);
+		});
+		snprintf(label, sizeof(label), "type_cache, %u threads", threads);
+		bench_report(label, (uint64_t)ops_per_thread * threads, time);
+	}
+}
@@ -0,0 +1,98 @@
+#include "ast.h"
+
+namespace {
+
+const char *const ast_kind_names[] = {
+	"none",
+	"identifier", "integer_literal", "float_literal", "string_literal", "char_literal",
+	"unary", "binary", "call", "member", "index",
+	"type_name", "pointer_type",
+	"block", "expr_stmt", "if_stmt", "while_stmt", "for_stmt", "return_stmt",
+	"var_decl", "func_decl", "struct_decl", "file",
+};
+
+static_assert(sizeof(ast_kind_names) / sizeof(*ast_kind_names) == (size_t)ast_kind::count,
+	"Every node kind needs a name");
+
+constexpr uint32_t initial_node_capacity = 256;
+
+}
+
+ast::ast(linear_allocator *arena)
+	: kinds(nullptr)
+	, tokens(nullptr)
+	, data(nullptr)
+	, count(0)
+	, capacity(0)
+	, extra(nullptr)
+	, extra_count(0)
+	, extra_capacity(0)
+	, arena(arena)
+{
+	p_assert(arena != nullptr);
+	reserve(initial_node_capacity, initial_node_capacity);
+	add(ast_kind::none, 0, 0, 0);
+}
+
+void ast::reserve(uint32_t num_nodes, uint32_t num_extra)
+{
+	if (num_nodes > capacity) {
+		uint32_t new_capacity = at_least(num_nodes, capacity * 2);
+		kinds = arena->realloc_array(kinds, count, new_capacity);
+		tokens = arena->realloc_array(tokens, count, new_capacity);
+		data = arena->realloc_array(data, count, new_capacity);
+		capacity = new_capacity;
+	}
+
+	if (num_extra > extra_capacity) {
+		uint32_t new_capacity = at_least(num_extra, extra_capacity * 2);
+		extra = arena->realloc_array(extra, extra_count, new_capacity);
+		extra_capacity = new_capacity;
+	}
+}
+
+ast_ref ast::add(ast_kind kind, uint32_t token, uint32_t lhs, uint32_t rhs)
+{
+	if (count == capacity)
+		reserve(count + 1, 0);
+
+	uint32_t const index = count++;
+	kinds[index] = (uint8_t)kind;
+	tokens[index] = token;
+	data[index].lhs = lhs;
+	data[index].rhs = rhs;
+	return ast_ref{ index };
+}
+
+uint32_t ast::add_extra(const uint32_t *values, uint32_t num)
+{
+	if (extra_count + num > extra_capacity)
+		reserve(0, extra_count + num);
+
+	uint32_t const index = extra_count;
+	if (num > 0)
+		memcpy(extra + index, values, sizeof(uint32_t) * num);
+	extra_count += num;
+	return index;
+}
+
+uint32_t ast::add_list(const ast_ref *nodes, uint32_t num)
+{
+	if (extra_count + num + 1 > extra_capacity)
+		reserve(0, extra_count + num + 1);
+
+	uint32_t const index = extra_count;
+	extra[index] = num;
+	for (uint32_t i = 0; i < num; i++) {
+		p_assert(nodes[i].index < count);
+		extra[index + 1 + i] = nodes[i].index;
+	}
+	extra_count += num + 1;
+	return index;
+}
+
+const char *ast_kind_name(ast_kind kind)
+{
+	p_assert(kind < ast_kind::count);
+	return ast_kind_names[(uint32_t)kind];
+}
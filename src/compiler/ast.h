@@ -0,0 +1,227 @@
+#pragma once
+
+#include <base/base.h>
+#include <base/linear_allocator.h>
+#include "symbol.h"
+
+enum class ast_kind : uint8_t
+{
+	none,
+
+	// Expressions, the operator is the kind of the main token
+	identifier,       // lhs: symbol
+	integer_literal,
+	float_literal,
+	string_literal,
+	char_literal,
+	unary,            // lhs: operand
+	binary,           // lhs, rhs: operands
+	call,             // lhs: callee, rhs: list of arguments
+	member,           // lhs: object, rhs: symbol
+	index,            // lhs: object, rhs: index
+
+	// Types
+	type_name,        // lhs: symbol
+	pointer_type,     // lhs: pointee
+
+	// Statements
+	block,            // lhs: list of statements
+	expr_stmt,        // lhs: expression
+	if_stmt,          // lhs: condition, rhs: extra [then, else]
+	while_stmt,       // lhs: condition, rhs: body
+	for_stmt,         // lhs: extra [init, condition, step], rhs: body
+	return_stmt,      // lhs: value
+
+	// Declarations, the main token is the name
+	var_decl,         // lhs: type, rhs: initializer
+	func_decl,        // lhs: extra [return type, parameter list], rhs: body
+	struct_decl,      // lhs: list of fields
+	file,             // lhs: list of declarations
+
+	count,
+};
+
+// Reference to a node of an `ast`, index 0 is the null node
+struct ast_ref
+{
+	uint32_t index;
+
+	bool operator==(const ast_ref &rhs) const { return index == rhs.index; }
+	bool operator!=(const ast_ref &rhs) const { return index != rhs.index; }
+	explicit operator bool() const { return index != 0; }
+};
+
+// Two operands of a node, interpreted according to its kind: a child node,
+// a symbol index or an index to `ast::extra`
+struct ast_data
+{
+	uint32_t lhs;
+	uint32_t rhs;
+};
+
+// Syntax tree of a file stored as parallel arrays indexed by `ast_ref`
+//
+// Node `i` has the kind `kinds[i]`, the index of its main token in the
+// `token_buffer` of the file in `tokens[i]` and two 32-bit operands in
+// `data[i]`. Nodes with more children store them in `extra`: a list is
+// the count followed by the node indices, fixed children are consecutive
+// values. A node is 13 bytes plus its extra values, compared to pointer
+// based nodes this is roughly half the memory.
+//
+// The arrays are bump-allocated from `arena` which holds the tree of one
+// file and is released with `arena->reset()`.
+//
+// Children must be added before their parents, so iterating the nodes in
+// index order is a post-order walk of the tree over sequential memory, and
+// dispatching on `kinds` only touches one byte per node.
+struct ast
+{
+	uint8_t *kinds;
+	uint32_t *tokens;
+	ast_data *data;
+	uint32_t count;
+	uint32_t capacity;
+
+	uint32_t *extra;
+	uint32_t extra_count;
+	uint32_t extra_capacity;
+
+	linear_allocator *arena;
+
+	ast(const ast&) = delete;
+	ast &operator=(const ast&) = delete;
+
+	// Adds the null node
+	explicit ast(linear_allocator *arena);
+
+	void reserve(uint32_t num_nodes, uint32_t num_extra);
+
+	ast_ref add(ast_kind kind, uint32_t token, uint32_t lhs, uint32_t rhs);
+
+	ast_ref add(ast_kind kind, uint32_t token, ast_ref lhs, ast_ref rhs = ast_ref{ 0 })
+	{
+		return add(kind, token, lhs.index, rhs.index);
+	}
+
+	// Append `num` values to `extra` and return the index of the first one
+	uint32_t add_extra(const uint32_t *values, uint32_t num);
+
+	// Append a list of `num` nodes to `extra` and return its index
+	uint32_t add_list(const ast_ref *nodes, uint32_t num);
+
+	ast_kind kind(ast_ref ref) const
+	{
+		p_assert(ref.index < count);
+		return (ast_kind)kinds[ref.index];
+	}
+
+	ast_ref lhs(ast_ref ref) const
+	{
+		p_assert(ref.index < count);
+		return ast_ref{ data[ref.index].lhs };
+	}
+
+	ast_ref rhs(ast_ref ref) const
+	{
+		p_assert(ref.index < count);
+		return ast_ref{ data[ref.index].rhs };
+	}
+
+	// Symbol stored in an operand, eg. the name of an `identifier`
+	symbol lhs_symbol(ast_ref ref) const
+	{
+		p_assert(ref.index < count);
+		return symbol{ data[ref.index].lhs };
+	}
+
+	symbol rhs_symbol(ast_ref ref) const
+	{
+		p_assert(ref.index < count);
+		return symbol{ data[ref.index].rhs };
+	}
+
+	uint32_t list_count(uint32_t list) const
+	{
+		p_assert(list < extra_count);
+		return extra[list];
+	}
+
+	ast_ref list_item(uint32_t list, uint32_t i) const
+	{
+		p_assert(i < list_count(list));
+		return ast_ref{ extra[list + 1 + i] };
+	}
+
+	ast_ref extra_node(uint32_t index) const
+	{
+		p_assert(index < extra_count);
+		return ast_ref{ extra[index] };
+	}
+
+	// Call `f(ast_ref child)` for the child nodes of `ref` in source order,
+	// null children are skipped
+	template <typename F>
+	void for_each_child(ast_ref ref, F f) const;
+};
+
+const char *ast_kind_name(ast_kind kind);
+
+template <typename F>
+void ast::for_each_child(ast_ref ref, F f) const
+{
+	ast_data const d = data[ref.index];
+
+	auto node = [&](uint32_t index) {
+		if (index != 0)
+			f(ast_ref{ index });
+	};
+	auto list = [&](uint32_t first) {
+		uint32_t const num = extra[first];
+		for (uint32_t i = 0; i < num; i++)
+			node(extra[first + 1 + i]);
+	};
+
+	switch (kind(ref)) {
+	case ast_kind::unary:
+	case ast_kind::member:
+	case ast_kind::pointer_type:
+	case ast_kind::expr_stmt:
+	case ast_kind::return_stmt:
+		node(d.lhs);
+		break;
+	case ast_kind::binary:
+	case ast_kind::index:
+	case ast_kind::while_stmt:
+	case ast_kind::var_decl:
+		node(d.lhs);
+		node(d.rhs);
+		break;
+	case ast_kind::call:
+		node(d.lhs);
+		list(d.rhs);
+		break;
+	case ast_kind::block:
+	case ast_kind::struct_decl:
+	case ast_kind::file:
+		list(d.lhs);
+		break;
+	case ast_kind::if_stmt:
+		node(d.lhs);
+		node(extra[d.rhs + 0]);
+		node(extra[d.rhs + 1]);
+		break;
+	case ast_kind::for_stmt:
+		node(extra[d.lhs + 0]);
+		node(extra[d.lhs + 1]);
+		node(extra[d.lhs + 2]);
+		node(d.rhs);
+		break;
+	case ast_kind::func_decl:
+		node(extra[d.lhs]);
+		list(extra[d.lhs + 1]);
+		node(d.rhs);
+		break;
+	default:
+		break;
+	}
+}
@@ -0,0 +1,75 @@
+#include "constant.h"
+#include <base/hash.h>
+
+uint32_t constant_value::hash() const
+{
+	uint64_t h = hash_int64((uint64_t)kind << 56 ^ (uint64_t)type.index << 24 ^ length);
+	h = hash_int64(h ^ bits);
+	if (kind == constant_kind::string && length > 0)
+		h ^= hash_bytes64(data, length);
+	return (uint32_t)(h ^ h >> 32);
+}
+
+bool constant_value::operator==(const constant_value &rhs) const
+{
+	if (kind != rhs.kind || type != rhs.type || length != rhs.length || bits != rhs.bits)
+		return false;
+	if (kind == constant_kind::string && length > 0)
+		return memcmp(data, rhs.data, length) == 0;
+	return true;
+}
+
+constant_value constant_value::copy_to(linear_allocator &arena) const
+{
+	constant_value copy = *this;
+	if (kind == constant_kind::string) {
+		char *new_data = (char*)arena.alloc(length + 1, 1);
+		if (length > 0)
+			memcpy(new_data, data, length);
+		new_data[length] = '\0';
+		copy.data = new_data;
+	} else {
+		copy.data = nullptr;
+	}
+	return copy;
+}
+
+double constant_value::as_double() const
+{
+	p_assert(kind == constant_kind::floating);
+	double value;
+	memcpy(&value, &bits, sizeof(double));
+	return value;
+}
+
+constant_value make_integer_constant(type_id type, uint64_t value)
+{
+	constant_value c = { constant_kind::integer, type, 0, value, nullptr };
+	return c;
+}
+
+constant_value make_float_constant(type_id type, double value)
+{
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(double));
+	constant_value c = { constant_kind::floating, type, 0, bits, nullptr };
+	return c;
+}
+
+constant_value make_bool_constant(type_id type, bool value)
+{
+	constant_value c = { constant_kind::boolean, type, 0, value ? 1U : 0U, nullptr };
+	return c;
+}
+
+constant_value make_string_constant(type_id type, const char *data, uint32_t length)
+{
+	constant_value c = { constant_kind::string, type, length, 0, data };
+	return c;
+}
+
+constant_value make_null_constant(type_id type)
+{
+	constant_value c = { constant_kind::null, type, 0, 0, nullptr };
+	return c;
+}
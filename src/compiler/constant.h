@@ -0,0 +1,52 @@
+#pragma once
+
+#include <base/base.h>
+#include "type.h"
+#include "intern_table.h"
+
+enum class constant_kind : uint8_t
+{
+	none,
+	integer,
+	floating,
+	boolean,
+	string,
+	null,
+};
+
+// Interned constant value: equal constants of the same type have the same id.
+// Id 0 is no constant.
+struct constant_id
+{
+	uint32_t index;
+
+	bool operator==(const constant_id &rhs) const { return index == rhs.index; }
+	bool operator!=(const constant_id &rhs) const { return index != rhs.index; }
+};
+
+// Value of a constant: integers and booleans are stored in `bits`, floating
+// point values as their bit pattern so that eg. `0.0` and `-0.0` are different
+// constants. Strings are `length` bytes at `data`, null-terminated once interned.
+struct constant_value
+{
+	constant_kind kind;
+	type_id type;
+	uint32_t length;
+	uint64_t bits;
+	const char *data;
+
+	uint32_t hash() const;
+	bool operator==(const constant_value &rhs) const;
+	constant_value copy_to(linear_allocator &arena) const;
+
+	double as_double() const;
+};
+
+constant_value make_integer_constant(type_id type, uint64_t value);
+constant_value make_float_constant(type_id type, double value);
+constant_value make_bool_constant(type_id type, bool value);
+constant_value make_string_constant(type_id type, const char *data, uint32_t length);
+constant_value make_null_constant(type_id type);
+
+typedef intern_table<constant_value, constant_id> constant_table;
+typedef intern_cache<constant_value, constant_id> constant_cache;
@@ -0,0 +1,258 @@
+#pragma once
+
+#include <base/base.h>
+#include <base/hash_map.h>
+#include <base/linear_allocator.h>
+#include <atomic>
+#include <mutex>
+
+// Hash-consing table: equal descriptors are interned to the same 32-bit id so
+// they can be compared as integers, like `symbol` does for strings.
+//
+// `Desc` is a trivially copyable value type with:
+//
+//     uint32_t hash() const;                        // Hash of the contents
+//     bool operator==(const Desc &rhs) const;       // Structural equality
+//     Desc copy_to(linear_allocator &arena) const;  // Copy referenced arrays to `arena`
+//
+// The set stores only `(hash, index)` entries and is searched with a lookup
+// key pointing to the caller's descriptor, so nothing is copied unless the
+// descriptor is new. Descriptors are stored in pages of `intern_page_size`
+// that are never moved or freed, so `get()` doesn't need to lock. Interning
+// takes `mutex`, threads should go through an `intern_cache` to avoid
+// contention. Id 0 is a value-initialized `Desc` used as the null id,
+// interning an equal descriptor returns it.
+constexpr uint32_t intern_page_bits = 10;
+constexpr uint32_t intern_page_size = 1U << intern_page_bits;
+constexpr uint32_t intern_index_bits = 24;
+constexpr uint32_t intern_max_pages = 1U << (intern_index_bits - intern_page_bits);
+
+template <typename Desc, typename Id>
+struct intern_table
+{
+	static_assert(p_trivially_copyable(Desc), "Descriptors are copied to pages");
+
+	struct entry
+	{
+		uint32_t hash;
+		uint32_t index;
+
+		bool operator==(const entry &rhs) const { return index == rhs.index; }
+	};
+
+	struct lookup
+	{
+		const Desc *desc;
+		const intern_table *table;
+		uint32_t hash;
+
+		bool operator==(const entry &e) const
+		{
+			return e.hash == hash && table->get(e.index) == *desc;
+		}
+	};
+
+	struct entry_hash
+	{
+		uint64_t operator()(const entry &e) const { return e.hash; }
+		uint64_t operator()(const lookup &l) const { return l.hash; }
+	};
+
+	std::atomic<Desc*> *pages;
+	std::atomic<uint32_t> count;
+	hash_set<entry, entry_hash> set;
+	linear_allocator arena;
+	std::mutex mutex;
+	mem::allocator *ator;
+
+	intern_table(const intern_table&) = delete;
+	intern_table &operator=(const intern_table&) = delete;
+
+	explicit intern_table(mem::allocator *ator = nullptr)
+		: count(0)
+		, set(64, ator)
+		, ator(ator)
+	{
+		size_t const size = sizeof(std::atomic<Desc*>) * intern_max_pages;
+		pages = (std::atomic<Desc*>*)mem::alloc_using(ator, size, 64);
+		p_assert(pages != nullptr);
+		for (uint32_t i = 0; i < intern_max_pages; i++)
+			new (&pages[i]) std::atomic<Desc*>(nullptr);
+
+		// The null id is in the set so that interning an equal descriptor returns it
+		arena.ator = ator;
+		Desc const null_desc = Desc();
+		entry const null_entry = { null_desc.hash(), create(null_desc) };
+		set.insert(null_entry);
+	}
+
+	~intern_table()
+	{
+		for (uint32_t i = 0; i < intern_max_pages; i++) {
+			Desc *page = pages[i].load(std::memory_order_relaxed);
+			if (!page)
+				break;
+			mem::free(page);
+		}
+		mem::free(pages);
+	}
+
+	const Desc &get(uint32_t index) const
+	{
+		p_assert(index < count.load(std::memory_order_relaxed));
+		Desc *page = pages[index >> intern_page_bits].load(std::memory_order_acquire);
+		return page[index & (intern_page_size - 1)];
+	}
+
+	const Desc &get(Id id) const
+	{
+		return get(id.index);
+	}
+
+	// Thread-safe, takes `mutex`
+	Id intern(const Desc &desc, uint32_t hash)
+	{
+		p_debug_assert(hash == desc.hash());
+
+		lookup const key = { &desc, this, hash };
+		const entry *e;
+
+		std::lock_guard<std::mutex> lock(mutex);
+		set.insert_as(key, [&]() {
+			entry const created = { hash, create(desc) };
+			return created;
+		}, e);
+		return Id{ e->index };
+	}
+
+	Id intern(const Desc &desc)
+	{
+		return intern(desc, desc.hash());
+	}
+
+	// Number of allocated ids including the null id
+	uint32_t size() const
+	{
+		return count.load(std::memory_order_acquire);
+	}
+
+	// Store a copy of `desc` at the next index, must hold `mutex`
+	uint32_t create(const Desc &desc)
+	{
+		uint32_t const index = count.load(std::memory_order_relaxed);
+		p_assert(index < intern_max_pages * intern_page_size);
+
+		std::atomic<Desc*> &page_ref = pages[index >> intern_page_bits];
+		Desc *page = page_ref.load(std::memory_order_relaxed);
+		if (!page) {
+			page = (Desc*)mem::alloc_using(ator, sizeof(Desc) * intern_page_size, 64);
+			p_assert(page != nullptr);
+			page_ref.store(page, std::memory_order_release);
+		}
+
+		page[index & (intern_page_size - 1)] = desc.copy_to(arena);
+		count.store(index + 1, std::memory_order_release);
+		return index;
+	}
+};
+
+// Per-thread front cache for an `intern_table`
+//
+// Works like `symbol_cahce`: a 2-way set associative cache of `(hash, id)`
+// pairs indexed by the low bits of the hash. Hits compare against the
+// descriptor already in the table without taking its lock. A cache must only
+// be used by one thread at a time.
+constexpr uint32_t intern_cache_default_set_bits = 8;
+
+template <typename Desc, typename Id>
+struct intern_cache
+{
+	typedef intern_table<Desc, Id> table_type;
+
+	struct entry
+	{
+		uint32_t hash;
+		uint32_t index;
+	};
+
+	// `2 << set_bits` entries, index 0 marks an empty entry
+	table_type *table;
+	entry *entries;
+	uint32_t set_mask;
+	uint64_t hits;
+	uint64_t misses;
+
+	intern_cache(const intern_cache&) = delete;
+	intern_cache &operator=(const intern_cache&) = delete;
+
+	explicit intern_cache(table_type *table, uint32_t set_bits = intern_cache_default_set_bits)
+		: table(table)
+		, set_mask((1U << set_bits) - 1)
+		, hits(0)
+		, misses(0)
+	{
+		size_t const size = sizeof(entry) * 2 << set_bits;
+		entries = (entry*)mem::alloc(size, 64);
+		p_assert(entries != nullptr);
+		memset(entries, 0, size);
+	}
+
+	~intern_cache()
+	{
+		mem::free(entries);
+	}
+
+	bool matches(entry e, const Desc &desc, uint32_t hash) const
+	{
+		return e.hash == hash && e.index != 0 && table->get(e.index) == desc;
+	}
+
+	Id intern(const Desc &desc, uint32_t hash)
+	{
+		p_debug_assert(hash == desc.hash());
+
+		entry *set = entries + (hash & set_mask) * 2;
+		if (matches(set[0], desc, hash)) {
+			hits++;
+			return Id{ set[0].index };
+		}
+		if (matches(set[1], desc, hash)) {
+			hits++;
+			entry const first = set[0];
+			set[0] = set[1];
+			set[1] = first;
+			return Id{ set[0].index };
+		}
+
+		misses++;
+		Id const id = table->intern(desc, hash);
+		if (id.index != 0) {
+			set[1] = set[0];
+			set[0].hash = hash;
+			set[0].index = id.index;
+		}
+		return id;
+	}
+
+	Id intern(const Desc &desc)
+	{
+		return intern(desc, desc.hash());
+	}
+
+	const Desc &get(Id id) const
+	{
+		return table->get(id);
+	}
+
+	double hit_rate() const
+	{
+		uint64_t const total = hits + misses;
+		return total ? (double)hits / (double)total : 0.0;
+	}
+
+	void reset_stats()
+	{
+		hits = 0;
+		misses = 0;
+	}
+};
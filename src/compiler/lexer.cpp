@@ -0,0 +1,424 @@
+#include "lexer.h"
+#include "perfect_hash.h"
+#include <base/bit_math.h>
+
+#if p_sse2
+	#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr perfect_hash_entry<token_kind> keyword_entries[] = {
+	{ "if", token_kind::kw_if },
+	{ "else", token_kind::kw_else },
+	{ "while", token_kind::kw_while },
+	{ "for", token_kind::kw_for },
+	{ "do", token_kind::kw_do },
+	{ "switch", token_kind::kw_switch },
+	{ "case", token_kind::kw_case },
+	{ "default", token_kind::kw_default },
+	{ "break", token_kind::kw_break },
+	{ "continue", token_kind::kw_continue },
+	{ "return", token_kind::kw_return },
+	{ "goto", token_kind::kw_goto },
+	{ "struct", token_kind::kw_struct },
+	{ "union", token_kind::kw_union },
+	{ "enum", token_kind::kw_enum },
+	{ "typedef", token_kind::kw_typedef },
+	{ "const", token_kind::kw_const },
+	{ "static", token_kind::kw_static },
+	{ "extern", token_kind::kw_extern },
+	{ "inline", token_kind::kw_inline },
+	{ "sizeof", token_kind::kw_sizeof },
+	{ "void", token_kind::kw_void },
+	{ "bool", token_kind::kw_bool },
+	{ "char", token_kind::kw_char },
+	{ "int", token_kind::kw_int },
+	{ "float", token_kind::kw_float },
+	{ "double", token_kind::kw_double },
+	{ "true", token_kind::kw_true },
+	{ "false", token_kind::kw_false },
+	{ "null", token_kind::kw_null },
+};
+
+constexpr auto keyword_map = make_perfect_hash_map(keyword_entries);
+
+const char *const token_kind_names[] = {
+	"end", "error",
+	"identifier", "integer", "floating", "string", "character",
+
+	"if", "else", "while", "for", "do", "switch", "case", "default",
+	"break", "continue", "return", "goto", "struct", "union", "enum", "typedef",
+	"const", "static", "extern", "inline", "sizeof", "void", "bool", "char",
+	"int", "float", "double", "true", "false", "null",
+
+	"(", ")", "{", "}", "[", "]", ";", ",", ".", "...", ":", "?", "~", "!",
+	"+", "-", "*", "/", "%", "&", "|", "^", "<", ">", "=",
+	"++", "--", "->", "&&", "||", "<<", ">>", "==", "!=", "<=", ">=",
+	"+=", "-=", "*=", "/=", "%=", "&=", "|=", "^=", "<<=", ">>=",
+};
+
+static_assert(sizeof(token_kind_names) / sizeof(*token_kind_names) == (size_t)token_kind::count,
+	"Every token kind needs a name");
+
+inline bool is_ident_start(char c)
+{
+	return (uint32_t)((c | 0x20) - 'a') < 26 || c == '_';
+}
+
+inline bool is_digit(char c)
+{
+	return (uint32_t)(c - '0') < 10;
+}
+
+inline bool is_ident(char c)
+{
+	return is_ident_start(c) || is_digit(c);
+}
+
+inline bool is_space(char c)
+{
+	return c == ' ' || (uint32_t)(c - '\t') < 5;
+}
+
+#if p_sse2
+
+// Bitmask of the bytes of `v` in the range `[lo, hi]`, both must be ASCII
+inline __m128i in_range(__m128i v, char lo, char hi)
+{
+	__m128i ge = _mm_cmpgt_epi8(v, _mm_set1_epi8((char)(lo - 1)));
+	__m128i le = _mm_cmplt_epi8(v, _mm_set1_epi8((char)(hi + 1)));
+	return _mm_and_si128(ge, le);
+}
+
+inline uint32_t ident_mask(const char *p)
+{
+	__m128i v = _mm_loadu_si128((const __m128i*)p);
+	__m128i alpha = in_range(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z');
+	__m128i digit = in_range(v, '0', '9');
+	__m128i under = _mm_cmpeq_epi8(v, _mm_set1_epi8('_'));
+	return (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(alpha, digit), under));
+}
+
+inline uint32_t space_mask(const char *p)
+{
+	__m128i v = _mm_loadu_si128((const __m128i*)p);
+	__m128i space = _mm_cmpeq_epi8(v, _mm_set1_epi8(' '));
+	__m128i control = in_range(v, '\t', '\r');
+	return (uint32_t)_mm_movemask_epi8(_mm_or_si128(space, control));
+}
+
+// Bitmask of the bytes equal to `a`, `b` or zero
+inline uint32_t stop_mask(const char *p, char a, char b)
+{
+	__m128i v = _mm_loadu_si128((const __m128i*)p);
+	__m128i ma = _mm_cmpeq_epi8(v, _mm_set1_epi8(a));
+	__m128i mb = _mm_cmpeq_epi8(v, _mm_set1_epi8(b));
+	__m128i mz = _mm_cmpeq_epi8(v, _mm_setzero_si128());
+	return (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(ma, mb), mz));
+}
+
+// Number of consecutive set bits from the bottom of a 16-bit `mask`
+inline uint32_t leading_run(uint32_t mask)
+{
+	return find_lsb(~mask | 0x10000);
+}
+
+#endif
+
+// Find the end of the identifier starting at `p` and its `symbol_hash()`
+inline const char *scan_identifier(const char *p, uint32_t &hash)
+{
+	uint32_t h = symbol_hash_init();
+
+#if p_sse2
+	for (;;) {
+		uint32_t run = leading_run(ident_mask(p));
+		for (uint32_t i = 0; i < run; i++)
+			h = symbol_hash_feed(h, (unsigned char)p[i]);
+		p += run;
+		if (run < 16)
+			break;
+	}
+#else
+	while (is_ident(*p)) {
+		h = symbol_hash_feed(h, (unsigned char)*p);
+		p++;
+	}
+#endif
+
+	hash = h;
+	return p;
+}
+
+inline const char *skip_space(const char *p)
+{
+#if p_sse2
+	// Most runs are a single space between tokens
+	if (!is_space(*p))
+		return p;
+	for (;;) {
+		uint32_t run = leading_run(space_mask(p));
+		p += run;
+		if (run < 16)
+			return p;
+	}
+#else
+	while (is_space(*p))
+		p++;
+	return p;
+#endif
+}
+
+// Returns a pointer to the first `a`, `b` or zero byte at or after `p`
+inline const char *find_stop(const char *p, char a, char b)
+{
+#if p_sse2
+	for (;;) {
+		uint32_t mask = stop_mask(p, a, b);
+		if (mask)
+			return p + find_lsb(mask);
+		p += 16;
+	}
+#else
+	while (*p != a && *p != b && *p != 0)
+		p++;
+	return p;
+#endif
+}
+
+inline const char *skip_digits(const char *p)
+{
+	while (is_digit(*p))
+		p++;
+	return p;
+}
+
+}
+
+lexer::lexer(const char *data, uint32_t size, symbol_cahce *cache)
+	: data(data)
+	, size(size)
+	, pos(0)
+	, cache(cache)
+{
+}
+
+lexer::lexer(const source_file *file, symbol_cahce *cache)
+	: lexer(file->data, file->size, cache)
+{
+}
+
+uint32_t lexer::skip_space_and_comments(bool &error)
+{
+	const char *end = data + size;
+	const char *p = data + pos;
+	error = false;
+
+	for (;;) {
+		p = skip_space(p);
+		if (p[0] != '/')
+			break;
+
+		if (p[1] == '/') {
+			p = find_stop(p + 2, '\n', '\n');
+			while (*p == 0 && p < end)
+				p = find_stop(p + 1, '\n', '\n');
+			if (p >= end)
+				return size;
+		} else if (p[1] == '*') {
+			const char *q = p + 2;
+			for (;;) {
+				q = find_stop(q, '*', '*');
+				if (q >= end) {
+					error = true;
+					return (uint32_t)(p - data);
+				}
+				if (q[0] == '*' && q[1] == '/')
+					break;
+				q++;
+			}
+			p = q + 2;
+		} else {
+			break;
+		}
+	}
+
+	return p < end ? (uint32_t)(p - data) : size;
+}
+
+token lexer::next()
+{
+	bool comment_error;
+	uint32_t const offset = skip_space_and_comments(comment_error);
+
+	token t;
+	t.offset = offset;
+	t.sym = symbol{ 0 };
+
+	if (comment_error) {
+		t.kind = token_kind::error;
+		t.length = size - offset;
+		pos = size;
+		return t;
+	}
+
+	if (offset >= size) {
+		t.kind = token_kind::end;
+		t.length = 0;
+		pos = size;
+		return t;
+	}
+
+	const char *const end = data + size;
+	const char *const begin = data + offset;
+	const char *p = begin;
+	token_kind kind = token_kind::error;
+	char const c = *p;
+
+	if (is_ident_start(c)) {
+		uint32_t hash;
+		p = scan_identifier(p, hash);
+		uint32_t const length = (uint32_t)(p - begin);
+
+		const token_kind *keyword = keyword_map.find(begin, length, hash);
+		if (keyword) {
+			kind = *keyword;
+		} else {
+			kind = token_kind::identifier;
+			t.sym = intern(begin, length, hash);
+		}
+	} else if (is_digit(c) || (c == '.' && is_digit(p[1]))) {
+		kind = token_kind::integer;
+		if (c == '0' && (p[1] | 0x20) == 'x') {
+			p += 2;
+		} else {
+			p = skip_digits(p);
+			if (*p == '.') {
+				kind = token_kind::floating;
+				p = skip_digits(p + 1);
+			}
+			if ((*p | 0x20) == 'e' && (is_digit(p[1]) || ((p[1] == '+' || p[1] == '-') && is_digit(p[2])))) {
+				kind = token_kind::floating;
+				p = skip_digits(p + 2);
+			}
+		}
+		// Hex digits and suffixes such as `u` or `f`
+		while (is_ident(*p))
+			p++;
+	} else if (c == '"' || c == '\'') {
+		p++;
+		for (;;) {
+			p = find_stop(p, c, '\\');
+			if (p >= end) {
+				p = end;
+				break;
+			}
+			if (*p == c) {
+				p++;
+				kind = c == '"' ? token_kind::string : token_kind::character;
+				break;
+			}
+			if (*p == '\\' && p + 1 < end)
+				p++;
+			p++;
+		}
+	} else {
+		char const c1 = p[1];
+		char const c2 = p[2];
+		p++;
+
+		switch (c) {
+		case '(': kind = token_kind::l_paren; break;
+		case ')': kind = token_kind::r_paren; break;
+		case '{': kind = token_kind::l_brace; break;
+		case '}': kind = token_kind::r_brace; break;
+		case '[': kind = token_kind::l_bracket; break;
+		case ']': kind = token_kind::r_bracket; break;
+		case ';': kind = token_kind::semicolon; break;
+		case ',': kind = token_kind::comma; break;
+		case ':': kind = token_kind::colon; break;
+		case '?': kind = token_kind::question; break;
+		case '~': kind = token_kind::tilde; break;
+		case '.':
+			if (c1 == '.' && c2 == '.') { kind = token_kind::ellipsis; p += 2; }
+			else kind = token_kind::dot;
+			break;
+		case '!':
+			if (c1 == '=') { kind = token_kind::ne; p++; }
+			else kind = token_kind::bang;
+			break;
+		case '=':
+			if (c1 == '=') { kind = token_kind::eq; p++; }
+			else kind = token_kind::assign;
+			break;
+		case '+':
+			if (c1 == '+') { kind = token_kind::plus_plus; p++; }
+			else if (c1 == '=') { kind = token_kind::plus_assign; p++; }
+			else kind = token_kind::plus;
+			break;
+		case '-':
+			if (c1 == '-') { kind = token_kind::minus_minus; p++; }
+			else if (c1 == '=') { kind = token_kind::minus_assign; p++; }
+			else if (c1 == '>') { kind = token_kind::arrow; p++; }
+			else kind = token_kind::minus;
+			break;
+		case '*':
+			if (c1 == '=') { kind = token_kind::star_assign; p++; }
+			else kind = token_kind::star;
+			break;
+		case '/':
+			if (c1 == '=') { kind = token_kind::slash_assign; p++; }
+			else kind = token_kind::slash;
+			break;
+		case '%':
+			if (c1 == '=') { kind = token_kind::percent_assign; p++; }
+			else kind = token_kind::percent;
+			break;
+		case '^':
+			if (c1 == '=') { kind = token_kind::caret_assign; p++; }
+			else kind = token_kind::caret;
+			break;
+		case '&':
+			if (c1 == '&') { kind = token_kind::amp_amp; p++; }
+			else if (c1 == '=') { kind = token_kind::amp_assign; p++; }
+			else kind = token_kind::amp;
+			break;
+		case '|':
+			if (c1 == '|') { kind = token_kind::pipe_pipe; p++; }
+			else if (c1 == '=') { kind = token_kind::pipe_assign; p++; }
+			else kind = token_kind::pipe;
+			break;
+		case '<':
+			if (c1 == '<' && c2 == '=') { kind = token_kind::shl_assign; p += 2; }
+			else if (c1 == '<') { kind = token_kind::shl; p++; }
+			else if (c1 == '=') { kind = token_kind::le; p++; }
+			else kind = token_kind::less;
+			break;
+		case '>':
+			if (c1 == '>' && c2 == '=') { kind = token_kind::shr_assign; p += 2; }
+			else if (c1 == '>') { kind = token_kind::shr; p++; }
+			else if (c1 == '=') { kind = token_kind::ge; p++; }
+			else kind = token_kind::greater;
+			break;
+		default:
+			kind = token_kind::error;
+			break;
+		}
+	}
+
+	// Lookahead may have stepped into the padding
+	if (p > end)
+		p = end;
+
+	t.kind = kind;
+	t.length = (uint32_t)(p - begin);
+	pos = (uint32_t)(p - data);
+	return t;
+}
+
+const char *token_kind_name(token_kind kind)
+{
+	p_assert(kind < token_kind::count);
+	return token_kind_names[(uint32_t)kind];
+}
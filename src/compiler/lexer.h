@@ -0,0 +1,149 @@
+#pragma once
+
+#include <base/base.h>
+#include "symbol.h"
+#include "source.h"
+
+enum class token_kind : uint8_t
+{
+	end,
+	error,
+
+	identifier,
+	integer,
+	floating,
+	string,
+	character,
+
+	// Keywords
+	kw_if,
+	kw_else,
+	kw_while,
+	kw_for,
+	kw_do,
+	kw_switch,
+	kw_case,
+	kw_default,
+	kw_break,
+	kw_continue,
+	kw_return,
+	kw_goto,
+	kw_struct,
+	kw_union,
+	kw_enum,
+	kw_typedef,
+	kw_const,
+	kw_static,
+	kw_extern,
+	kw_inline,
+	kw_sizeof,
+	kw_void,
+	kw_bool,
+	kw_char,
+	kw_int,
+	kw_float,
+	kw_double,
+	kw_true,
+	kw_false,
+	kw_null,
+
+	// Punctuators
+	l_paren,        // (
+	r_paren,        // )
+	l_brace,        // {
+	r_brace,        // }
+	l_bracket,      // [
+	r_bracket,      // ]
+	semicolon,      // ;
+	comma,          // ,
+	dot,            // .
+	ellipsis,       // ...
+	colon,          // :
+	question,       // ?
+	tilde,          // ~
+	bang,           // !
+	plus,           // +
+	minus,          // -
+	star,           // *
+	slash,          // /
+	percent,        // %
+	amp,            // &
+	pipe,           // |
+	caret,          // ^
+	less,           // <
+	greater,        // >
+	assign,         // =
+	plus_plus,      // ++
+	minus_minus,    // --
+	arrow,          // ->
+	amp_amp,        // &&
+	pipe_pipe,      // ||
+	shl,            // <<
+	shr,            // >>
+	eq,             // ==
+	ne,             // !=
+	le,             // <=
+	ge,             // >=
+	plus_assign,    // +=
+	minus_assign,   // -=
+	star_assign,    // *=
+	slash_assign,   // /=
+	percent_assign, // %=
+	amp_assign,     // &=
+	pipe_assign,    // |=
+	caret_assign,   // ^=
+	shl_assign,     // <<=
+	shr_assign,     // >>=
+
+	count,
+};
+
+// Token referring to `length` bytes at `offset` in the source. Identifiers are
+// interned to `sym`, for other tokens it's the empty symbol.
+struct token
+{
+	token_kind kind;
+	uint32_t offset;
+	uint32_t length;
+	symbol sym;
+};
+
+// Tokenizer for a source buffer
+//
+// Whitespace, comments, identifiers and string literals are scanned 16 bytes at
+// a time with SSE2 by classifying the bytes into bitmasks. The scanners read
+// past the end of the source relying on the zero padding of `source_file`.
+//
+// The `symbol_hash()` of an identifier is computed in the same loop that finds
+// its end, and passed on to the keyword table and to `intern_symbol()` so the
+// string is only walked once.
+//
+// Errors such as unterminated literals are returned as `token_kind::error`
+// tokens, the lexer continues after them. At the end of the source it keeps
+// returning `token_kind::end`.
+struct lexer
+{
+	const char *data;
+	uint32_t size;
+	uint32_t pos;
+
+	// Optional front cache for interning, must be owned by the lexing thread
+	symbol_cahce *cache;
+
+	// `data` must be followed by `source_padding` zero bytes
+	lexer(const char *data, uint32_t size, symbol_cahce *cache = nullptr);
+	explicit lexer(const source_file *file, symbol_cahce *cache = nullptr);
+
+	token next();
+
+	// Returns the position of the next token or `size` if there is none,
+	// sets `error` if a block comment is not terminated
+	uint32_t skip_space_and_comments(bool &error);
+
+	symbol intern(const char *str, uint32_t length, uint32_t hash)
+	{
+		return cache ? cache->intern(str, length, hash) : intern_symbol(str, length, hash);
+	}
+};
+
+const char *token_kind_name(token_kind kind);
@@ -0,0 +1,348 @@
+#pragma once
+
+#include <base/base.h>
+#include "symbol.h"
+
+// Compile-time perfect hash tables for fixed string sets such as keywords
+//
+// The table is built entirely at compile time from a constexpr array: a
+// multiplier `seed` is searched so that the top `bits` of `symbol_hash(key) * seed`
+// are unique for every key. A lookup is then one multiply, one slot load and
+// a single compare against the only candidate key.
+//
+//     constexpr const char *keywords[] = { "if", "else", "while" };
+//     constexpr auto keyword_set = make_perfect_hash_set(keywords);
+//
+//     int32_t index = keyword_set.find(str, length, hash);
+//
+// The table has to be declared `constexpr`: duplicate keys fail to compile.
+
+template <typename Val>
+struct perfect_hash_entry
+{
+	const char *key;
+	Val val;
+};
+
+// -- Compile-time construction
+
+template <uint32_t... I> struct perfect_hash_indices { };
+
+template <typename A, typename B> struct perfect_hash_concat;
+
+template <uint32_t... A, uint32_t... B>
+struct perfect_hash_concat<perfect_hash_indices<A...>, perfect_hash_indices<B...>>
+{
+	typedef perfect_hash_indices<A..., ((uint32_t)sizeof...(A) + B)...> type;
+};
+
+template <uint32_t N>
+struct perfect_hash_make_indices
+{
+	typedef typename perfect_hash_concat<
+		typename perfect_hash_make_indices<N / 2>::type,
+		typename perfect_hash_make_indices<N - N / 2>::type>::type type;
+};
+
+template <> struct perfect_hash_make_indices<0> { typedef perfect_hash_indices<> type; };
+template <> struct perfect_hash_make_indices<1> { typedef perfect_hash_indices<0> type; };
+
+constexpr uint32_t perfect_hash_ceil_log2(uint32_t val)
+{
+	return val <= 1 ? 0 : 1 + perfect_hash_ceil_log2((val + 1) >> 1);
+}
+
+// Number of slot bits for `n` keys: at least n^2/8 slots keeps the chance of a
+// random seed being perfect at a few percent
+constexpr uint32_t perfect_hash_bits(uint32_t n)
+{
+	return perfect_hash_ceil_log2(at_least(at_least(n * n / 8, n * 2), 2U));
+}
+
+constexpr uint32_t perfect_hash_slot(uint32_t hash, uint32_t seed, uint32_t bits)
+{
+	return (hash * seed) >> (32 - bits);
+}
+
+constexpr uint32_t perfect_hash_seed(uint32_t index)
+{
+	return (index * 2654435769U + 0x85ebca6bU) | 1U;
+}
+
+constexpr uint32_t perfect_hash_strlen(const char *str)
+{
+	return *str ? 1 + perfect_hash_strlen(str + 1) : 0;
+}
+
+template <size_t N>
+constexpr const char *perfect_hash_key(const char *const (&keys)[N], uint32_t i)
+{
+	return keys[i];
+}
+
+template <typename Val, size_t N>
+constexpr const char *perfect_hash_key(const perfect_hash_entry<Val> (&entries)[N], uint32_t i)
+{
+	return entries[i].key;
+}
+
+// Hashes of the keys computed once up front, the seed search only looks at these
+template <uint32_t N>
+struct perfect_hash_key_hashes
+{
+	uint32_t hashes[N];
+
+	template <typename Source, uint32_t... K>
+	constexpr perfect_hash_key_hashes(const Source &src, perfect_hash_indices<K...>)
+		: hashes { symbol_hash_const(perfect_hash_key(src, K))... }
+	{
+	}
+};
+
+// Is the slot of key `i` different from the slots of the keys `[lo, hi)`
+constexpr bool perfect_hash_no_collision(const uint32_t *hashes, uint32_t i, uint32_t lo, uint32_t hi, uint32_t seed, uint32_t bits)
+{
+	return hi - lo == 0 ? true
+		: hi - lo == 1 ? perfect_hash_slot(hashes[i], seed, bits) != perfect_hash_slot(hashes[lo], seed, bits)
+		: perfect_hash_no_collision(hashes, i, lo, lo + (hi - lo) / 2, seed, bits)
+			&& perfect_hash_no_collision(hashes, i, lo + (hi - lo) / 2, hi, seed, bits);
+}
+
+// Are the slots of the keys `[lo, hi)` different from the slots of all keys after them
+constexpr bool perfect_hash_unique(const uint32_t *hashes, uint32_t n, uint32_t lo, uint32_t hi, uint32_t seed, uint32_t bits)
+{
+	return hi - lo == 0 ? true
+		: hi - lo == 1 ? perfect_hash_no_collision(hashes, lo, lo + 1, n, seed, bits)
+		: perfect_hash_unique(hashes, n, lo, lo + (hi - lo) / 2, seed, bits)
+			&& perfect_hash_unique(hashes, n, lo + (hi - lo) / 2, hi, seed, bits);
+}
+
+constexpr uint32_t perfect_hash_search_block(const uint32_t *hashes, uint32_t n, uint32_t lo, uint32_t hi, uint32_t bits);
+
+// Returns `found` or searches `[lo, hi)` if it's zero, so that every seed is tested once
+constexpr uint32_t perfect_hash_search_rest(uint32_t found, const uint32_t *hashes, uint32_t n, uint32_t lo, uint32_t hi, uint32_t bits)
+{
+	return found ? found : perfect_hash_search_block(hashes, n, lo, hi, bits);
+}
+
+// First perfect seed of the seed indices `[lo, hi)` or zero, split in halves
+// to keep the recursion shallow
+constexpr uint32_t perfect_hash_search_block(const uint32_t *hashes, uint32_t n, uint32_t lo, uint32_t hi, uint32_t bits)
+{
+	return hi - lo == 1
+		? (perfect_hash_unique(hashes, n, 0, n, perfect_hash_seed(lo), bits) ? perfect_hash_seed(lo) : 0)
+		: perfect_hash_search_rest(perfect_hash_search_block(hashes, n, lo, lo + (hi - lo) / 2, bits),
+			hashes, n, lo + (hi - lo) / 2, hi, bits);
+}
+
+constexpr uint32_t perfect_hash_block_size = 64;
+constexpr uint32_t perfect_hash_max_blocks = 64;
+
+constexpr uint32_t perfect_hash_search(const uint32_t *hashes, uint32_t n, uint32_t block, uint32_t bits);
+
+constexpr uint32_t perfect_hash_search_next(uint32_t found, const uint32_t *hashes, uint32_t n, uint32_t block, uint32_t bits)
+{
+	return found ? found : perfect_hash_search(hashes, n, block, bits);
+}
+
+// Search the seeds one block at a time
+constexpr uint32_t perfect_hash_search(const uint32_t *hashes, uint32_t n, uint32_t block, uint32_t bits)
+{
+	return block == perfect_hash_max_blocks
+		? throw "No perfect hash seed found, are there duplicate keys?"
+		: perfect_hash_search_next(perfect_hash_search_block(hashes, n,
+			block * perfect_hash_block_size, (block + 1) * perfect_hash_block_size, bits),
+			hashes, n, block + 1, bits);
+}
+
+// Number of keys in `[lo, hi)` that map to a slot before `slot`
+constexpr uint32_t perfect_hash_count_before(const uint32_t *hashes, uint32_t slot, uint32_t lo, uint32_t hi, uint32_t seed, uint32_t bits)
+{
+	return hi - lo == 0 ? 0
+		: hi - lo == 1 ? (perfect_hash_slot(hashes[lo], seed, bits) < slot ? 1 : 0)
+		: perfect_hash_count_before(hashes, slot, lo, lo + (hi - lo) / 2, seed, bits)
+			+ perfect_hash_count_before(hashes, slot, lo + (hi - lo) / 2, hi, seed, bits);
+}
+
+// Index of the key in `[lo, hi)` with the rank `rank` or `n` if there is none
+constexpr uint32_t perfect_hash_key_of_rank(const uint32_t *ranks, uint32_t n, uint32_t rank, uint32_t lo, uint32_t hi)
+{
+	return hi - lo == 0 ? n
+		: hi - lo == 1 ? (ranks[lo] == rank ? lo : n)
+		: at_most(perfect_hash_key_of_rank(ranks, n, rank, lo, lo + (hi - lo) / 2),
+			perfect_hash_key_of_rank(ranks, n, rank, lo + (hi - lo) / 2, hi));
+}
+
+// Key indices sorted by their slot, so that the slot table can be filled with a
+// binary search per slot instead of testing every key for every slot
+template <uint32_t N>
+struct perfect_hash_ranks
+{
+	uint32_t ranks[N];
+
+	template <uint32_t... K>
+	constexpr perfect_hash_ranks(const uint32_t *hashes, uint32_t seed, uint32_t bits, perfect_hash_indices<K...>)
+		: ranks { perfect_hash_count_before(hashes, perfect_hash_slot(hashes[K], seed, bits), 0, N, seed, bits)... }
+	{
+	}
+};
+
+template <uint32_t N>
+struct perfect_hash_sorted
+{
+	uint32_t keys[N];
+
+	template <uint32_t... K>
+	constexpr perfect_hash_sorted(const uint32_t *ranks, perfect_hash_indices<K...>)
+		: keys { perfect_hash_key_of_rank(ranks, N, K, 0, N)... }
+	{
+	}
+};
+
+// First position in `sorted[lo, hi)` whose key maps to `slot` or later
+constexpr uint32_t perfect_hash_lower_bound(const uint32_t *hashes, const uint32_t *sorted, uint32_t slot, uint32_t lo, uint32_t hi, uint32_t seed, uint32_t bits)
+{
+	return lo == hi ? lo
+		: perfect_hash_slot(hashes[sorted[lo + (hi - lo) / 2]], seed, bits) < slot
+		? perfect_hash_lower_bound(hashes, sorted, slot, lo + (hi - lo) / 2 + 1, hi, seed, bits)
+		: perfect_hash_lower_bound(hashes, sorted, slot, lo, lo + (hi - lo) / 2, seed, bits);
+}
+
+constexpr uint32_t perfect_hash_slot_key_at(const uint32_t *hashes, const uint32_t *sorted, uint32_t n, uint32_t slot, uint32_t pos, uint32_t seed, uint32_t bits)
+{
+	return pos < n && perfect_hash_slot(hashes[sorted[pos]], seed, bits) == slot ? sorted[pos] : n;
+}
+
+// Index of the key that maps to `slot` or `n` if there is none
+constexpr uint32_t perfect_hash_slot_key(const uint32_t *hashes, const uint32_t *sorted, uint32_t n, uint32_t slot, uint32_t seed, uint32_t bits)
+{
+	return perfect_hash_slot_key_at(hashes, sorted, n, slot,
+		perfect_hash_lower_bound(hashes, sorted, slot, 0, n, seed, bits), seed, bits);
+}
+
+// -- Tables
+
+template <uint32_t N>
+struct perfect_hash_set
+{
+	static_assert(N > 0 && N < 256, "Key index must fit in a byte");
+
+	static constexpr uint32_t num_keys = N;
+	static constexpr uint32_t bits = perfect_hash_bits(N);
+	static constexpr uint32_t num_slots = 1U << bits;
+
+	// Slot to key index, empty slots refer to the sentinel key at `N`
+	uint32_t seed;
+	uint8_t slots[num_slots];
+	uint32_t hashes[N + 1];
+	uint32_t lengths[N + 1];
+	const char *keys[N + 1];
+
+	template <typename Source, uint32_t... S, uint32_t... K>
+	constexpr perfect_hash_set(const Source &src, const uint32_t *key_hashes, const uint32_t *sorted, uint32_t seed,
+		perfect_hash_indices<S...>, perfect_hash_indices<K...>)
+		: seed(seed)
+		, slots { (uint8_t)perfect_hash_slot_key(key_hashes, sorted, N, S, seed, bits)... }
+		, hashes { (K < N ? key_hashes[K] : 0)... }
+		, lengths { (K < N ? perfect_hash_strlen(perfect_hash_key(src, K)) : UINT32_MAX)... }
+		, keys { (K < N ? perfect_hash_key(src, K) : "")... }
+	{
+	}
+
+	template <typename Source>
+	constexpr perfect_hash_set(const Source &src, const uint32_t *key_hashes, const uint32_t *sorted, uint32_t seed)
+		: perfect_hash_set(src, key_hashes, sorted, seed,
+			typename perfect_hash_make_indices<num_slots>::type(),
+			typename perfect_hash_make_indices<N + 1>::type())
+	{
+	}
+
+	// Returns the index of the key in the original array or -1 if it's not found
+	int32_t find(const char *str, uint32_t length, uint32_t hash) const
+	{
+		uint32_t ix = slots[perfect_hash_slot(hash, seed, bits)];
+		if (hashes[ix] == hash && lengths[ix] == length && memcmp(keys[ix], str, length) == 0)
+			return (int32_t)ix;
+		return -1;
+	}
+
+	int32_t find(const char *str, uint32_t length) const { return find(str, length, symbol_hash(str, length)); }
+
+	bool contains(const char *str, uint32_t length, uint32_t hash) const { return find(str, length, hash) >= 0; }
+	bool contains(const char *str, uint32_t length) const { return find(str, length) >= 0; }
+};
+
+template <typename Val, uint32_t N>
+struct perfect_hash_map
+{
+	static constexpr uint32_t num_keys = N;
+
+	perfect_hash_set<N> set;
+	Val values[N];
+
+	template <uint32_t... V>
+	constexpr perfect_hash_map(const perfect_hash_entry<Val> (&entries)[N], const uint32_t *key_hashes, const uint32_t *sorted, uint32_t seed,
+		perfect_hash_indices<V...>)
+		: set(entries, key_hashes, sorted, seed)
+		, values { entries[V].val... }
+	{
+	}
+
+	constexpr perfect_hash_map(const perfect_hash_entry<Val> (&entries)[N], const uint32_t *key_hashes, const uint32_t *sorted, uint32_t seed)
+		: perfect_hash_map(entries, key_hashes, sorted, seed, typename perfect_hash_make_indices<N>::type())
+	{
+	}
+
+	// Returns a pointer to the value of the key or nullptr if it's not found
+	const Val *find(const char *str, uint32_t length, uint32_t hash) const
+	{
+		int32_t ix = set.find(str, length, hash);
+		return ix >= 0 ? &values[ix] : nullptr;
+	}
+
+	const Val *find(const char *str, uint32_t length) const { return find(str, length, symbol_hash(str, length)); }
+};
+
+// -- Construction steps, each intermediate result is a temporary passed on to the next step
+
+template <typename Table, typename Source>
+constexpr Table perfect_hash_make_sorted(const Source &src, const uint32_t *key_hashes, uint32_t seed, const uint32_t *ranks)
+{
+	return Table(src, key_hashes,
+		perfect_hash_sorted<Table::num_keys>(ranks, typename perfect_hash_make_indices<Table::num_keys>::type()).keys,
+		seed);
+}
+
+template <typename Table, typename Source>
+constexpr Table perfect_hash_make_seeded(const Source &src, const uint32_t *key_hashes, uint32_t seed)
+{
+	return perfect_hash_make_sorted<Table>(src, key_hashes, seed,
+		perfect_hash_ranks<Table::num_keys>(key_hashes, seed, perfect_hash_bits(Table::num_keys),
+			typename perfect_hash_make_indices<Table::num_keys>::type()).ranks);
+}
+
+template <typename Table, typename Source>
+constexpr Table perfect_hash_make_hashed(const Source &src, const uint32_t *key_hashes)
+{
+	return perfect_hash_make_seeded<Table>(src, key_hashes,
+		perfect_hash_search(key_hashes, Table::num_keys, 0, perfect_hash_bits(Table::num_keys)));
+}
+
+template <typename Table, typename Source>
+constexpr Table perfect_hash_make(const Source &src)
+{
+	return perfect_hash_make_hashed<Table>(src,
+		perfect_hash_key_hashes<Table::num_keys>(src, typename perfect_hash_make_indices<Table::num_keys>::type()).hashes);
+}
+
+template <size_t N>
+constexpr perfect_hash_set<(uint32_t)N> make_perfect_hash_set(const char *const (&keys)[N])
+{
+	return perfect_hash_make<perfect_hash_set<(uint32_t)N>>(keys);
+}
+
+template <typename Val, size_t N>
+constexpr perfect_hash_map<Val, (uint32_t)N> make_perfect_hash_map(const perfect_hash_entry<Val> (&entries)[N])
+{
+	return perfect_hash_make<perfect_hash_map<Val, (uint32_t)N>>(entries);
+}
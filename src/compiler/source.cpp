@@ -0,0 +1,188 @@
+#include "source.h"
+#include <base/memory.h>
+#include <stdio.h>
+
+#if defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#include <Windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+namespace {
+
+#if !defined(_WIN32)
+
+// Reserve room for the file and padding as zero pages and map the file over
+// the start. The rest of the last page of the file is zero-filled by mmap().
+bool map_source(int fd, size_t size, void *&base, size_t &base_size)
+{
+	size_t const page = (size_t)sysconf(_SC_PAGESIZE);
+	size_t const total = align_up((uint64_t)size, (uint64_t)page) + align_up((uint64_t)source_padding, (uint64_t)page);
+
+	void *region = mmap(NULL, total, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (region == MAP_FAILED)
+		return false;
+
+	if (size > 0) {
+		void *file_map = mmap(region, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+		if (file_map == MAP_FAILED) {
+			munmap(region, total);
+			return false;
+		}
+		madvise(region, size, MADV_SEQUENTIAL);
+	}
+
+	base = region;
+	base_size = total;
+	return true;
+}
+
+#endif
+
+// Fallback without memory mapping: read the whole file to a padded buffer
+bool read_source(const char *path, void *&base, size_t &base_size, size_t &size)
+{
+	FILE *f = fopen(path, "rb");
+	if (!f)
+		return false;
+
+	bool ok = fseek(f, 0, SEEK_END) == 0;
+	long end = ok ? ftell(f) : -1;
+	ok = ok && end >= 0 && (uint64_t)end <= source_max_size && fseek(f, 0, SEEK_SET) == 0;
+
+	char *buf = nullptr;
+	if (ok) {
+		size = (size_t)end;
+		base_size = size + source_padding;
+		buf = (char*)mem::alloc(base_size, 64);
+		ok = buf != nullptr && fread(buf, 1, size, f) == size;
+	}
+
+	fclose(f);
+	if (!ok) {
+		mem::free(buf);
+		return false;
+	}
+
+	memset(buf + size, 0, source_padding);
+	base = buf;
+	return true;
+}
+
+}
+
+source_manager::source_manager()
+{
+}
+
+source_manager::~source_manager()
+{
+	for (source_file *file : files) {
+		if (file->data) {
+			file->refs.store(1);
+			release(file);
+		}
+		file->~source_file();
+		mem::free(file);
+	}
+}
+
+source_file *source_manager::create_file(symbol path)
+{
+	source_file *file = (source_file*)mem::alloc(sizeof(source_file));
+	p_assert(file != nullptr);
+	new (file) source_file();
+	file->data = nullptr;
+	file->size = 0;
+	file->id = files.count;
+	file->path = path;
+	file->refs.store(1);
+	file->base = nullptr;
+	file->base_size = 0;
+	file->mapped = false;
+	files.push(file);
+	return file;
+}
+
+source_file *source_manager::open(const char *path)
+{
+	void *base = nullptr;
+	size_t base_size = 0;
+	size_t size = 0;
+	bool mapped = false;
+
+#if !defined(_WIN32)
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0)
+		return nullptr;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (uint64_t)st.st_size > source_max_size) {
+		::close(fd);
+		return nullptr;
+	}
+
+	size = (size_t)st.st_size;
+	mapped = map_source(fd, size, base, base_size);
+	::close(fd);
+#endif
+
+	if (!mapped && !read_source(path, base, base_size, size))
+		return nullptr;
+
+	source_file *file = create_file(intern_symbol(path));
+	file->data = (const char*)base;
+	file->size = (uint32_t)size;
+	file->base = base;
+	file->base_size = base_size;
+	file->mapped = mapped;
+	return file;
+}
+
+source_file *source_manager::add_memory(const char *name, const char *data, uint32_t size)
+{
+	p_assert(size <= source_max_size);
+	size_t const base_size = (size_t)size + source_padding;
+	char *buf = (char*)mem::alloc(base_size, 64);
+	if (!buf)
+		return nullptr;
+
+	memcpy(buf, data, size);
+	memset(buf + size, 0, source_padding);
+
+	source_file *file = create_file(intern_symbol(name));
+	file->data = buf;
+	file->size = size;
+	file->base = buf;
+	file->base_size = base_size;
+	file->mapped = false;
+	return file;
+}
+
+void source_manager::acquire(source_file *file)
+{
+	file->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void source_manager::release(source_file *file)
+{
+	if (file->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+		return;
+
+#if !defined(_WIN32)
+	if (file->mapped)
+		munmap(file->base, file->base_size);
+	else
+		mem::free(file->base);
+#else
+	mem::free(file->base);
+#endif
+
+	file->data = nullptr;
+	file->base = nullptr;
+	file->base_size = 0;
+}
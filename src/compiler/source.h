@@ -0,0 +1,85 @@
+#pragma once
+
+#include <base/base.h>
+#include <base/array.h>
+#include "symbol.h"
+#include <atomic>
+
+// Number of zero bytes readable after the end of every source buffer, so
+// vectorized scanners can load whole blocks past the last byte without bounds
+// checks. The first padding byte also works as a null terminator.
+constexpr uint32_t source_padding = 4096;
+
+// Maximum size of a source file, offsets into a file are 32-bit
+constexpr uint32_t source_max_size = UINT32_MAX - source_padding;
+
+// Range of bytes pointing directly into a source buffer
+struct source_span
+{
+	const char *data;
+	uint32_t length;
+};
+
+// The string is copied to the symbol table, symbols outlive the source file
+inline symbol intern_span(source_span span)
+{
+	return intern_symbol(span.data, span.length);
+}
+
+// Contents of a source file
+//
+// Files are memory mapped with sequential access advice, followed by at least
+// `source_padding` readable zero bytes. The file stays mapped while it has
+// references, the last `source_manager::release()` unmaps it so the memory of
+// a file can be returned as soon as it has been compiled. Spans and tokens
+// pointing into `data` must not be used after that.
+struct source_file
+{
+	const char *data;
+	uint32_t size;
+	uint32_t id;
+	symbol path;
+	std::atomic<uint32_t> refs;
+
+	// Start and size of the whole mapping or allocation including the padding
+	void *base;
+	size_t base_size;
+	bool mapped;
+
+	source_span span(uint32_t offset, uint32_t length) const
+	{
+		p_assert((uint64_t)offset + length <= size);
+		source_span s = { data + offset, length };
+		return s;
+	}
+};
+
+// Owns the loaded source files, indexed by `source_file::id`
+//
+// Opening files is not thread-safe, but the returned files can be shared
+// with other threads which may release them concurrently.
+struct source_manager
+{
+	source_manager(const source_manager&) = delete;
+	source_manager &operator=(const source_manager&) = delete;
+
+	source_manager();
+	~source_manager();
+
+	// Map the file at `path` with one reference, returns nullptr on error
+	source_file *open(const char *path);
+
+	// Copy `size` bytes of `data` to a padded buffer as a file called `name`
+	source_file *add_memory(const char *name, const char *data, uint32_t size);
+
+	void acquire(source_file *file);
+
+	// Drop a reference to `file`, unmapping it if it was the last one
+	void release(source_file *file);
+
+	source_file *get(uint32_t id) const { return files[id]; }
+
+	source_file *create_file(symbol path);
+
+	array<source_file*> files;
+};
@@ -1,4 +1,9 @@
 #include "symbol.h"
+#include <base/memory.h>
+#include <base/file.h>
+#include <base/bit_math.h>
+#include <mutex>
+#include <algorithm>
 
 uint32_t symbol_hash(const char *str, uint32_t length)
 {
@@ -9,12 +14,358 @@ uint32_t symbol_hash(const char *str, uint32_t length)
 	return hash;
 }
 
+namespace {
+
+// The interner is lock-free for lookups and for inserting new symbols:
+//
+// The index is a linear probing table of 64-bit slots `hash << 32 | index`
+// which are filled with a single CAS. The symbol string and its page pointer
+// are written before the CAS so a thread that finds the slot can always read
+// the string. If two threads race to intern the same string the loser's
+// symbol index is left unused, it still refers to a copy of the string.
+//
+// Growing the index takes `resize_mutex`: the old slots are marked with
+// `symbol_slot_moved` one at a time and copied to the new table. Lookups
+// can continue to find moved symbols in the old table, a thread whose probe
+// reaches a moved empty slot waits for the resize to finish and retries in
+// the new table, whether it's inserting or looking up a missing string.
+// Old tables are kept alive until exit as readers may still be using them.
+//
+// `index_count` is the number of symbols in the index: each successful CAS
+// of an empty slot adds one and resizing copies the slots without changing
+// it, so an insert racing with the resize is counted exactly once.
+//
+// A snapshot loaded with `load_symbol_snapshot()` is a read-only base layer:
+// its index is probed before the mutable one and the symbol pointers refer to
+// the strings in the mapped file.
+
+constexpr uint32_t symbol_slot_moved = 1U << 31;
+constexpr uint32_t symbol_initial_index_bits = 12;
+
+// Strings are copied to per-thread chunks so threads interning different
+// strings only share the atomic symbol counter
+constexpr uint32_t symbol_chunk_size = 64U * 1024U;
+
+struct symbol_index
+{
+	std::atomic<uint64_t> *slots;
+	uint32_t capacity;
+	uint32_t shift;
+	symbol_index *prev;
+};
+
+struct symbol_chunk
+{
+	symbol_chunk *next;
+};
+
+struct symbol_table
+{
+	std::atomic<symbol_index*> index;
+	std::atomic<uint32_t> index_count;
+	std::atomic<uint32_t> count;
+	std::atomic<symbol_chunk*> chunks;
+	std::mutex resize_mutex;
+
+	// Read-only base layer, set up before interning
+	mapped_file snapshot;
+	const uint64_t *base_slots;
+	uint32_t base_mask;
+	uint32_t base_shift;
+
+	symbol_table()
+		: index(nullptr)
+		, index_count(0)
+		, count(1)
+		, chunks(nullptr)
+		, base_slots(nullptr)
+		, base_mask(0)
+		, base_shift(0)
+	{
+		index.store(create_index(symbol_initial_index_bits, nullptr));
+	}
+
+	~symbol_table();
+
+	// The table is global so it's always allocated from the standard allocator
+	// instead of the default allocator of the calling thread
+	static symbol_index *create_index(uint32_t bits, symbol_index *prev)
+	{
+		mem::allocator *ator = mem::get_standard_allocator();
+		symbol_index *ix = (symbol_index*)mem::alloc_using(ator, sizeof(symbol_index));
+		p_assert(ix != nullptr);
+		ix->capacity = 1U << bits;
+		ix->shift = 32 - bits;
+		ix->prev = prev;
+		ix->slots = (std::atomic<uint64_t>*)mem::alloc_using(ator, sizeof(std::atomic<uint64_t>) * ix->capacity, 64);
+		p_assert(ix->slots != nullptr);
+		for (uint32_t i = 0; i < ix->capacity; i++) {
+			new (&ix->slots[i]) std::atomic<uint64_t>(0);
+		}
+		return ix;
+	}
+
+	void resize(symbol_index *old);
+};
+
+// Fibonacci hashing to use the high bits of the multiplied hash, sorting by
+// `symbol_slot_order()` visits the index in slot order for any table size
+inline uint32_t symbol_slot_order(uint32_t hash)
+{
+	return hash * 2654435769U;
+}
+
+inline uint32_t symbol_slot_pos(const symbol_index *ix, uint32_t hash)
+{
+	return symbol_slot_order(hash) >> ix->shift;
+}
+
+symbol_string g_empty_symbol = { 0, { 0 } };
+symbol_string *g_symbol_page_zero[symbol_page_size] = { &g_empty_symbol };
+
+symbol_table g_symbol_table;
+
+thread_local char *t_chunk_pos;
+thread_local char *t_chunk_end;
+
+symbol_table::~symbol_table()
+{
+	symbol_index *ix = index.load();
+	while (ix) {
+		symbol_index *prev = ix->prev;
+		mem::free(ix->slots);
+		mem::free(ix);
+		ix = prev;
+	}
+
+	symbol_chunk *chunk = chunks.load();
+	while (chunk) {
+		symbol_chunk *next = chunk->next;
+		mem::free(chunk);
+		chunk = next;
+	}
+
+	for (uint32_t page = 1; page < symbol_max_pages; page++) {
+		mem::free(g_symbol_pointers[page].exchange(nullptr));
+	}
+}
+
+void symbol_table::resize(symbol_index *old)
+{
+	uint32_t const bits = 33 - old->shift;
+	symbol_index *ix = create_index(bits, old);
+	uint32_t const mask = ix->capacity - 1;
+
+	for (uint32_t i = 0; i < old->capacity; i++) {
+		uint64_t slot = old->slots[i].load(std::memory_order_relaxed);
+		while (!old->slots[i].compare_exchange_weak(slot, slot | symbol_slot_moved, std::memory_order_acq_rel)) {
+		}
+
+		if ((uint32_t)slot == 0)
+			continue;
+
+		uint32_t pos = symbol_slot_pos(ix, (uint32_t)(slot >> 32));
+		while (ix->slots[pos].load(std::memory_order_relaxed) != 0) {
+			pos = (pos + 1) & mask;
+		}
+		ix->slots[pos].store(slot, std::memory_order_relaxed);
+	}
+
+	index.store(ix, std::memory_order_release);
+}
+
+symbol_string *create_symbol_string(const char *str, uint32_t length)
+{
+	size_t const size = align_up((uint64_t)(offsetof(symbol_string, data) + length + 1), (uint64_t)alignof(symbol_string));
+	char *ptr;
+
+	if (size > (size_t)(t_chunk_end - t_chunk_pos)) {
+		// Long strings get their own chunk instead of wasting the rest of the current one
+		bool const dedicated = size > symbol_chunk_size / 4;
+		size_t const chunk_size = dedicated ? sizeof(symbol_chunk) + size : symbol_chunk_size;
+		symbol_chunk *chunk = (symbol_chunk*)mem::alloc_using(mem::get_standard_allocator(), chunk_size, 64);
+		p_assert(chunk != nullptr);
+
+		chunk->next = g_symbol_table.chunks.load(std::memory_order_relaxed);
+		while (!g_symbol_table.chunks.compare_exchange_weak(chunk->next, chunk, std::memory_order_release)) {
+		}
+
+		ptr = (char*)(chunk + 1);
+		if (!dedicated) {
+			t_chunk_pos = ptr + size;
+			t_chunk_end = (char*)chunk + chunk_size;
+		}
+	} else {
+		ptr = t_chunk_pos;
+		t_chunk_pos += size;
+	}
+
+	symbol_string *s = (symbol_string*)ptr;
+	s->length = length;
+	memcpy(s->data, str, length);
+	s->data[length] = '\0';
+	return s;
+}
+
+// Page of symbol pointers containing `index`, allocated on first use
+symbol_string **get_symbol_page(uint32_t index)
+{
+	std::atomic<symbol_string**> &page_ref = g_symbol_pointers[index >> symbol_page_bits];
+	symbol_string **page = page_ref.load(std::memory_order_acquire);
+	if (!page) {
+		symbol_string **new_page = (symbol_string**)mem::alloc_using(mem::get_standard_allocator(), sizeof(symbol_string*) * symbol_page_size, 64);
+		p_assert(new_page != nullptr);
+		if (page_ref.compare_exchange_strong(page, new_page, std::memory_order_acq_rel)) {
+			page = new_page;
+		} else {
+			mem::free(new_page);
+		}
+	}
+	return page;
+}
+
+// Allocate a new symbol index referring to a copy of `str`
+uint32_t create_symbol(const char *str, uint32_t length)
+{
+	uint32_t const index = g_symbol_table.count.fetch_add(1, std::memory_order_relaxed);
+	p_assert(index < symbol_max_pages * symbol_page_size);
+
+	symbol_string **page = get_symbol_page(index);
+	page[index & (symbol_page_size - 1)] = create_symbol_string(str, length);
+	return index;
+}
+
+bool symbol_equals(symbol_string *s, const char *str, uint32_t length)
+{
+	return s->length == length && !memcmp(s->data, str, length);
+}
+
+// Returns the index of `str` in the snapshot or 0 if it's not found
+uint32_t find_base_symbol(const symbol_table &st, const char *str, uint32_t length, uint32_t hash)
+{
+	if (!st.base_slots)
+		return 0;
+
+	uint32_t pos = symbol_slot_order(hash) >> st.base_shift;
+	for (uint32_t scan = 0; scan <= st.base_mask; scan++) {
+		uint64_t const slot = st.base_slots[pos];
+		if (slot == 0)
+			return 0;
+
+		uint32_t const index = (uint32_t)slot;
+		if ((uint32_t)(slot >> 32) == hash && symbol_equals(get_symbol(symbol{ index }), str, length))
+			return index;
+
+		pos = (pos + 1) & st.base_mask;
+	}
+	return 0;
+}
+
+// Snapshot file layout, all offsets are from the start of the file:
+// * `offsets`: uint32_t offset of the `symbol_string` of every symbol index
+// * `index`: uint64_t slots `hash << 32 | index` like the in-memory index
+// * `strings`: 4-byte aligned `symbol_string` records
+struct symbol_snapshot_header
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t count;
+	uint32_t index_capacity;
+	uint64_t offsets_offset;
+	uint64_t index_offset;
+	uint64_t strings_offset;
+	uint64_t size;
+};
+
+constexpr uint32_t symbol_snapshot_magic = 0x4d595346; // "FSYM"
+constexpr uint32_t symbol_snapshot_version = 1;
+
+inline uint64_t symbol_record_size(uint32_t length)
+{
+	return align_up((uint64_t)(offsetof(symbol_string, data) + length + 1), (uint64_t)alignof(symbol_string));
+}
+
+symbol_snapshot_header symbol_snapshot_layout(uint32_t count, uint32_t index_capacity, uint64_t strings_size)
+{
+	symbol_snapshot_header h;
+	h.magic = symbol_snapshot_magic;
+	h.version = symbol_snapshot_version;
+	h.count = count;
+	h.index_capacity = index_capacity;
+	h.offsets_offset = align_up((uint64_t)sizeof(symbol_snapshot_header), 8);
+	h.index_offset = align_up(h.offsets_offset + (uint64_t)sizeof(uint32_t) * count, 8);
+	h.strings_offset = h.index_offset + (uint64_t)sizeof(uint64_t) * index_capacity;
+	h.size = h.strings_offset + strings_size;
+	return h;
+}
+
+}
+
+std::atomic<symbol_string**> g_symbol_pointers[symbol_max_pages] = { { g_symbol_page_zero } };
+
 symbol intern_symbol(const char *str, uint32_t length, uint32_t hash)
 {
 	p_debug_assert(hash == symbol_hash(str, length));
 
-	symbol dummy;
-	return dummy;
+	if (length == 0)
+		return symbol{ 0 };
+
+	symbol_table &st = g_symbol_table;
+	uint32_t const base_index = find_base_symbol(st, str, length, hash);
+	if (base_index != 0)
+		return symbol{ base_index };
+
+	uint32_t new_index = 0;
+
+	for (;;) {
+		symbol_index *ix = st.index.load(std::memory_order_acquire);
+		uint32_t const mask = ix->capacity - 1;
+		uint32_t pos = symbol_slot_pos(ix, hash);
+
+		for (;;) {
+			uint64_t slot = ix->slots[pos].load(std::memory_order_acquire);
+			uint32_t const index = (uint32_t)slot & ~symbol_slot_moved;
+
+			if (index != 0 && (uint32_t)(slot >> 32) == hash) {
+				symbol_string *s = get_symbol(symbol{ index });
+				if (s->length == length && !memcmp(s->data, str, length))
+					return symbol{ index };
+			}
+
+			if (slot & symbol_slot_moved) {
+				if (index != 0) {
+					pos = (pos + 1) & mask;
+					continue;
+				}
+
+				// Wait for the resize to finish and retry with the new table
+				std::lock_guard<std::mutex> lock(st.resize_mutex);
+				break;
+			}
+
+			if (slot == 0) {
+				if (new_index == 0)
+					new_index = create_symbol(str, length);
+
+				uint64_t const value = (uint64_t)hash << 32 | new_index;
+				if (!ix->slots[pos].compare_exchange_strong(slot, value, std::memory_order_acq_rel, std::memory_order_acquire)) {
+					// Someone else filled or moved the slot, look at it again
+					continue;
+				}
+
+				uint32_t const num = st.index_count.fetch_add(1, std::memory_order_relaxed) + 1;
+				if (num * 2 > ix->capacity) {
+					std::lock_guard<std::mutex> lock(st.resize_mutex);
+					if (st.index.load(std::memory_order_relaxed) == ix)
+						st.resize(ix);
+				}
+
+				return symbol{ new_index };
+			}
+
+			pos = (pos + 1) & mask;
+		}
+	}
 }
 
 symbol intern_symbol(const char *str, uint32_t length)
@@ -22,12 +373,253 @@ symbol intern_symbol(const char *str, uint32_t length)
 	return intern_symbol(str, length, symbol_hash(str, length));
 }
 
-constexpr uint32_t symbol_page_bits = 10;
+uint32_t get_symbol_count()
+{
+	return g_symbol_table.count.load(std::memory_order_relaxed);
+}
+
+bool save_symbol_snapshot(const char *path)
+{
+	uint32_t const count = g_symbol_table.count.load(std::memory_order_acquire);
+
+	uint64_t strings_size = 0;
+	for (uint32_t i = 0; i < count; i++) {
+		strings_size += symbol_record_size(get_symbol(symbol{ i })->length);
+	}
+
+	uint32_t capacity = 16;
+	while (capacity < count * 2)
+		capacity *= 2;
+
+	symbol_snapshot_header const h = symbol_snapshot_layout(count, capacity, strings_size);
+	if (h.size > UINT32_MAX)
+		return false;
+
+	char *image = (char*)mem::alloc((size_t)h.size, 64);
+	if (!image)
+		return false;
+
+	memset(image, 0, (size_t)h.size);
+	memcpy(image, &h, sizeof(h));
+	uint32_t *offsets = (uint32_t*)(image + h.offsets_offset);
+	uint64_t *slots = (uint64_t*)(image + h.index_offset);
+	uint32_t const shift = 32 - find_msb(capacity);
+	uint64_t pos = h.strings_offset;
+
+	for (uint32_t i = 0; i < count; i++) {
+		symbol_string *s = get_symbol(symbol{ i });
+		symbol_string *dst = (symbol_string*)(image + pos);
+		dst->length = s->length;
+		memcpy(dst->data, s->data, s->length + 1);
+		offsets[i] = (uint32_t)pos;
+		pos += symbol_record_size(s->length);
+
+		if (i == 0)
+			continue;
+
+		// Indices left unused by racing threads are duplicates of earlier ones
+		uint32_t const hash = symbol_hash(s->data, s->length);
+		uint32_t slot = symbol_slot_order(hash) >> shift;
+		bool duplicate = false;
+		while (slots[slot] != 0) {
+			symbol_string *other = (symbol_string*)(image + offsets[(uint32_t)slots[slot]]);
+			if ((uint32_t)(slots[slot] >> 32) == hash && symbol_equals(other, s->data, s->length)) {
+				duplicate = true;
+				break;
+			}
+			slot = (slot + 1) & (capacity - 1);
+		}
+		if (!duplicate)
+			slots[slot] = (uint64_t)hash << 32 | i;
+	}
+
+	bool ok = write_file(path, image, (size_t)h.size);
+	mem::free(image);
+	return ok;
+}
+
+namespace {
+
+bool validate_symbol_snapshot(const char *image, size_t size)
+{
+	const symbol_snapshot_header *h = (const symbol_snapshot_header*)image;
+	if (size < sizeof(symbol_snapshot_header)) return false;
+	if (h->magic != symbol_snapshot_magic || h->version != symbol_snapshot_version) return false;
+	if (h->count == 0 || h->count > symbol_max_pages * symbol_page_size) return false;
+	if (h->index_capacity < 16 || (h->index_capacity & (h->index_capacity - 1)) != 0) return false;
+	if (h->size != size || h->size < h->strings_offset) return false;
+
+	symbol_snapshot_header const layout = symbol_snapshot_layout(h->count, h->index_capacity, h->size - h->strings_offset);
+	if (h->offsets_offset != layout.offsets_offset || h->index_offset != layout.index_offset) return false;
+	if (h->strings_offset != layout.strings_offset) return false;
+
+	const uint32_t *offsets = (const uint32_t*)(image + h->offsets_offset);
+	const uint64_t *slots = (const uint64_t*)(image + h->index_offset);
+
+	for (uint32_t i = 0; i < h->count; i++) {
+		uint64_t const offset = offsets[i];
+		if (offset < h->strings_offset || offset % alignof(symbol_string) != 0) return false;
+		if (offset + offsetof(symbol_string, data) > h->size) return false;
+		const symbol_string *s = (const symbol_string*)(image + offset);
+		if (offset + symbol_record_size(s->length) > h->size || s->data[s->length] != '\0') return false;
+	}
+
+	// At most half full like the tables written by `save_symbol_snapshot()`,
+	// so probing for a missing symbol always reaches an empty slot quickly
+	uint32_t used = 0;
+	for (uint32_t i = 0; i < h->index_capacity; i++) {
+		uint32_t const index = (uint32_t)slots[i];
+		if (slots[i] == 0) continue;
+		if (index == 0 || index >= h->count) return false;
+		used++;
+	}
+	if (used > h->index_capacity / 2) return false;
+
+	return true;
+}
+
+}
+
+bool load_symbol_snapshot(const char *path)
+{
+	symbol_table &st = g_symbol_table;
+	if (st.base_slots)
+		return false;
+
+	mapped_file &file = st.snapshot;
+	if (!file.open(path))
+		return false;
+
+	const char *image = (const char*)file.data;
+	if (!validate_symbol_snapshot(image, file.size)) {
+		file.close();
+		return false;
+	}
+
+	const symbol_snapshot_header *h = (const symbol_snapshot_header*)image;
+	const uint32_t *offsets = (const uint32_t*)(image + h->offsets_offset);
+	uint32_t const count = h->count;
 
-symbol_string *g_symbol_pointers[32 - symbol_page_bits];
+	// The symbols interned so far must be the start of the snapshot to keep their indices
+	uint32_t const interned = st.count.load(std::memory_order_acquire);
+	bool prefix = interned <= count;
+	for (uint32_t i = 1; prefix && i < interned; i++) {
+		symbol_string *s = (symbol_string*)(image + offsets[i]);
+		prefix = symbol_equals(get_symbol(symbol{ i }), s->data, s->length);
+	}
+	if (!prefix) {
+		file.close();
+		return false;
+	}
+
+	for (uint32_t i = 1; i < count; i++) {
+		symbol_string **page = get_symbol_page(i);
+		page[i & (symbol_page_size - 1)] = (symbol_string*)(image + offsets[i]);
+	}
+
+	st.base_slots = (const uint64_t*)(image + h->index_offset);
+	st.base_mask = h->index_capacity - 1;
+	st.base_shift = 32 - find_msb(h->index_capacity);
+	st.count.store(count, std::memory_order_release);
+	return true;
+}
 
-symbol_string *get_symbol(symbol sym)
+symbol_cahce::symbol_cahce(uint32_t set_bits)
+	: set_mask((1U << set_bits) - 1)
+	, hits(0)
+	, misses(0)
 {
-	return nullptr;
+	size_t const size = sizeof(entry) * 2 << set_bits;
+	entries = (entry*)mem::alloc(size, 64);
+	p_assert(entries != nullptr);
+	memset(entries, 0, size);
+}
+
+symbol_cahce::~symbol_cahce()
+{
+	p_assert(deferred_symbols.count == 0 && "Unresolved deferred symbols");
+	mem::free(entries);
+}
+
+symbol symbol_cahce::intern(const char *str, uint32_t length)
+{
+	return intern(str, length, symbol_hash(str, length));
+}
+
+bool symbol_cahce::find_second(entry *set, const char *str, uint32_t length, uint32_t hash, symbol &sym)
+{
+	if (!matches(set[1], str, length, hash))
+		return false;
+
+	entry const first = set[0];
+	set[0] = set[1];
+	set[1] = first;
+	sym.index = set[0].index;
+	return true;
 }
 
+symbol symbol_cahce::intern_miss(entry *set, const char *str, uint32_t length, uint32_t hash)
+{
+	symbol sym;
+	if (find_second(set, str, length, hash, sym)) {
+		hits++;
+		return sym;
+	}
+
+	misses++;
+	sym = intern_symbol(str, length, hash);
+	if (sym.index != 0)
+		insert_first(set, hash, sym);
+	return sym;
+}
+
+bool symbol_cahce::intern_deferred(symbol *sym, const char *str, uint32_t length, uint32_t hash)
+{
+	p_debug_assert(hash == symbol_hash(str, length));
+
+	entry *set = entries + (hash & set_mask) * 2;
+	if (matches(set[0], str, length, hash)) {
+		hits++;
+		sym->index = set[0].index;
+		return true;
+	}
+	if (find_second(set, str, length, hash, *sym)) {
+		hits++;
+		return true;
+	}
+	if (length == 0) {
+		sym->index = 0;
+		return true;
+	}
+
+	misses++;
+	deferred d = { sym, str, length, hash };
+	deferred_symbols.push(d);
+	return false;
+}
+
+void symbol_cahce::resolve_deferred()
+{
+	deferred *begin = deferred_symbols.begin();
+	deferred *end = deferred_symbols.end();
+
+	// Sorting walks the index in order and makes repeats of a string adjacent
+	std::sort(begin, end, [](const deferred &a, const deferred &b) {
+		return symbol_slot_order(a.hash) < symbol_slot_order(b.hash);
+	});
+
+	const deferred *prev = nullptr;
+	symbol sym = { 0 };
+	for (deferred *d = begin; d != end; d++) {
+		bool const repeat = prev && prev->hash == d->hash && prev->length == d->length
+			&& !memcmp(prev->str, d->str, d->length);
+		if (!repeat) {
+			sym = intern_symbol(d->str, d->length, d->hash);
+			insert_first(entries + (d->hash & set_mask) * 2, d->hash, sym);
+		}
+		*d->sym = sym;
+		prev = d;
+	}
+
+	deferred_symbols.clear();
+}
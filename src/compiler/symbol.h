@@ -1,13 +1,21 @@
 #pragma once
 
 #include <base/base.h>
+#include <base/array.h>
 #include <string.h>
+#include <atomic>
 
+// Interned string: symbols with the same string have the same index so they
+// can be compared as integers. Index 0 is the empty string.
 struct symbol
 {
 	uint32_t index;
+
+	bool operator==(const symbol &rhs) const { return index == rhs.index; }
+	bool operator!=(const symbol &rhs) const { return index != rhs.index; }
 };
 
+// Immutable null-terminated string of a symbol
 struct symbol_string
 {
 	uint32_t length;
@@ -26,6 +34,13 @@ constexpr inline uint32_t symbol_hash_feed(uint32_t hash, unsigned char byte)
 	return (hash ^ byte) * 16777619U;
 }
 
+// Compile-time `symbol_hash()` of a null-terminated string
+constexpr inline uint32_t symbol_hash_const(const char *str, uint32_t hash = symbol_hash_init())
+{
+	return *str ? symbol_hash_const(str + 1, symbol_hash_feed(hash, (unsigned char)*str)) : hash;
+}
+
+// Thread-safe and lock-free unless the index needs to grow
 symbol intern_symbol(const char *str, uint32_t length, uint32_t hash);
 symbol intern_symbol(const char *str, uint32_t length);
 static inline symbol intern_symbol(const char *str)
@@ -33,19 +48,139 @@ static inline symbol intern_symbol(const char *str)
 	return intern_symbol(str, (uint32_t)strlen(str));
 }
 
-symbol_string *get_symbol(symbol sym);
+// The strings of the symbols are referred to by pages of `symbol_page_size`
+// pointers, pages are never moved or freed so `get_symbol()` doesn't need to
+// synchronize with interning. The string is written before the symbol is
+// published so any thread that received a symbol can read it.
+constexpr uint32_t symbol_page_bits = 10;
+constexpr uint32_t symbol_page_size = 1U << symbol_page_bits;
+constexpr uint32_t symbol_index_bits = 24;
+constexpr uint32_t symbol_max_pages = 1U << (symbol_index_bits - symbol_page_bits);
+
+extern std::atomic<symbol_string**> g_symbol_pointers[symbol_max_pages];
+
+inline symbol_string *get_symbol(symbol sym)
+{
+	symbol_string **page = g_symbol_pointers[sym.index >> symbol_page_bits].load(std::memory_order_relaxed);
+	return page[sym.index & (symbol_page_size - 1)];
+}
+
+// Write all the interned symbols to a snapshot file at `path` that can be loaded
+// by later runs with the same symbol indices. No thread may be interning at the
+// same time. Returns false on error.
+bool save_symbol_snapshot(const char *path);
+
+// Map a snapshot file as the read-only base layer of the symbol table: its symbols
+// keep their saved indices and strings are used directly from the mapping, new
+// symbols are added in memory. Must be called before other threads start interning
+// and any symbols interned so far must be the first ones of the snapshot.
+// Returns false if the file is not a valid snapshot or it can't be used.
+bool load_symbol_snapshot(const char *path);
+
+// Number of allocated symbol indices including the empty string. Threads racing
+// to intern the same string may leave some indices unused.
+uint32_t get_symbol_count();
+
+// Per-thread front cache for `intern_symbol()`
+//
+// A 2-way set associative cache of `(hash, symbol)` pairs indexed by the low
+// bits of the hash. Most identifiers repeat within a file so they resolve by
+// comparing against the already interned string without touching the shared
+// index. A cache must only be used by one thread at a time, eg. each lexer
+// thread owns one.
+//
+// `hits` and `misses` count the lookups to help tune `set_bits`.
+//
+// `intern_deferred()` queues the misses instead of interning them right away,
+// `resolve_deferred()` then interns the whole batch in one pass sorted by the
+// index slot order, eg. at the end of lexing a file.
+constexpr uint32_t symbol_cache_default_set_bits = 9;
 
 struct symbol_cahce
 {
-	uint64_t storage[4];
+	struct entry
+	{
+		uint32_t hash;
+		uint32_t index;
+	};
+
+	struct deferred
+	{
+		symbol *sym;
+		const char *str;
+		uint32_t length;
+		uint32_t hash;
+	};
+
+	// `2 << set_bits` entries, index 0 marks an empty entry
+	entry *entries;
+	uint32_t set_mask;
+	uint64_t hits;
+	uint64_t misses;
+	array<deferred> deferred_symbols;
+
+	symbol_cahce(const symbol_cahce&) = delete;
+	symbol_cahce &operator=(const symbol_cahce&) = delete;
+
+	explicit symbol_cahce(uint32_t set_bits = symbol_cache_default_set_bits);
+	~symbol_cahce();
+
+	static bool matches(entry e, const char *str, uint32_t length, uint32_t hash)
+	{
+		if (e.hash != hash || e.index == 0) return false;
+		symbol_string *s = get_symbol(symbol{ e.index });
+		return s->length == length && !memcmp(s->data, str, length);
+	}
+
+	inline symbol intern(const char *str, uint32_t length, uint32_t hash)
+	{
+		p_debug_assert(hash == symbol_hash(str, length));
+
+		entry *set = entries + (hash & set_mask) * 2;
+		if (matches(set[0], str, length, hash)) {
+			hits++;
+			return symbol{ set[0].index };
+		}
+		return intern_miss(set, str, length, hash);
+	}
 
-	symbol intern(const char *str, uint32_t length, uint32_t hash);
 	symbol intern(const char *str, uint32_t length);
 	inline symbol intern(const char *str)
 	{
 		return intern(str, (uint32_t)strlen(str));
 	}
 
+	// Write the symbol to `*sym` and return `true` if it's found in the cache,
+	// otherwise queue it to be written by `resolve_deferred()` and return `false`.
+	// `sym` and `str` must stay valid until then.
 	bool intern_deferred(symbol *sym, const char *str, uint32_t length, uint32_t hash);
-};
 
+	// Intern all the queued symbols and write them to their destinations
+	void resolve_deferred();
+
+	// Look up the second way, the found entry is moved to the first way
+	bool find_second(entry *set, const char *str, uint32_t length, uint32_t hash, symbol &sym);
+
+	// Move `sym` to the first way of `set`
+	static void insert_first(entry *set, uint32_t hash, symbol sym)
+	{
+		set[1] = set[0];
+		set[0].hash = hash;
+		set[0].index = sym.index;
+	}
+
+	// Second way or the global interner
+	symbol intern_miss(entry *set, const char *str, uint32_t length, uint32_t hash);
+
+	double hit_rate() const
+	{
+		uint64_t const total = hits + misses;
+		return total ? (double)hits / (double)total : 0.0;
+	}
+
+	void reset_stats()
+	{
+		hits = 0;
+		misses = 0;
+	}
+};
@@ -0,0 +1,100 @@
+#include "token_buffer.h"
+
+namespace {
+
+// Rough number of source bytes per token used to size the buffer up front,
+// slightly low for typical code so that most files never need to grow
+constexpr uint32_t bytes_per_token_estimate = 6;
+constexpr uint32_t tokens_per_literal_estimate = 8;
+
+}
+
+token_buffer::token_buffer(linear_allocator *arena)
+	: kinds(nullptr)
+	, offsets(nullptr)
+	, values(nullptr)
+	, count(0)
+	, capacity(0)
+	, literals(nullptr)
+	, literal_count(0)
+	, literal_capacity(0)
+	, arena(arena)
+{
+	p_assert(arena != nullptr);
+}
+
+void token_buffer::reserve(uint32_t num_tokens, uint32_t num_literals)
+{
+	// The previous arrays stay in the arena until it's reset, growing by
+	// doubling wastes at most as much memory as the final arrays
+	if (num_tokens > capacity) {
+		uint32_t new_capacity = at_least(num_tokens, capacity * 2);
+		kinds = arena->realloc_array(kinds, count, new_capacity);
+		offsets = arena->realloc_array(offsets, count, new_capacity);
+		values = arena->realloc_array(values, count, new_capacity);
+		capacity = new_capacity;
+	}
+
+	if (num_literals > literal_capacity) {
+		uint32_t new_capacity = at_least(num_literals, literal_capacity * 2);
+		literals = arena->realloc_array(literals, literal_count, new_capacity);
+		literal_capacity = new_capacity;
+	}
+}
+
+void token_buffer::push(const token &t)
+{
+	if (count == capacity)
+		reserve(count + 1, 0);
+
+	uint32_t value = t.sym.index;
+	if (token_has_literal(t.kind)) {
+		if (literal_count == literal_capacity)
+			reserve(0, literal_count + 1);
+		value = literal_count;
+		literals[literal_count].offset = t.offset;
+		literals[literal_count].length = t.length;
+		literal_count++;
+	}
+
+	kinds[count] = (uint8_t)t.kind;
+	offsets[count] = t.offset;
+	values[count] = value;
+	count++;
+}
+
+void token_buffer::lex_all(lexer &lex)
+{
+	uint32_t const estimate = (lex.size - lex.pos) / bytes_per_token_estimate + 1;
+	reserve(count + estimate, literal_count + estimate / tokens_per_literal_estimate + 1);
+
+	for (;;) {
+		token t = lex.next();
+		push(t);
+		if (t.kind == token_kind::end)
+			break;
+	}
+}
+
+token token_buffer::get(uint32_t index) const
+{
+	p_assert(index < count);
+
+	token t;
+	t.kind = (token_kind)kinds[index];
+	t.offset = offsets[index];
+	t.sym = symbol{ 0 };
+
+	if (t.kind == token_kind::identifier) {
+		t.sym = symbol{ values[index] };
+		t.length = get_symbol(t.sym)->length;
+	} else if (token_has_literal(t.kind)) {
+		t.length = literals[values[index]].length;
+	} else if (t.kind == token_kind::end) {
+		t.length = 0;
+	} else {
+		t.length = (uint32_t)strlen(token_kind_name(t.kind));
+	}
+
+	return t;
+}
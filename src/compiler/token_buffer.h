@@ -0,0 +1,82 @@
+#pragma once
+
+#include <base/base.h>
+#include <base/linear_allocator.h>
+#include "lexer.h"
+
+// Literal or error token text, referred to by `token_buffer::values`
+struct token_literal
+{
+	uint32_t offset;
+	uint32_t length;
+};
+
+// Tokens of a file stored as parallel arrays
+//
+// Token `i` has the kind `kinds[i]`, starts at `offsets[i]` in the source and
+// `values[i]` is its symbol index for identifiers, an index to `literals` for
+// literals and errors, or zero for keywords and punctuators whose length is
+// implied by the kind. A parser reading the kinds touches one byte per token.
+//
+// The arrays are bump-allocated from `arena` which is meant to hold the tokens
+// of a single file: all the memory is released with `arena->reset()` once the
+// file has been parsed, after which the buffer must not be used.
+//
+// The last token is always `token_kind::end` so lookahead doesn't need to
+// check the count.
+struct token_buffer
+{
+	uint8_t *kinds;
+	uint32_t *offsets;
+	uint32_t *values;
+	uint32_t count;
+	uint32_t capacity;
+
+	token_literal *literals;
+	uint32_t literal_count;
+	uint32_t literal_capacity;
+
+	linear_allocator *arena;
+
+	token_buffer(const token_buffer&) = delete;
+	token_buffer &operator=(const token_buffer&) = delete;
+
+	explicit token_buffer(linear_allocator *arena);
+
+	// Lex the whole source of `lex` appending the tokens and the end token
+	void lex_all(lexer &lex);
+
+	void push(const token &t);
+
+	// Reserve room for at least `num_tokens` tokens and `num_literals` literals
+	void reserve(uint32_t num_tokens, uint32_t num_literals);
+
+	token_kind kind(uint32_t index) const
+	{
+		p_assert(index < count);
+		return (token_kind)kinds[index];
+	}
+
+	symbol sym(uint32_t index) const
+	{
+		p_assert(index < count && kinds[index] == (uint8_t)token_kind::identifier);
+		return symbol{ values[index] };
+	}
+
+	const token_literal &literal(uint32_t index) const
+	{
+		p_assert(index < count);
+		p_assert(values[index] < literal_count);
+		return literals[values[index]];
+	}
+
+	// Reconstruct the full token, the length is found from the symbol, literal
+	// or the spelling of the kind
+	token get(uint32_t index) const;
+};
+
+// Does `kind` store its text in `token_buffer::literals`
+inline bool token_has_literal(token_kind kind)
+{
+	return kind == token_kind::error || (kind >= token_kind::integer && kind <= token_kind::character);
+}
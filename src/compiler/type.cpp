@@ -0,0 +1,74 @@
+#include "type.h"
+#include <base/hash.h>
+
+uint32_t type_desc::hash() const
+{
+	uint64_t h = hash_int64((uint64_t)kind << 56 ^ (uint64_t)base.index << 24 ^ count);
+	h = hash_int64(h ^ name.index);
+	if (kind == type_kind::function && count > 0)
+		h ^= hash_bytes64(params, sizeof(type_id) * count);
+	return (uint32_t)(h ^ h >> 32);
+}
+
+bool type_desc::operator==(const type_desc &rhs) const
+{
+	if (kind != rhs.kind || base != rhs.base || count != rhs.count || name != rhs.name)
+		return false;
+	if (kind == type_kind::function && count > 0)
+		return memcmp(params, rhs.params, sizeof(type_id) * count) == 0;
+	return true;
+}
+
+type_desc type_desc::copy_to(linear_allocator &arena) const
+{
+	type_desc copy = *this;
+	if (kind == type_kind::function && count > 0) {
+		type_id *new_params = (type_id*)arena.alloc(sizeof(type_id) * count, alignof(type_id));
+		memcpy(new_params, params, sizeof(type_id) * count);
+		copy.params = new_params;
+	} else {
+		copy.params = nullptr;
+	}
+	return copy;
+}
+
+type_desc make_basic_type(type_kind kind)
+{
+	p_assert(kind >= type_kind::void_type && kind <= type_kind::double_type);
+	type_desc desc = { kind, type_id{ 0 }, 0, symbol{ 0 }, nullptr };
+	return desc;
+}
+
+type_desc make_pointer_type(type_id pointee)
+{
+	type_desc desc = { type_kind::pointer, pointee, 0, symbol{ 0 }, nullptr };
+	return desc;
+}
+
+type_desc make_array_type(type_id element, uint32_t length)
+{
+	type_desc desc = { type_kind::array, element, length, symbol{ 0 }, nullptr };
+	return desc;
+}
+
+type_desc make_function_type(type_id result, const type_id *params, uint32_t num_params)
+{
+	type_desc desc = { type_kind::function, result, num_params, symbol{ 0 }, params };
+	return desc;
+}
+
+type_desc make_struct_type(symbol name)
+{
+	type_desc desc = { type_kind::struct_type, type_id{ 0 }, 0, name, nullptr };
+	return desc;
+}
+
+type_table::type_table(mem::allocator *ator)
+	: intern_table<type_desc, type_id>(ator)
+{
+	for (uint32_t kind = (uint32_t)type_kind::void_type; kind <= (uint32_t)type_kind::double_type; kind++) {
+		type_id id = intern(make_basic_type((type_kind)kind));
+		p_assert(id.index == kind);
+		(void)id;
+	}
+}
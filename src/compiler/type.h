@@ -0,0 +1,74 @@
+#pragma once
+
+#include <base/base.h>
+#include "symbol.h"
+#include "intern_table.h"
+
+enum class type_kind : uint8_t
+{
+	none,
+
+	// Basic types, interned to the ids of the same value by `type_table`
+	void_type,
+	bool_type,
+	char_type,
+	int_type,
+	float_type,
+	double_type,
+
+	pointer,
+	array,
+	function,
+	struct_type,
+
+	count,
+};
+
+// Interned type: types with the same structure have the same id, so type
+// checking compares them as integers. Id 0 is no type.
+struct type_id
+{
+	uint32_t index;
+
+	bool operator==(const type_id &rhs) const { return index == rhs.index; }
+	bool operator!=(const type_id &rhs) const { return index != rhs.index; }
+};
+
+// Structural description of a type, referring to other types by id
+//
+// - `pointer`: `base` is the pointee
+// - `array`: `base` is the element type and `count` the length
+// - `function`: `base` is the return type, `params` has `count` parameter types
+// - `struct_type`: nominal, identified by `name`
+struct type_desc
+{
+	type_kind kind;
+	type_id base;
+	uint32_t count;
+	symbol name;
+	const type_id *params;
+
+	uint32_t hash() const;
+	bool operator==(const type_desc &rhs) const;
+	type_desc copy_to(linear_allocator &arena) const;
+};
+
+type_desc make_basic_type(type_kind kind);
+type_desc make_pointer_type(type_id pointee);
+type_desc make_array_type(type_id element, uint32_t length);
+type_desc make_function_type(type_id result, const type_id *params, uint32_t num_params);
+type_desc make_struct_type(symbol name);
+
+inline type_id basic_type(type_kind kind)
+{
+	p_assert(kind >= type_kind::void_type && kind <= type_kind::double_type);
+	return type_id{ (uint32_t)kind };
+}
+
+// Type table with the basic types interned up front
+struct type_table : intern_table<type_desc, type_id>
+{
+	explicit type_table(mem::allocator *ator = nullptr);
+};
+
+typedef intern_cache<type_desc, type_id> type_cache;
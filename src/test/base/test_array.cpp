@@ -0,0 +1,143 @@
+#include <test/test.h>
+#include <base/array.h>
+#include <base/linear_allocator.h>
+#include <string>
+
+test_case(array_push)
+{
+	array<uint32_t> arr;
+
+	for (uint32_t i = 0; i < 1000; i++) {
+		arr.push(i);
+	}
+
+	test_assert(arr.count == 1000, "Count is correct");
+	test_assert(arr.capacity >= 1000, "Capacity is enough");
+
+	uint32_t i = 0;
+	for (uint32_t v : arr) {
+		test_assert(v == i, "Iterated in order");
+		i++;
+	}
+
+	arr.pop();
+	test_assert(arr.count == 999 && arr.back() == 998, "Popped the last element");
+
+	auto it = arr.erase(arr.begin() + 10);
+	test_assert(*it == 11 && arr[10] == 11, "Erase keeps the order");
+	test_assert(arr.count == 998, "Count is correct after erase");
+
+	arr.push(arr[0]);
+	test_assert(arr.back() == 0, "Push an element of the array itself");
+
+	arr.resize(2000);
+	test_assert(arr[1999] == 0, "Resize value-initializes");
+}
+
+test_case(array_emplace_self)
+{
+	array<std::string> arr;
+	arr.push(std::string("a string too long for the small string buffer"));
+	while (arr.count < arr.capacity) {
+		arr.push(std::string("filler"));
+	}
+
+	// Growing relocates the element the argument refers to
+	arr.emplace(arr[0]);
+	test_assert(arr.back() == "a string too long for the small string buffer", "Emplace an element of the array itself");
+	test_assert(arr[0] == arr.back(), "Original is intact");
+}
+
+test_case(array_small)
+{
+	small_array<uint32_t, 16> arr;
+	uint32_t *inline_data = arr.data;
+
+	for (uint32_t i = 0; i < 16; i++) {
+		arr.push(i);
+	}
+
+	test_assert(arr.data == inline_data && arr.is_small(), "Stored inline");
+
+	arr.push(16);
+	test_assert(arr.data != inline_data && !arr.is_small(), "Spilled to the heap");
+
+	array<uint32_t> &ref = arr;
+	for (uint32_t i = 17; i < 100; i++) {
+		ref.push(i);
+	}
+
+	for (uint32_t i = 0; i < 100; i++) {
+		test_assert(arr[i] == i, "Value is correct");
+	}
+}
+
+test_case(array_copy_move)
+{
+	small_array<counter, 4> small;
+	array<counter> heap;
+
+	for (int i = 0; i < 3; i++) {
+		small.emplace(i);
+		heap.emplace(i);
+	}
+
+	{
+		small_array<counter, 4> moved = std::move(small);
+		test_assert(moved.is_small() && moved.count == 3, "Moved inline elements");
+		test_assert(small.count == 0, "Moved from is empty");
+
+		array<counter> moved_heap = std::move(moved);
+		test_assert(!moved_heap.is_small() && moved_heap.count == 3, "Moved inline elements to the heap");
+
+		small_array<counter, 4> stolen = std::move(heap);
+		test_assert(stolen.is_small(), "Moved small enough heap array inline");
+
+		counter *heap_data = moved_heap.data;
+		small_array<counter, 2> stolen_heap = std::move(moved_heap);
+		test_assert(stolen_heap.data == heap_data, "Stole the heap buffer");
+
+		array<counter> copy = stolen;
+		small_array<counter, 2> small_copy = copy;
+		test_assert(small_copy.count == 3 && !small_copy.is_small(), "Copy larger than the inline storage");
+
+		for (int i = 0; i < 3; i++) {
+			test_assert(stolen_heap[i].value == i, "Moved value is correct");
+			test_assert(copy[i].value == i, "Copied value is correct");
+			test_assert(small_copy[i].value == i, "Copied value is correct");
+		}
+
+		small = std::move(small_copy);
+		test_assert(small.count == 3 && small[2].value == 2, "Move assigned");
+	}
+
+	small.clear();
+	heap.clear();
+	test_assert(counts.ctor == counts.dtor, "Objects destroyed");
+}
+
+test_case(array_extend_in_place)
+{
+	linear_allocator la;
+	array<uint32_t> arr(&la);
+
+	arr.push(0);
+	uint32_t *data = arr.data;
+
+	for (uint32_t i = 1; i < 1000; i++) {
+		arr.push(i);
+	}
+
+	test_assert(arr.data == data, "Grew in place in the linear allocator");
+
+	void *other = la.alloc(16, 8);
+	(void)other;
+	for (uint32_t i = 1000; i < 2000; i++) {
+		arr.push(i);
+	}
+
+	test_assert(arr.data != data, "Moved when not the latest allocation");
+	for (uint32_t i = 0; i < 2000; i++) {
+		test_assert(arr[i] == i, "Value is correct");
+	}
+}
@@ -18,3 +18,12 @@ test_case(find_msb_small)
 	}
 }
 
+test_case(find_lsb_small)
+{
+	for (uint32_t i = 1; i < 65536; i++) {
+		uint32_t lsb = find_lsb(i);
+		uint32_t mask = (1 << lsb) - 1;
+		test_assert((mask & i) == 0, "No bits under LSB set");
+		test_assert(((1 << lsb) & i) != 0, "LSB is actually set");
+	}
+}
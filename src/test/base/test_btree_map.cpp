@@ -0,0 +1,181 @@
+#include <test/test.h>
+#include <base/btree_map.h>
+#include <string>
+
+test_case(btree_map_sorted_iteration)
+{
+	btree_map<uint32_t, uint32_t> map;
+	uint32_t num = 100000;
+
+	for (uint32_t i = 0; i < num; i++) {
+		map.insert((i * 7919) % num, i);
+	}
+
+	test_assert(map.count == num, "Count is correct");
+	test_assert(!map.root->leaf, "Has inner nodes");
+
+	uint32_t i = 0;
+	for (auto &pair : map) {
+		test_assert(pair.key == i, "Iterated in key order");
+		test_assert(pair.val * 7919 % num == i, "Value is correct");
+		i++;
+	}
+	test_assert(i == num, "Iterated all entries");
+
+	for (uint32_t i = 0; i < num; i++) {
+		auto it = map.find(i);
+		test_assert(it != map.end() && it->key == i, "Found key");
+	}
+
+	test_assert(map.find(num) == map.end(), "Trying to find element that doesn't exist");
+
+	auto it = map.end();
+	--it;
+	test_assert(it->key == num - 1, "Decrement from the end");
+}
+
+test_case(btree_map_bounds)
+{
+	btree_map<int32_t, int32_t> map;
+
+	for (int32_t i = -5000; i < 5000; i++) {
+		map.insert(i * 3, i);
+	}
+
+	int32_t expected = -15000;
+	for (int32_t i = -15100; i < 15100; i++) {
+		if (i > expected) expected += 3;
+		auto it = map.lower_bound(i);
+		if (expected >= 15000) {
+			test_assert(it == map.end(), "Lower bound past the last key");
+		} else {
+			test_assert(it != map.end() && it->key == expected, "Found lower bound");
+		}
+	}
+
+	auto it = map.upper_bound(3);
+	test_assert(it != map.end() && it->key == 6, "Found upper bound");
+}
+
+test_case(btree_map_overwrite_and_erase)
+{
+	btree_map<uint32_t, uint32_t> map;
+
+	for (uint32_t i = 0; i < 10000; i++) {
+		map[i] = i * 10;
+	}
+
+	bool inserted = map.insert(50, 51);
+	test_assert(!inserted, "Insert over existing key");
+	test_assert(map.find(50)->val == 51, "Overwrote the value");
+
+	// Empties whole leaves in the middle of the tree
+	for (uint32_t i = 0; i < 10000; i++) {
+		if (i % 3 == 0 || (i >= 2000 && i < 5000)) {
+			bool found = map.erase(i);
+			test_assert(found, "Found key to erase");
+		}
+	}
+
+	test_assert(!map.erase(0), "Erased key is gone");
+
+	uint32_t prev = 0, num = 0;
+	for (auto &pair : map) {
+		test_assert(pair.key > prev, "Order is preserved");
+		test_assert(pair.key % 3 != 0 && (pair.key < 2000 || pair.key >= 5000), "Erased keys not visited");
+		prev = pair.key;
+		num++;
+	}
+	test_assert(num == map.count, "Count is correct");
+
+	test_assert(map.lower_bound(2000)->key == 5000, "Lower bound skips empty leaves");
+
+	auto it = map.lower_bound(5000);
+	--it;
+	test_assert(it->key == 1999, "Decrement skips empty leaves");
+
+	for (uint32_t i = 2000; i < 5000; i++) {
+		map.insert(i, i);
+	}
+	test_assert(map.find(3000)->val == 3000, "Reinserted to the emptied leaves");
+
+	it = map.erase(map.begin());
+	test_assert(it == map.begin() && it->key == 2, "Erase returns the next element");
+}
+
+test_case(btree_map_copy_move)
+{
+	btree_map<uint32_t, uint32_t> map;
+
+	for (uint32_t i = 0; i < 1000; i++) {
+		map.insert(1000 - i, i);
+	}
+
+	btree_map<uint32_t, uint32_t> copy = map;
+	btree_map<uint32_t, uint32_t> moved = std::move(map);
+
+	test_assert(map.count == 0 && map.begin() == map.end(), "Moved from is empty");
+	test_assert(copy.count == 1000, "Copied all entries");
+
+	for (auto &pair : copy) {
+		test_assert(moved.find(pair.key)->val == pair.val, "Found value in the moved map");
+	}
+}
+
+test_case(btree_map_non_pod)
+{
+	{
+		btree_map<counter, counter> map;
+
+		for (int i = 0; i < 1000; i++) {
+			map.insert(counter(999 - i), counter(i * 2));
+		}
+
+		for (int i = 0; i < 1000; i += 2) {
+			map.erase(counter(i));
+		}
+
+		btree_map<counter, counter> copy = map;
+
+		for (int i = 0; i < 1000; i++) {
+			auto it = copy.find(counter(i));
+			if (i % 2 == 0) {
+				test_assert(it == copy.end(), "Did not find erased keys");
+			} else {
+				test_assert(it != copy.end() && it->val.value == (999 - i) * 2, "Found the rest of the keys");
+			}
+		}
+
+		map.clear();
+		test_assert(map.find(counter(1)) == map.end(), "Can't find after clear");
+		map.insert(counter(1), counter(2));
+	}
+
+	test_assert(counts.ctor == counts.dtor, "Objects destroyed");
+}
+
+test_case(btree_map_alias_key)
+{
+	typedef btree_map<std::string, int> string_map;
+	uint32_t const num = string_map::leaf_capacity;
+
+	// Filling the root leaf makes the next insert split it, relocating the
+	// entries the key refers to
+	for (uint32_t i = 0; i < num; i++) {
+		string_map map;
+		for (uint32_t j = 0; j < num; j++) {
+			map.insert(std::to_string(j), (int)j);
+		}
+
+		auto it = map.find(std::to_string(i));
+		map[it->key] += 1;
+		it = map.find(std::to_string(i));
+		test_assert(!map.insert(it->key, it->val + 1), "Key already exists");
+
+		test_assert(map.count == num, "No entries added");
+		for (uint32_t j = 0; j < num; j++) {
+			it = map.find(std::to_string(j));
+			test_assert(it != map.end() && it->val == (int)(i == j ? j + 2 : j), "Values updated in place");
+		}
+	}
+}
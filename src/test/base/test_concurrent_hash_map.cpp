@@ -0,0 +1,157 @@
+#include <test/test.h>
+#include <base/concurrent_hash_map.h>
+#include <thread>
+#include <vector>
+
+test_case(concurrent_hash_map_simple)
+{
+	concurrent_hash_map<uint32_t, uint32_t> map;
+
+	for (uint32_t i = 0; i < 1000; i++) {
+		test_assert(map.insert(i, i * 2), "Inserted new key");
+	}
+	test_assert(!map.insert(10, 0), "Existing key is not replaced");
+	test_assert(map.size() == 1000, "Size is correct");
+
+	for (uint32_t i = 0; i < 1000; i++) {
+		uint32_t val;
+		test_assert(map.find(i, val) && val == i * 2, "Found value");
+	}
+	test_assert(!map.contains(5000), "Trying to find element that doesn't exist");
+
+	test_assert(!map.insert_or_assign(10, 7), "Assigned over existing key");
+	test_assert(map.find_or_insert(10, 0) == 7, "Found assigned value");
+	test_assert(map.find_or_insert(5000, 9) == 9, "Inserted missing value");
+
+	for (uint32_t i = 0; i < 1000; i += 2) {
+		test_assert(map.erase(i), "Found key to erase");
+	}
+	test_assert(!map.erase(0), "Can't erase twice");
+	test_assert(map.size() == 501, "Size after erase");
+	test_assert(!map.contains(0) && map.contains(1), "Erased the right keys");
+
+	map.reclaim();
+	test_assert(map.contains(999), "Tables are intact after reclaim");
+}
+
+test_case(concurrent_hash_map_threads)
+{
+	const uint32_t num_threads = 4;
+	const uint32_t num_keys = 20000;
+
+	concurrent_hash_map<uint32_t, uint32_t> map(2);
+	std::atomic<uint32_t> bad_reads(0);
+	std::atomic<uint32_t> writers_done(0);
+	std::vector<std::thread> threads;
+
+	// Writers insert disjoint keys while readers check that every value they
+	// see is consistent with its key
+	for (uint32_t t = 0; t < num_threads; t++) {
+		threads.emplace_back([&, t]() {
+			for (uint32_t i = t; i < num_keys; i += num_threads) {
+				map.insert(i, i * 3 + 1);
+			}
+			writers_done++;
+		});
+		threads.emplace_back([&]() {
+			while (writers_done.load() < num_threads) {
+				for (uint32_t i = 0; i < num_keys; i += 7) {
+					uint32_t val;
+					if (map.find(i, val) && val != i * 3 + 1)
+						bad_reads++;
+				}
+			}
+		});
+	}
+
+	for (auto &thread : threads) {
+		thread.join();
+	}
+
+	test_assert(bad_reads.load() == 0, "Readers never see torn values");
+	test_assert(map.size() == num_keys, "All keys inserted");
+
+	for (uint32_t i = 0; i < num_keys; i++) {
+		uint32_t val;
+		test_assert(map.find(i, val) && val == i * 3 + 1, "Found value");
+	}
+}
+
+test_case(concurrent_hash_map_first_insert_wins)
+{
+	const uint32_t num_threads = 4;
+	const uint32_t num_keys = 5000;
+
+	concurrent_hash_map<uint32_t, uint32_t> map;
+	std::vector<uint32_t> results[num_threads];
+	std::vector<std::thread> threads;
+
+	for (uint32_t t = 0; t < num_threads; t++) {
+		threads.emplace_back([&, t]() {
+			for (uint32_t i = 0; i < num_keys; i++) {
+				results[t].push_back(map.find_or_insert(i, t));
+			}
+		});
+	}
+
+	for (auto &thread : threads) {
+		thread.join();
+	}
+
+	for (uint32_t i = 0; i < num_keys; i++) {
+		uint32_t val;
+		map.find(i, val);
+		for (uint32_t t = 0; t < num_threads; t++) {
+			test_assert(results[t][i] == val, "Every thread got the winning value");
+		}
+	}
+}
+
+test_case(concurrent_hash_map_erase_threads)
+{
+	const uint32_t num_threads = 4;
+	const uint64_t num_keys = 4000;
+
+	concurrent_hash_map<uint64_t, uint64_t> map(1);
+	std::atomic<uint32_t> bad_reads(0);
+	std::atomic<uint32_t> writers_done(0);
+	std::vector<std::thread> threads;
+
+	// Writers keep erasing and reassigning their keys, shifting entries
+	// around under the readers
+	for (uint32_t t = 0; t < num_threads; t++) {
+		threads.emplace_back([&, t]() {
+			for (uint32_t round = 0; round < 4; round++) {
+				for (uint64_t i = t; i < num_keys; i += num_threads) {
+					map.insert_or_assign(i << 32 | i, ~i);
+				}
+				for (uint64_t i = t; i < num_keys; i += num_threads * 2) {
+					map.erase(i << 32 | i);
+				}
+			}
+			writers_done++;
+		});
+		threads.emplace_back([&]() {
+			while (writers_done.load() < num_threads) {
+				for (uint64_t i = 0; i < num_keys; i += 3) {
+					uint64_t val;
+					if (map.find(i << 32 | i, val) && val != ~i)
+						bad_reads++;
+				}
+			}
+		});
+	}
+
+	for (auto &thread : threads) {
+		thread.join();
+	}
+
+	test_assert(bad_reads.load() == 0, "Readers never see torn values");
+	test_assert(map.size() == num_keys / 2, "Every other key erased");
+
+	for (uint64_t i = 0; i < num_keys; i++) {
+		uint64_t val;
+		bool const erased = i % (num_threads * 2) < num_threads;
+		test_assert(map.find(i << 32 | i, val) == !erased, "Found the keys that weren't erased");
+	}
+}
@@ -0,0 +1,151 @@
+#include <test/test.h>
+#include <base/flat_map.h>
+
+test_case(flat_map_sorted_iteration)
+{
+	flat_map<uint32_t, uint32_t> map;
+
+	for (uint32_t i = 0; i < 1000; i++) {
+		map.insert((i * 7919) % 1000, i);
+	}
+
+	test_assert(map.count == 1000, "Count is correct");
+
+	uint32_t i = 0;
+	for (auto pair : map) {
+		test_assert(pair.key == i, "Iterated in key order");
+		test_assert(pair.val * 7919 % 1000 == i, "Value is correct");
+		i++;
+	}
+
+	for (uint32_t i = 0; i < 1000; i++) {
+		auto it = map.find(i);
+		test_assert(it != map.end() && it->key == i, "Found key");
+	}
+
+	test_assert(map.find(5000) == map.end(), "Trying to find element that doesn't exist");
+}
+
+test_case(flat_map_signed_keys)
+{
+	flat_map<int32_t, int32_t> map;
+
+	for (int32_t i = -500; i < 500; i++) {
+		map.insert(i * 3, i);
+	}
+
+	int32_t expected = -1500;
+	for (int32_t i = -1600; i < 1600; i++) {
+		if (i > expected) expected += 3;
+		auto it = map.lower_bound(i);
+		if (expected >= 1500) {
+			test_assert(it == map.end(), "Lower bound past the last key");
+		} else {
+			test_assert(it != map.end() && it->key == expected, "Found lower bound");
+		}
+	}
+
+	auto it = map.upper_bound(3);
+	test_assert(it != map.end() && it->key == 6, "Found upper bound");
+}
+
+test_case(flat_map_unsigned_order)
+{
+	flat_map<uint32_t, int> map;
+
+	map.insert(0x80000001U, 2);
+	map.insert(1U, 0);
+	map.insert(0xffffffffU, 3);
+	map.insert(0x7fffffffU, 1);
+
+	int i = 0;
+	for (auto pair : map) {
+		test_assert(pair.val == i, "High bit keys sort after the rest");
+		i++;
+	}
+
+	test_assert(map.lower_bound(0x80000000U)->val == 2, "Lower bound over the sign bit");
+}
+
+test_case(flat_map_overwrite_and_erase)
+{
+	flat_map<uint32_t, uint32_t> map;
+
+	for (uint32_t i = 0; i < 100; i++) {
+		map[i] = i * 10;
+	}
+
+	bool inserted = map.insert(50, 51);
+	test_assert(!inserted, "Insert over existing key");
+	test_assert(map.find(50)->val == 51, "Overwrote the value");
+
+	for (uint32_t i = 0; i < 100; i += 3) {
+		bool found = map.erase(i);
+		test_assert(found, "Found key to erase");
+	}
+
+	test_assert(!map.erase(0), "Erased key is gone");
+	test_assert(map.count == 66, "Count is correct");
+
+	for (uint32_t i = 0; i < 100; i++) {
+		auto it = map.find(i);
+		if (i % 3 == 0) {
+			test_assert(it == map.end(), "Did not find erased keys");
+		} else {
+			test_assert(it != map.end() && it->key == i, "Found the rest of the keys");
+		}
+	}
+
+	auto it = map.erase(map.begin());
+	test_assert(it == map.begin() && it->key == 2, "Erase returns the next element");
+}
+
+test_case(flat_map_copy_move)
+{
+	flat_map<uint32_t, uint32_t> map;
+
+	for (uint32_t i = 0; i < 100; i++) {
+		map.insert(100 - i, i);
+	}
+
+	flat_map<uint32_t, uint32_t> copy = map;
+	flat_map<uint32_t, uint32_t> moved = std::move(map);
+
+	test_assert(map.count == 0, "Moved from is empty");
+
+	for (auto pair : copy) {
+		test_assert(moved.find(pair.key)->val == pair.val, "Found value in the moved map");
+	}
+}
+
+test_case(flat_map_non_pod)
+{
+	{
+		flat_map<counter, counter> map;
+
+		for (int i = 0; i < 100; i++) {
+			map.insert(counter(99 - i), counter(i * 2));
+		}
+
+		for (int i = 0; i < 100; i += 2) {
+			map.erase(counter(i));
+		}
+
+		flat_map<counter, counter> copy = map;
+
+		for (int i = 0; i < 100; i++) {
+			auto it = copy.find(counter(i));
+			if (i % 2 == 0) {
+				test_assert(it == copy.end(), "Did not find erased keys");
+			} else {
+				test_assert(it != copy.end() && it->val.value == (99 - i) * 2, "Found the rest of the keys");
+			}
+		}
+
+		map.clear();
+		test_assert(map.find(counter(1)) == map.end(), "Can't find after clear");
+		map.insert(counter(1), counter(2));
+	}
+
+	test_assert(counts.ctor == counts.dtor, "Objects destroyed");
+}
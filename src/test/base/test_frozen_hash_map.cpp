@@ -0,0 +1,92 @@
+#include <test/test.h>
+#include <base/frozen_hash_map.h>
+#include <stdio.h>
+
+namespace {
+
+struct int_hash {
+	uhash operator()(int i) {
+		return i * 13213;
+	}
+};
+
+}
+
+test_case(frozen_hash_map_memory_image)
+{
+	hash_map<int, int, int_hash> map;
+
+	for (int i = 0; i < 1000; i++) {
+		map.insert(i, i * i);
+	}
+
+	size_t size = hash_image_size(map);
+	void *image = mem::alloc(size, 64);
+	write_hash_image(map, image);
+
+	frozen_hash_map<int, int, int_hash> frozen;
+	bool ok = frozen.load(image, size);
+	test_assert(ok, "Loaded image");
+	test_assert(frozen.count == 1000, "Count is correct");
+
+	for (int i = 0; i < 1000; i++) {
+		const int *val = frozen.find(i);
+		test_assert(val && *val == i * i, "Found value");
+	}
+
+	test_assert(frozen.find(5000) == nullptr, "Trying to find element that doesn't exist");
+
+	frozen_hash_map<int, int64_t, int_hash> wrong_type;
+	test_assert(!wrong_type.load(image, size), "Refuse image with different entry size");
+	test_assert(!frozen.load(image, size - 1), "Refuse truncated image");
+
+	// `count * 2` would wrap around in 32 bits
+	hash_image_header *h = (hash_image_header*)image;
+	h->count = 0x80000001U;
+	test_assert(!frozen.load(image, size), "Refuse count larger than the table");
+
+	mem::free(image);
+}
+
+test_case(frozen_hash_map_empty)
+{
+	hash_map<int, int, int_hash> map;
+
+	size_t size = hash_image_size(map);
+	void *image = mem::alloc(size, 64);
+	write_hash_image(map, image);
+
+	frozen_hash_map<int, int, int_hash> frozen;
+	test_assert(frozen.load(image, size), "Loaded image");
+	test_assert(frozen.find(1) == nullptr, "Empty image has no keys");
+
+	mem::free(image);
+}
+
+test_case(frozen_hash_set_file)
+{
+	const char *path = "test_frozen_hash_set.bin";
+
+	{
+		hash_set<int, int_hash> set;
+
+		for (int i = 0; i < 1000; i += 2) {
+			set.insert(i);
+		}
+
+		bool saved = save_hash_image(set, path);
+		test_assert(saved, "Saved image");
+	}
+
+	{
+		frozen_hash_set<int, int_hash> frozen;
+		bool opened = frozen.open(path);
+		test_assert(opened, "Mapped image");
+
+		for (int i = 0; i < 1000; i++) {
+			test_assert(frozen.contains(i) == (i % 2 == 0), "Found only inserted keys");
+		}
+	}
+
+	remove(path);
+}
@@ -0,0 +1,122 @@
+#include <test/test.h>
+#include <base/hash_map.h>
+#include <stdio.h>
+
+namespace {
+
+// Fraction of inputs where flipping an input bit flips each output bit should be close to half
+template <typename Func>
+bool avalanche_ok(Func func, uint32_t input_bits, uint32_t output_bits)
+{
+	const uint32_t num_samples = 2000;
+	uint32_t flips[64][64] = { };
+
+	uint64_t state = 0x123456789abcdefULL;
+	for (uint32_t s = 0; s < num_samples; s++) {
+		state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+		uint64_t input = state ^ (state >> 29);
+		if (input_bits < 64) input &= (1ULL << input_bits) - 1;
+
+		uint64_t base = func(input);
+		for (uint32_t i = 0; i < input_bits; i++) {
+			uint64_t diff = base ^ func(input ^ (1ULL << i));
+			for (uint32_t o = 0; o < output_bits; o++) {
+				flips[i][o] += (uint32_t)(diff >> o) & 1;
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < input_bits; i++) {
+		for (uint32_t o = 0; o < output_bits; o++) {
+			double p = (double)flips[i][o] / (double)num_samples;
+			if (p < 0.4 || p > 0.6) return false;
+		}
+	}
+	return true;
+}
+
+enum class color { red, green, blue };
+
+}
+
+test_case(hash_mul128)
+{
+	uint64_t a = ~0ULL, b = ~0ULL;
+	hash_mul128(a, b);
+	test_assert(a == 1 && b == ~0ULL - 1, "Max product");
+
+	a = 0x123456789ULL, b = 0x100000000ULL;
+	hash_mul128(a, b);
+	test_assert(a == 0x2345678900000000ULL && b == 0x1, "Shifted product");
+}
+
+test_case(hash_int_avalanche)
+{
+	test_assert(avalanche_ok([](uint64_t x) { return (uint64_t)hash_int32((uint32_t)x); }, 32, 32), "hash_int32 avalanche");
+	test_assert(avalanche_ok([](uint64_t x) { return hash_int64(x); }, 64, 64), "hash_int64 avalanche");
+}
+
+test_case(hash_bytes_avalanche)
+{
+	// Single byte inputs have too few distinct values for the sampled bounds
+	for (uint32_t size = 2; size <= 8; size++) {
+		bool ok = avalanche_ok([=](uint64_t x) { return hash_bytes64(&x, size); }, size * 8, 64);
+		test_assert(ok, "hash_bytes avalanche");
+	}
+
+	uint8_t buf[100] = { };
+	bool ok = avalanche_ok([&](uint64_t x) {
+		memcpy(buf + 37, &x, sizeof(x));
+		return hash_bytes64(buf, sizeof(buf));
+	}, 64, 64);
+	test_assert(ok, "hash_bytes avalanche in a long input");
+}
+
+test_case(hash_bytes_lengths)
+{
+	char buf[128];
+	for (uint32_t i = 0; i < sizeof(buf); i++) {
+		buf[i] = (char)i;
+	}
+
+	hash_set<uint64_t> seen;
+	for (uint32_t size = 0; size <= sizeof(buf); size++) {
+		uint64_t hash = hash_bytes64(buf, size);
+		test_assert(hash == hash_bytes64(buf, size), "Hash is deterministic");
+		test_assert(hash != hash_bytes64(buf, size, 1), "Seed changes the hash");
+		test_assert(seen.insert(hash), "Prefixes hash differently");
+	}
+}
+
+test_case(default_hash_keys)
+{
+	hash_map<int, int> ints;
+	hash_map<uint64_t, int> longs;
+	hash_map<const int*, int> pointers;
+	hash_map<color, int> colors;
+	hash_map<string_ref, int> strings;
+
+	int values[100];
+	char names[100][8];
+	for (int i = 0; i < 100; i++) {
+		ints.insert(-i, i);
+		longs.insert((uint64_t)i << 40, i);
+		pointers.insert(&values[i], i);
+		sprintf(names[i], "n%d", i);
+		strings.insert(string_ref(names[i]), i);
+	}
+	colors.insert(color::green, 1);
+
+	for (int i = 0; i < 100; i++) {
+		char name[8];
+		sprintf(name, "n%d", i);
+
+		test_assert(ints.find(-i)->val == i, "Found int");
+		test_assert(longs.find((uint64_t)i << 40)->val == i, "Found uint64_t");
+		test_assert(pointers.find(&values[i])->val == i, "Found pointer");
+		test_assert(strings.find(string_ref(name))->val == i, "Found string by content");
+	}
+
+	test_assert(colors.find(color::green) != colors.end(), "Found enum");
+	test_assert(colors.find(color::red) == colors.end(), "Didn't find missing enum");
+}
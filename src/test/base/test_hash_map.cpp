@@ -1,5 +1,6 @@
 #include <test/test.h>
 #include <base/hash_map.h>
+#include <base/linear_allocator.h>
 #include <stdint.h>
 
 uint32_t hash_count;
@@ -49,4 +50,406 @@ struct int_hash {
 
 }
 
+// Run the same tests on tables with 64-bit sizes and hashes
+namespace wide {
 
+template <typename Key, typename Val, typename Hash>
+using hash_map = ::hash_map<Key, Val, Hash, uint64_t>;
+
+template <typename Key, typename Hash>
+using hash_set = ::hash_set<Key, Hash, uint64_t>;
+
+struct int_hash {
+	uint64_t operator()(int i) {
+		return (uint64_t)i * 0x9e3779b97f4a7c15ULL;
+	}
+};
+
+#undef test_tag
+#define test_tag "wide"
+
+#include "test_hash_map_impl.h"
+
+}
+
+#undef test_tag
+#define test_tag ""
+
+struct relocatable_counter {
+	uint32_t value;
+
+	struct hash {
+		uhash operator()(const relocatable_counter& c) {
+			return c.value * 13213;
+		}
+	};
+
+	// Everything collides at the last slot so probe runs wrap around the table
+	struct wrap_hash {
+		uhash operator()(const relocatable_counter& c) {
+			return ~0U;
+		}
+	};
+
+	bool operator==(const relocatable_counter &rc) const
+	{
+		return value == rc.value;
+	}
+
+	explicit relocatable_counter(uint32_t v)
+		: value(v)
+	{
+		counts.ctor++;
+	}
+
+	relocatable_counter(const relocatable_counter &o)
+		: value(o.value)
+	{
+		counts.ctor++;
+		counts.copy++;
+	}
+
+	relocatable_counter(relocatable_counter &&o)
+		: value(o.value)
+	{
+		o.value = ~0U;
+		counts.ctor++;
+		counts.move++;
+	}
+
+	~relocatable_counter()
+	{
+		counts.dtor++;
+	}
+};
+
+template <>
+struct is_trivially_relocatable<relocatable_counter> : std::true_type
+{
+};
+
+test_case(hash_map_relocatable_rehash)
+{
+	{
+		hash_map<relocatable_counter, uint32_t, relocatable_counter::hash> map;
+
+		for (uint32_t i = 0; i < 100; i++) {
+			map.insert(relocatable_counter(i), i * 2);
+		}
+
+		test_assert(counts.move == 100, "Rehash doesn't move construct");
+		test_assert(counts.dtor == 100, "Rehash doesn't destruct");
+
+		for (uint32_t i = 0; i < 100; i++) {
+			auto it = map.find(relocatable_counter(i));
+			test_assert(it != map.end() && it->val == i * 2, "Found value");
+		}
+	}
+
+	test_assert(counts.copy == 0, "No extra copies");
+	test_assert(counts.ctor == counts.dtor, "Objects destroyed");
+}
+
+test_case(hash_map_relocatable_erase_wrap)
+{
+	{
+		hash_map<relocatable_counter, uint32_t, relocatable_counter::wrap_hash> map;
+
+		for (uint32_t i = 0; i < 10; i++) {
+			map.insert(relocatable_counter(i), i * 2);
+		}
+
+		uint32_t moves = counts.move;
+
+		for (uint32_t j = 0; j < 10; j++) {
+			bool found = map.erase(relocatable_counter(j));
+			test_assert(found, "Found key to erase");
+			test_assert(map.count == 10 - j - 1, "Count is correct");
+
+			for (uint32_t i = 0; i < 10; i++) {
+				auto it = map.find(relocatable_counter(i));
+				if (i <= j) {
+					test_assert(it == map.end(), "Did not find deleted keys");
+				} else {
+					test_assert(it != map.end() && it->val == i * 2, "Found the rest of the keys");
+				}
+			}
+		}
+
+		test_assert(counts.move == moves, "Erase doesn't move construct");
+	}
+
+	test_assert(counts.copy == 0, "No extra copies");
+	test_assert(counts.ctor == counts.dtor, "Objects destroyed");
+}
+
+test_case(hash_map_relocatable_erase_if_wrap)
+{
+	{
+		hash_map<relocatable_counter, uint32_t, relocatable_counter::wrap_hash> map;
+
+		for (uint32_t i = 0; i < 10; i++) {
+			map.insert(relocatable_counter(i), i * 2);
+		}
+
+		uint32_t num_calls = 0;
+		map.erase_if([&](map_key_val<const relocatable_counter, uint32_t> &kv) {
+			num_calls++;
+			return kv.key.value % 2 == 0;
+		});
+
+		test_assert(num_calls == 10, "Predicate called once per element");
+		test_assert(map.count == 5, "Count is correct");
+
+		for (uint32_t i = 0; i < 10; i++) {
+			auto it = map.find(relocatable_counter(i));
+			if (i % 2 == 0) {
+				test_assert(it == map.end(), "Did not find erased keys");
+			} else {
+				test_assert(it != map.end() && it->val == i * 2, "Found the rest of the keys");
+			}
+		}
+	}
+
+	test_assert(counts.ctor == counts.dtor, "Objects destroyed");
+}
+
+test_case(hash_map_stats_bad_hash)
+{
+	hash_map<int, int, bad::int_hash> map;
+
+	for (int i = 0; i < 100; i++) {
+		map.insert(i, i);
+	}
+
+	hash_stats s = map.stats();
+	test_assert(s.max_probe == 99, "Every key probes from slot zero");
+	test_assert(s.mean_probe == 99.0 / 2.0, "Mean probe of a single run");
+	test_assert(s.probe_histogram[0] == 1, "Only one entry in its ideal slot");
+	test_assert(s.probe_histogram[hash_stats::histogram_size - 1] == 100 - 15, "Long probes are in the last bucket");
+}
+
+test_case(hash_map_seeds_differ)
+{
+	hash_map<int, int> a, b;
+	test_assert(a.seed != b.seed, "Tables have different seeds");
+
+	for (int i = 0; i < 100; i++) {
+		a.insert(i, i * 2);
+	}
+
+	hash_map<int, int> c = a;
+	test_assert(c.seed == a.seed, "Copies keep the seed");
+	for (int i = 0; i < 100; i++) {
+		auto it = c.find(i);
+		test_assert(it != c.end() && it->val == i * 2, "Found value in copy");
+	}
+}
+
+test_case(hash_map_reseed_hostile_keys)
+{
+	hash_map<int, int, hostile_hash> map;
+	hostile_seed = map.seed;
+
+	for (int i = 0; i < 1000; i++) {
+		map.insert(i, i * 2);
+	}
+
+	test_assert(map.seed != hostile_seed, "Table was reseeded");
+	test_assert(map.count == 1000, "All keys inserted");
+
+	hash_stats s = map.stats();
+	test_assert(s.max_probe <= hash_probe_limit, "Probes are short after reseeding");
+
+	for (int i = 0; i < 1000; i++) {
+		auto it = map.find(i);
+		test_assert(it != map.end() && it->val == i * 2, "Found value");
+	}
+}
+
+test_case(hash_set_reseed_hostile_keys)
+{
+	hash_set<int, hostile_hash> set;
+	hostile_seed = set.seed;
+
+	for (int i = 0; i < 1000; i++) {
+		set.insert(i);
+	}
+
+	test_assert(set.seed != hostile_seed, "Table was reseeded");
+	test_assert(set.stats().max_probe <= hash_probe_limit, "Probes are short after reseeding");
+	for (int i = 0; i < 1000; i++) {
+		test_assert(set.find(i) != set.end(), "Found key");
+	}
+}
+
+test_case(hash_map_wide_hashes)
+{
+	hash_map<uint64_t, uint64_t, default_hash<uint64_t>, uint64_t> map;
+
+	for (uint64_t i = 0; i < 1000; i++) {
+		map.insert(i << 32, i);
+	}
+
+	bool high_bits = false;
+	for (uint64_t i = 0; i < map.capacity; i++) {
+		if (map.hbuf[i] > UINT32_MAX)
+			high_bits = true;
+	}
+	test_assert(high_bits, "Stored hashes keep the high bits");
+
+	for (uint64_t i = 0; i < 1000; i++) {
+		auto it = map.find(i << 32);
+		test_assert(it != map.end() && it->val == i, "Found value");
+	}
+
+	test_assert(next_pow2((uint64_t)1 << 40 | 1) == (uint64_t)1 << 41, "64-bit next_pow2");
+}
+
+test_case(hash_map_arena_presized)
+{
+	linear_allocator arena;
+	hash_map<int, int> map(1000, &arena);
+	size_t used = arena.pos;
+
+	for (int i = 0; i < 1000; i++) {
+		map.insert(i, i);
+	}
+
+	test_assert(arena.pos == used, "Presized table didn't grow");
+	test_assert(used <= map.stats().memory_used + 64, "Arena only holds the final table");
+}
+
+test_case(hash_map_arena_grow_in_place)
+{
+	linear_allocator arena;
+	hash_map<int, int> map;
+	map.ator = &arena;
+
+	// Small enough that every generation fits in the first block of the arena
+	for (int i = 0; i < 150; i++) {
+		map.insert(i, i * 2);
+	}
+
+	test_assert(map.count == 150, "Count is correct");
+	test_assert(arena.pos <= map.stats().memory_used + 64, "Arena only holds the final table");
+	for (int i = 0; i < 150; i++) {
+		auto it = map.find(i);
+		test_assert(it != map.end() && it->val == i * 2, "Found value");
+	}
+}
+
+test_case(hash_map_arena_build_from_range)
+{
+	map_key_val<int, int> entries[1000];
+	for (int i = 0; i < 1000; i++) {
+		entries[i].key = i;
+		entries[i].val = i * 2;
+	}
+
+	linear_allocator arena;
+	hash_map<int, int> map(entries, entries + 1000, &arena);
+
+	test_assert(map.count == 1000, "Count is correct");
+	test_assert(arena.pos <= map.stats().memory_used + 64, "Arena only holds the final table");
+	for (int i = 0; i < 1000; i++) {
+		auto it = map.find(i);
+		test_assert(it != map.end() && it->val == i * 2, "Found value");
+	}
+
+	hash_map<int, int> copy(map.begin(), map.end());
+	test_assert(copy.count == 1000 && copy.find(500)->val == 1000, "Built from another map");
+
+	int keys[] = { 3, 1, 4, 1, 5, 9, 2, 6 };
+	hash_set<int> set(keys, keys + 8, &arena);
+	test_assert(set.count == 7, "Duplicate keys are merged");
+	test_assert(set.find(9) != set.end(), "Found key");
+}
+
+test_case(hash_map_clear_reuses_buffer)
+{
+	linear_allocator arena;
+	hash_map<int, int> map;
+	map.ator = &arena;
+
+	for (int i = 0; i < 100; i++) {
+		map.insert(i, i);
+	}
+
+	void *buffer = map.kvbuf;
+	size_t used = arena.pos;
+	map.clear();
+
+	for (int i = 0; i < 100; i++) {
+		map.insert(i, i);
+	}
+
+	test_assert(map.kvbuf == buffer, "Reused the buffer after clear");
+	test_assert(arena.pos == used, "No new allocations after clear");
+	test_assert(map.find(50) != map.end(), "Found value");
+}
+
+namespace {
+
+// Keys are indices to `names`, looked up by the string without creating a key
+const char *const names[] = { "alpha", "beta", "gamma", "delta", "epsilon" };
+
+struct name_key
+{
+	uint32_t index;
+
+	bool operator==(const name_key &rhs) const { return index == rhs.index; }
+};
+
+struct name_lookup
+{
+	const char *str;
+
+	bool operator==(const name_key &key) const { return !strcmp(str, names[key.index]); }
+};
+
+struct name_hash
+{
+	uint64_t operator()(const name_key &key) const { return hash_bytes64(names[key.index], strlen(names[key.index])); }
+	uint64_t operator()(const name_lookup &l) const { return hash_bytes64(l.str, strlen(l.str)); }
+};
+
+}
+
+test_case(hash_set_heterogeneous)
+{
+	hash_set<name_key, name_hash> set;
+	uint32_t num = sizeof(names) / sizeof(*names);
+
+	for (uint32_t i = 0; i < num; i++) {
+		const name_key *key;
+		bool inserted = set.insert_as(name_lookup{ names[i] }, [&]() { return name_key{ i }; }, key);
+		test_assert(inserted && key->index == i, "Inserted by string");
+	}
+
+	const name_key *key;
+	bool inserted = set.insert_as(name_lookup{ "gamma" }, [&]() { return name_key{ 99 }; }, key);
+	test_assert(!inserted && key->index == 2, "Found the existing key");
+
+	char buf[16];
+	strcpy(buf, "delta");
+	test_assert(set.find_as(name_lookup{ buf })->index == 3, "Found by string");
+	test_assert(set.find_as(name_lookup{ "zeta" }) == set.end(), "Missing string");
+	test_assert(set.find(name_key{ 4 }) != set.end(), "Found by key");
+}
+
+#if p_hash_counters
+
+test_case(hash_map_rehash_counters)
+{
+	hash_map<int, int, ok::int_hash> map;
+
+	for (int i = 0; i < 100; i++) {
+		map.insert(i, i);
+	}
+
+	hash_stats s = map.stats();
+	test_assert(s.rehash_count == 6, "Rehashed at 0, 4, 8, 16, 32 and 64 entries");
+}
+
+#endif
@@ -42,6 +42,21 @@ struct operator_counter {
 		counts.move++;
 	}
 
+	operator_counter &operator=(const operator_counter &o)
+	{
+		value = o.value;
+		counts.copy_assign++;
+		return *this;
+	}
+
+	operator_counter &operator=(operator_counter &&o)
+	{
+		value = o.value;
+		o.value = ~0U;
+		counts.move_assign++;
+		return *this;
+	}
+
 	~operator_counter()
 	{
 		counts.dtor++;
@@ -386,6 +401,112 @@ test_case(hash_map_non_pod_insert_over)
 	test_assert(counts.ctor == counts.dtor, "Objects destroyed");
 }
 
+test_case(hash_map_non_pod_emplace)
+{
+	hash_count = 0;
+
+	{
+		hash_map<operator_counter, operator_counter, operator_counter::hash> map;
+		bool inserted = map.emplace(operator_counter(1), 2U);
+		test_assert(inserted, "Emplace new key");
+		test_assert(counts.move == 1, "Key moved, value constructed in place");
+		test_assert(counts.ctor == 3, "Only key, moved key and value constructed");
+
+		inserted = map.emplace(operator_counter(1), 3U);
+		test_assert(!inserted, "Emplace existing key");
+		test_assert(counts.move == 1, "Value replaced in place");
+		test_assert(counts.move_assign == 0 && counts.copy_assign == 0, "No assignments");
+
+		auto it = map.find(operator_counter(1));
+		test_assert(it != map.end() && it->val.value == 3, "Value replaced");
+	}
+
+	test_assert(counts.defa == 0, "No extra default initialization");
+	test_assert(counts.copy == 0, "No extra copies");
+	test_assert(counts.move == 1, "No extra moves");
+	test_assert(hash_count == 3, "No extra hashes");
+	test_assert(counts.ctor == counts.dtor, "Objects destroyed");
+}
+
+test_case(hash_map_non_pod_try_emplace)
+{
+	hash_count = 0;
+
+	{
+		hash_map<operator_counter, operator_counter, operator_counter::hash> map;
+		bool inserted = map.try_emplace(operator_counter(1), 2U);
+		test_assert(inserted, "Try emplace new key");
+		test_assert(counts.ctor == 3, "Only key, moved key and value constructed");
+
+		operator_counter v(3);
+		inserted = map.try_emplace(operator_counter(1), std::move(v));
+		test_assert(!inserted, "Try emplace existing key");
+		test_assert(v.value == 3, "Value not moved from if the key exists");
+		test_assert(counts.move == 1, "Existing value not touched");
+
+		auto it = map.find(operator_counter(1));
+		test_assert(it != map.end() && it->val.value == 2, "Value not replaced");
+	}
+
+	test_assert(counts.defa == 0, "No extra default initialization");
+	test_assert(counts.copy == 0, "No extra copies");
+	test_assert(counts.move == 1, "No extra moves");
+	test_assert(counts.move_assign == 0 && counts.copy_assign == 0, "No assignments");
+	test_assert(hash_count == 3, "No extra hashes");
+	test_assert(counts.ctor == counts.dtor, "Objects destroyed");
+}
+
+test_case(hash_map_non_pod_insert_or_assign)
+{
+	hash_count = 0;
+
+	{
+		hash_map<operator_counter, operator_counter, operator_counter::hash> map;
+		bool inserted = map.insert_or_assign(operator_counter(1), operator_counter(2));
+		test_assert(inserted, "Insert new key");
+		test_assert(counts.move == 2, "Key and value moved");
+
+		inserted = map.insert_or_assign(operator_counter(1), operator_counter(3));
+		test_assert(!inserted, "Assign existing key");
+		test_assert(counts.move == 2, "No move construction on assign");
+		test_assert(counts.move_assign == 1, "Value move assigned");
+
+		operator_counter v(4);
+		map.insert_or_assign(operator_counter(1), v);
+		test_assert(counts.copy_assign == 1, "Value copy assigned");
+
+		auto it = map.find(operator_counter(1));
+		test_assert(it != map.end() && it->val.value == 4, "Value assigned");
+	}
+
+	test_assert(counts.defa == 0, "No extra default initialization");
+	test_assert(counts.copy == 0, "No extra copies");
+	test_assert(counts.move == 2, "No extra moves");
+	test_assert(hash_count == 4, "No extra hashes");
+	test_assert(counts.ctor == counts.dtor, "Objects destroyed");
+}
+
+test_case(hash_map_non_pod_insert_ptr)
+{
+	hash_count = 0;
+
+	{
+		hash_map<int, operator_counter, int_hash> map;
+		operator_counter *val;
+		bool inserted = map.insert_ptr(1, val);
+		test_assert(inserted && val->value == 0x1234abcd, "Default constructed on insert");
+		val->value = 5;
+
+		inserted = map.insert_ptr(1, val);
+		test_assert(!inserted && val->value == 5, "Existing value returned");
+	}
+
+	test_assert(counts.defa == 1, "No extra default initialization");
+	test_assert(counts.copy == 0, "No extra copies");
+	test_assert(counts.move == 0, "No extra moves");
+	test_assert(counts.ctor == counts.dtor, "Objects destroyed");
+}
+
 test_case(hash_map_non_pod_erase)
 {
 	hash_count = 0;
@@ -452,3 +573,146 @@ test_case(hash_map_count)
 	test_assert(map.count == 4, "Count is correct");
 }
 
+
+test_case(hash_map_sparse_iteration)
+{
+	hash_map<int, int, int_hash> map;
+
+	for (int i = 0; i < 1000; i++) {
+		map.insert(i, i * i);
+	}
+
+	for (int i = 0; i < 1000; i++) {
+		if (i % 100 != 0)
+			map.erase(i);
+	}
+
+	bool visited[10] = { };
+	uint32_t num = 0;
+	for (const auto &pair : map) {
+		test_assert(pair.key % 100 == 0, "Only remaining keys visited");
+		test_assert(!visited[pair.key / 100], "Visited only once");
+		visited[pair.key / 100] = true;
+		num++;
+	}
+
+	test_assert(num == 10, "Visited every element");
+}
+
+test_case(hash_map_for_each)
+{
+	hash_map<int, int, int_hash> map;
+
+	for (int i = 0; i < 100; i++) {
+		map.insert(i, i);
+	}
+
+	int sum = 0;
+	map.for_each([&](map_key_val<const int, int> &kv) {
+		sum += kv.key;
+		kv.val *= 2;
+	});
+
+	test_assert(sum == 99 * 100 / 2, "Visited every element once");
+	for (int i = 0; i < 100; i++) {
+		test_assert(map[i] == i * 2, "Modified value");
+	}
+}
+
+test_case(hash_map_erase_if)
+{
+	hash_map<int, int, int_hash> map;
+
+	for (int i = 0; i < 1000; i++) {
+		map.insert(i, i * i);
+	}
+
+	uint32_t num_calls = 0;
+	usize num = map.erase_if([&](map_key_val<const int, int> &kv) {
+		num_calls++;
+		return kv.key % 3 != 0;
+	});
+
+	test_assert(num_calls == 1000, "Predicate called once per element");
+	test_assert(num == 666, "Erase count is correct");
+	test_assert(map.count == 334, "Count is correct");
+
+	for (int i = 0; i < 1000; i++) {
+		auto it = map.find(i);
+		if (i % 3 != 0) {
+			test_assert(it == map.end(), "Did not find erased keys");
+		} else {
+			test_assert(it != map.end() && it->val == i * i, "Found the rest of the keys");
+		}
+	}
+}
+
+test_case(hash_map_non_pod_erase_if)
+{
+	{
+		hash_map<operator_counter, operator_counter, operator_counter::hash> map;
+
+		for (uint32_t i = 0; i < 100; i++) {
+			map.insert(operator_counter(i), operator_counter(i));
+		}
+
+		map.erase_if([](map_key_val<const operator_counter, operator_counter> &kv) {
+			return kv.key.value >= 10;
+		});
+
+		test_assert(map.count == 10, "Count is correct");
+		for (uint32_t i = 0; i < 10; i++) {
+			auto it = map.find(operator_counter(i));
+			test_assert(it != map.end() && it->val.value == i, "Found the rest of the keys");
+		}
+	}
+
+	test_assert(counts.defa == 0, "No extra default initialization");
+	test_assert(counts.copy == 0, "No extra copies");
+	test_assert(counts.ctor == counts.dtor, "Objects destroyed");
+}
+
+test_case(hash_set_erase_if)
+{
+	hash_set<int, int_hash> set;
+
+	for (int i = 0; i < 100; i++) {
+		set.insert(i);
+	}
+
+	set.erase_if([](const int &i) { return i >= 50; });
+
+	int sum = 0;
+	set.for_each([&](const int &i) { sum += i; });
+
+	test_assert(set.count == 50, "Count is correct");
+	test_assert(sum == 49 * 50 / 2, "Visited the remaining elements");
+}
+
+test_case(hash_map_stats)
+{
+	hash_map<int, int, int_hash> map;
+
+	hash_stats empty = map.stats();
+	test_assert(empty.count == 0 && empty.capacity == 0, "Empty stats");
+	test_assert(empty.memory_used == 0 && empty.max_probe == 0, "Empty table uses no memory");
+
+	for (int i = 0; i < 100; i++) {
+		map.insert(i, i);
+	}
+
+	hash_stats s = map.stats();
+	test_assert(s.count == 100, "Count is correct");
+	test_assert(s.capacity == map.capacity, "Capacity is correct");
+	test_assert(s.load_factor > 0.0 && s.load_factor <= 0.5, "Load factor is within bounds");
+	test_assert(s.mean_probe <= (double)s.max_probe, "Mean probe is at most max probe");
+	test_assert(s.max_probe < s.capacity, "Max probe is within the table");
+	test_assert(s.memory_used > s.memory_wasted, "Wasted memory is part of used memory");
+	test_assert(s.memory_wasted == (s.capacity - s.count) * (sizeof(int) * 2 + sizeof(*map.hbuf)), "Wasted memory is the empty slots");
+
+	usize total = 0;
+	for (usize i = 0; i < hash_stats::histogram_size; i++) {
+		total += s.probe_histogram[i];
+	}
+	test_assert(total == s.count, "Histogram contains every entry");
+}
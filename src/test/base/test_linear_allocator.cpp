@@ -21,3 +21,44 @@ test_case(test_linear_allocator)
 	}
 }
 
+
+test_case(test_linear_allocator_free_last)
+{
+	linear_allocator a;
+
+	void *first = mem::alloc_using(&a, 100);
+	void *second = mem::alloc_using(&a, 100);
+	size_t pos = a.pos;
+
+	mem::free(first);
+	test_assert(a.pos == pos, "Freeing an older allocation doesn't roll back");
+
+	mem::free(second);
+	test_assert(a.pos < pos - 100, "Freeing the latest allocation rolls it back");
+
+	void *third = mem::alloc_using(&a, 100);
+	test_assert(third == second, "Rolled back space is reused");
+	test_assert(a.pos == pos, "Reused the same space");
+}
+
+test_case(test_linear_allocator_extend)
+{
+	linear_allocator a;
+
+	void *first = mem::alloc_using(&a, 100);
+	test_assert(mem::try_extend(first, 200), "Extended the latest allocation");
+	test_assert(mem::get_size(first) == 200, "Size is updated");
+
+	void *second = mem::alloc_using(&a, 100);
+	test_assert((char*)second >= (char*)first + 200, "Next allocation is after the extended one");
+	test_assert(!mem::try_extend(first, 300), "Can't extend an older allocation");
+	test_assert(!mem::try_extend(second, 1024 * 1024), "Can't extend past the block");
+	test_assert(mem::get_size(second) == 100, "Size is unchanged");
+
+	// The first allocation doesn't end at an aligned position, freeing a
+	// temporary allocated after it also rolls back the padding
+	void *third = mem::alloc_using(&a, 4, 8);
+	void *temp = mem::alloc_using(&a, 100, 8);
+	mem::free(temp);
+	test_assert(mem::try_extend(third, 300), "Extended again after freeing a temporary");
+}
@@ -0,0 +1,141 @@
+#include <test/test.h>
+#include <base/node_hash_map.h>
+
+namespace {
+
+struct int_hash {
+	uhash operator()(int i) {
+		return i * 13213;
+	}
+};
+
+}
+
+test_case(node_hash_map_simple)
+{
+	node_hash_map<int, int, int_hash> map;
+
+	for (int i = 0; i < 1000; i++) {
+		map.insert(i, i * 2);
+	}
+
+	test_assert(map.count == 1000, "Count is correct");
+
+	for (int i = 0; i < 1000; i++) {
+		auto it = map.find(i);
+		test_assert(it != map.end() && it->val == i * 2, "Found value");
+	}
+
+	test_assert(map.find(5000) == map.end(), "Trying to find element that doesn't exist");
+
+	int num = 0;
+	for (auto &pair : map) {
+		test_assert(pair.val == pair.key * 2, "Iterated value is correct");
+		num++;
+	}
+	test_assert(num == 1000, "Iterated every entry");
+}
+
+test_case(node_hash_map_pointer_stability)
+{
+	node_hash_map<int, int> map;
+	int *ptrs[100];
+
+	for (int i = 0; i < 100; i++) {
+		map.insert_ptr(i, ptrs[i]);
+		*ptrs[i] = i;
+	}
+
+	// Grow, erase and reinsert around the existing entries
+	for (int i = 100; i < 2000; i++) {
+		map[i] = i;
+	}
+	for (int i = 100; i < 2000; i += 2) {
+		map.erase(i);
+	}
+	for (int i = 2000; i < 3000; i++) {
+		map.insert(i, i);
+	}
+
+	for (int i = 0; i < 100; i++) {
+		auto it = map.find(i);
+		test_assert(it != map.end() && &it->val == ptrs[i], "Value didn't move");
+		test_assert(*ptrs[i] == i, "Value is intact");
+	}
+}
+
+test_case(node_hash_map_erase)
+{
+	node_hash_map<int, int, int_hash> map;
+
+	for (int i = 0; i < 100; i++) {
+		map.insert(i, i * 10);
+	}
+
+	for (int i = 0; i < 100; i += 3) {
+		test_assert(map.erase(i), "Found key to erase");
+	}
+	test_assert(!map.erase(0), "Can't erase twice");
+
+	usize erased = map.erase_if([](map_key_val<const int, int> &kv) { return kv.key % 3 == 1; });
+	test_assert(erased == 33, "Erased with predicate");
+	test_assert(map.count == 33, "Count is correct");
+
+	for (int i = 0; i < 100; i++) {
+		auto it = map.find(i);
+		if (i % 3 != 2) {
+			test_assert(it == map.end(), "Did not find erased keys");
+		} else {
+			test_assert(it != map.end() && it->val == i * 10, "Found the rest of the keys");
+		}
+	}
+}
+
+test_case(node_hash_map_copy_move)
+{
+	node_hash_map<int, int, int_hash> map;
+
+	for (int i = 0; i < 100; i++) {
+		map.insert(i, i);
+	}
+
+	node_hash_map<int, int, int_hash> copy = map;
+	node_hash_map<int, int, int_hash> moved = std::move(map);
+
+	test_assert(map.count == 0, "Moved from is empty");
+
+	for (int i = 0; i < 100; i++) {
+		auto c = copy.find(i);
+		auto m = moved.find(i);
+		test_assert(c != copy.end() && c->val == i, "Found value in the copy");
+		test_assert(m != moved.end() && m->val == i, "Found value in the moved map");
+		test_assert(&c->val != &m->val, "Copy has its own entries");
+	}
+}
+
+test_case(node_hash_map_non_pod)
+{
+	{
+		node_hash_map<counter, counter, counter::hash> map;
+
+		for (int i = 0; i < 100; i++) {
+			map.insert(counter(i), counter(i * 2));
+		}
+
+		test_assert(counts.move == 200, "Entries are only moved in on insert");
+		test_assert(counts.copy == 0, "No extra copies");
+
+		for (int i = 0; i < 100; i += 2) {
+			map.erase(counter(i));
+		}
+
+		node_hash_map<counter, counter, counter::hash> copy = map;
+		test_assert(counts.copy == 100, "Copied the remaining entries");
+
+		map.clear();
+		test_assert(map.find(counter(1)) == map.end(), "Can't find after clear");
+		map.insert(counter(1), counter(2));
+	}
+
+	test_assert(counts.ctor == counts.dtor, "Objects destroyed");
+}
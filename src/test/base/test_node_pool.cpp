@@ -0,0 +1,38 @@
+#include <test/test.h>
+#include <base/node_pool.h>
+
+test_case(node_pool_alignment)
+{
+	node_pool pool(24, 32);
+
+	for (uint32_t i = 0; i < 100; i++) {
+		void *ptr = pool.alloc();
+		test_assert((uintptr_t)ptr % 32 == 0, "Slot is correctly aligned");
+	}
+}
+
+test_case(node_pool_reuse)
+{
+	node_pool pool(16, 8);
+	void *slots[64];
+
+	for (uint32_t i = 0; i < 64; i++) {
+		slots[i] = pool.alloc();
+		memset(slots[i], (int)i, 16);
+	}
+
+	for (uint32_t i = 0; i < 64; i++) {
+		for (uint32_t j = 0; j < 16; j++) {
+			test_assert(((uint8_t*)slots[i])[j] == i, "Slots don't overlap");
+		}
+	}
+
+	pool.free(slots[10]);
+	pool.free(slots[20]);
+	test_assert(pool.alloc() == slots[20], "Reuses the last freed slot");
+	test_assert(pool.alloc() == slots[10], "Reuses the first freed slot");
+
+	pool.reset();
+	test_assert(pool.blocks == nullptr, "Reset frees the blocks");
+	test_assert(pool.alloc() != nullptr, "Can allocate after reset");
+}
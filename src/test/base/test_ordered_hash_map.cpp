@@ -0,0 +1,168 @@
+#include <test/test.h>
+#include <base/ordered_hash_map.h>
+
+namespace {
+
+struct int_hash {
+	uhash operator()(int i) {
+		return i * 13213;
+	}
+};
+
+}
+
+test_case(ordered_hash_map_insertion_order)
+{
+	ordered_hash_map<int, int, int_hash> map;
+
+	for (int i = 0; i < 1000; i++) {
+		map.insert((i * 7919) % 1000, i);
+	}
+
+	test_assert(map.count == 1000, "Count is correct");
+
+	int i = 0;
+	for (auto &pair : map) {
+		test_assert(pair.key == (i * 7919) % 1000, "Iterated in insertion order");
+		test_assert(pair.val == i, "Value is correct");
+		i++;
+	}
+
+	for (int i = 0; i < 1000; i++) {
+		auto it = map.find((i * 7919) % 1000);
+		test_assert(it != map.end() && it->val == i, "Found value");
+	}
+
+	test_assert(map.find(5000) == map.end(), "Trying to find element that doesn't exist");
+}
+
+test_case(ordered_hash_map_reseed_hostile_keys)
+{
+	ordered_hash_map<int, int, hostile_hash> map;
+	hostile_seed = map.index.seed;
+
+	for (int i = 0; i < 1000; i++) {
+		map.insert(i, i * 2);
+	}
+
+	test_assert(map.index.seed != hostile_seed, "Index was reseeded");
+	test_assert(map.index.stats().max_probe <= hash_probe_limit, "Probes are short after reseeding");
+
+	int i = 0;
+	for (auto &pair : map) {
+		test_assert(pair.key == i && pair.val == i * 2, "Iterated in insertion order");
+		i++;
+	}
+
+	for (int i = 0; i < 1000; i++) {
+		auto it = map.find(i);
+		test_assert(it != map.end() && it->val == i * 2, "Found value");
+	}
+}
+
+test_case(ordered_hash_map_overwrite)
+{
+	ordered_hash_map<int, int, int_hash> map;
+
+	map.insert(3, 30);
+	map.insert(1, 10);
+	map[2] = 20;
+	bool inserted = map.insert(3, 31);
+
+	test_assert(!inserted, "Insert over existing key");
+	test_assert(map.count == 3, "Count is correct");
+	test_assert(map.begin()->key == 3 && map.begin()->val == 31, "Overwrite keeps the position");
+}
+
+test_case(ordered_hash_map_erase)
+{
+	ordered_hash_map<int, int, int_hash> map;
+
+	for (int i = 0; i < 100; i++) {
+		map.insert(i, i * 10);
+	}
+
+	for (int i = 0; i < 100; i += 3) {
+		bool found = map.erase(i);
+		test_assert(found, "Found key to erase");
+	}
+
+	test_assert(!map.erase(0), "Erased key is gone");
+	test_assert(map.count == 66, "Count is correct");
+
+	int prev = -1;
+	for (auto &pair : map) {
+		test_assert(pair.key > prev, "Order is preserved");
+		test_assert(pair.key % 3 != 0, "Erased keys not visited");
+		test_assert(pair.val == pair.key * 10, "Value is correct");
+		prev = pair.key;
+	}
+
+	for (int i = 0; i < 100; i++) {
+		auto it = map.find(i);
+		if (i % 3 == 0) {
+			test_assert(it == map.end(), "Did not find erased keys");
+		} else {
+			test_assert(it != map.end() && it->val == i * 10, "Found the rest of the keys");
+		}
+	}
+
+	auto it = map.erase(map.begin());
+	test_assert(it == map.begin() && it->key == 2, "Erase returns the next element");
+}
+
+test_case(ordered_hash_map_copy_move)
+{
+	ordered_hash_map<int, int, int_hash> map;
+
+	for (int i = 0; i < 100; i++) {
+		map.insert(100 - i, i);
+	}
+
+	ordered_hash_map<int, int, int_hash> copy = map;
+	ordered_hash_map<int, int, int_hash> moved = std::move(map);
+
+	test_assert(map.count == 0, "Moved from is empty");
+
+	int i = 0;
+	for (auto &pair : copy) {
+		test_assert(pair.key == 100 - i, "Copy keeps the order");
+		test_assert(moved.find(pair.key)->val == i, "Found value in the moved map");
+		i++;
+	}
+}
+
+test_case(ordered_hash_map_non_pod)
+{
+	{
+		ordered_hash_map<counter, counter, counter::hash> map;
+
+		for (int i = 0; i < 100; i++) {
+			map.insert(counter(i), counter(i * 2));
+		}
+
+		test_assert(counts.copy == 0, "No extra copies");
+
+		for (int i = 0; i < 100; i += 2) {
+			map.erase(counter(i));
+		}
+
+		ordered_hash_map<counter, counter, counter::hash> copy = map;
+		test_assert(counts.copy == 100, "Copied the remaining entries");
+
+		for (int i = 0; i < 100; i++) {
+			auto it = copy.find(counter(i));
+			if (i % 2 == 0) {
+				test_assert(it == copy.end(), "Did not find erased keys");
+			} else {
+				test_assert(it != copy.end() && it->val.value == i * 2, "Found the rest of the keys");
+			}
+		}
+
+		map.clear();
+		test_assert(map.find(counter(1)) == map.end(), "Can't find after clear");
+		map.insert(counter(1), counter(2));
+	}
+
+	test_assert(counts.ctor == counts.dtor, "Objects destroyed");
+}
@@ -0,0 +1,149 @@
+#include <test/test.h>
+#include <compiler/ast.h>
+#include <vector>
+
+namespace {
+
+// int add(int a, int b) { if (a) return a + b * 2; else return f(b); }
+struct test_tree
+{
+	ast tree;
+	ast_ref type_int, type_a, type_b, param_a, param_b;
+	ast_ref a, b, two, mul, sum, ret_sum;
+	ast_ref callee, b2, call, ret_call, a2, branch, body, func, root;
+
+	explicit test_tree(linear_allocator *arena)
+		: tree(arena)
+	{
+		symbol s_int = intern_symbol("int");
+		symbol s_a = intern_symbol("a");
+		symbol s_b = intern_symbol("b");
+		symbol s_f = intern_symbol("f");
+
+		type_int = tree.add(ast_kind::type_name, 0, s_int.index, 0);
+		type_a = tree.add(ast_kind::type_name, 4, s_int.index, 0);
+		param_a = tree.add(ast_kind::var_decl, 5, type_a);
+		type_b = tree.add(ast_kind::type_name, 7, s_int.index, 0);
+		param_b = tree.add(ast_kind::var_decl, 8, type_b);
+
+		a = tree.add(ast_kind::identifier, 15, s_a.index, 0);
+		b = tree.add(ast_kind::identifier, 17, s_b.index, 0);
+		two = tree.add(ast_kind::integer_literal, 19, 0, 0);
+		mul = tree.add(ast_kind::binary, 18, b, two);
+		sum = tree.add(ast_kind::binary, 16, a, mul);
+		ret_sum = tree.add(ast_kind::return_stmt, 14, sum);
+
+		callee = tree.add(ast_kind::identifier, 23, s_f.index, 0);
+		b2 = tree.add(ast_kind::identifier, 25, s_b.index, 0);
+		uint32_t args = tree.add_list(&b2, 1);
+		call = tree.add(ast_kind::call, 24, callee.index, args);
+		ret_call = tree.add(ast_kind::return_stmt, 22, call);
+
+		a2 = tree.add(ast_kind::identifier, 12, s_a.index, 0);
+		uint32_t branches[] = { ret_sum.index, ret_call.index };
+		branch = tree.add(ast_kind::if_stmt, 10, a2.index, tree.add_extra(branches, 2));
+
+		uint32_t stmts = tree.add_list(&branch, 1);
+		body = tree.add(ast_kind::block, 9, stmts, 0);
+
+		ast_ref params[] = { param_a, param_b };
+		uint32_t signature[] = { type_int.index, tree.add_list(params, 2) };
+		func = tree.add(ast_kind::func_decl, 1, tree.add_extra(signature, 2), body.index);
+
+		uint32_t decls = tree.add_list(&func, 1);
+		root = tree.add(ast_kind::file, 0, decls, 0);
+	}
+};
+
+std::vector<ast_ref> children(const ast &tree, ast_ref ref)
+{
+	std::vector<ast_ref> result;
+	tree.for_each_child(ref, [&](ast_ref child) {
+		result.push_back(child);
+	});
+	return result;
+}
+
+}
+
+test_case(ast_build_and_access)
+{
+	linear_allocator arena;
+	test_tree t(&arena);
+	const ast &tree = t.tree;
+
+	test_assert(tree.kind(ast_ref{ 0 }) == ast_kind::none, "Index 0 is the null node");
+	test_assert(!ast_ref{ 0 } && t.root, "Null reference is false");
+	test_assert(tree.kind(t.root) == ast_kind::file, "Root kind");
+	test_assert(tree.kind(t.sum) == ast_kind::binary, "Binary kind");
+	test_assert(tree.lhs(t.sum) == t.a && tree.rhs(t.sum) == t.mul, "Binary operands");
+	test_assert(tree.lhs_symbol(t.a) == intern_symbol("a"), "Identifier symbol");
+	test_assert(tree.tokens[t.mul.index] == 18, "Main token");
+
+	uint32_t args = tree.data[t.call.index].rhs;
+	test_assert(tree.list_count(args) == 1 && tree.list_item(args, 0) == t.b2, "Call arguments");
+
+	uint32_t signature = tree.data[t.func.index].lhs;
+	test_assert(tree.extra_node(signature) == t.type_int, "Return type");
+	test_assert(tree.list_count(tree.extra[signature + 1]) == 2, "Parameters");
+}
+
+test_case(ast_children)
+{
+	linear_allocator arena;
+	test_tree t(&arena);
+	const ast &tree = t.tree;
+
+	std::vector<ast_ref> c = children(tree, t.func);
+	test_assert(c.size() == 4 && c[0] == t.type_int && c[1] == t.param_a && c[2] == t.param_b && c[3] == t.body, "Function children");
+
+	c = children(tree, t.branch);
+	test_assert(c.size() == 3 && c[0] == t.a2 && c[1] == t.ret_sum && c[2] == t.ret_call, "If children");
+
+	c = children(tree, t.call);
+	test_assert(c.size() == 2 && c[0] == t.callee && c[1] == t.b2, "Call children");
+
+	c = children(tree, t.param_a);
+	test_assert(c.size() == 1 && c[0] == t.type_a, "Null initializer is skipped");
+
+	c = children(tree, t.a);
+	test_assert(c.empty(), "Identifiers have no children");
+}
+
+test_case(ast_post_order)
+{
+	linear_allocator arena;
+	test_tree t(&arena);
+	const ast &tree = t.tree;
+
+	// Every child precedes its parent so a linear pass is a post-order walk
+	uint32_t visited = 0;
+	for (uint32_t i = 1; i < tree.count; i++) {
+		tree.for_each_child(ast_ref{ i }, [&](ast_ref child) {
+			p_assert(child.index < i);
+			visited++;
+		});
+	}
+	test_assert(visited == tree.count - 2, "Every node except the root is a child once");
+}
+
+test_case(ast_grows)
+{
+	linear_allocator arena;
+	ast tree(&arena);
+
+	ast_ref prev = tree.add(ast_kind::integer_literal, 0, 0, 0);
+	for (uint32_t i = 1; i < 10000; i++) {
+		ast_ref lit = tree.add(ast_kind::integer_literal, i, 0, 0);
+		prev = tree.add(ast_kind::binary, i, prev, lit);
+	}
+
+	test_assert(tree.count == 1 + 1 + 2 * 9999, "All nodes added");
+	uint32_t depth = 0;
+	for (ast_ref ref = prev; tree.kind(ref) == ast_kind::binary; ref = tree.lhs(ref))
+		depth++;
+	test_assert(depth == 9999, "Tree survives growing");
+
+	arena.reset();
+	test_assert(arena.memory == nullptr, "Tree memory released");
+}
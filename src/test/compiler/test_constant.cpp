@@ -0,0 +1,63 @@
+#include <test/test.h>
+#include <compiler/constant.h>
+
+test_case(constant_hash_consing)
+{
+	constant_table constants;
+	type_id t_int = basic_type(type_kind::int_type);
+	type_id t_char = basic_type(type_kind::char_type);
+	type_id t_bool = basic_type(type_kind::bool_type);
+
+	constant_id a = constants.intern(make_integer_constant(t_int, 42));
+	test_assert(a.index != 0, "Id 0 is reserved");
+	test_assert(constants.intern(constant_value()) == constant_id{ 0 }, "Null value interns to id 0");
+	test_assert(constants.intern(make_integer_constant(t_int, 42)) == a, "Same integer");
+	test_assert(constants.intern(make_integer_constant(t_int, 43)) != a, "Different value");
+	test_assert(constants.intern(make_integer_constant(t_char, 42)) != a, "Different type");
+	test_assert(constants.get(a).bits == 42 && constants.get(a).type == t_int, "Value is stored");
+
+	constant_id t = constants.intern(make_bool_constant(t_bool, true));
+	test_assert(t == constants.intern(make_bool_constant(t_bool, true)), "Same boolean");
+	test_assert(t != constants.intern(make_bool_constant(t_bool, false)), "Different boolean");
+	test_assert(t != constants.intern(make_integer_constant(t_bool, 1)), "Different kind");
+
+	test_assert(constants.intern(make_null_constant(t_int)) == constants.intern(make_null_constant(t_int)), "Same null");
+	test_assert(constants.intern(make_null_constant(t_int)) != constants.intern(make_integer_constant(t_int, 0)), "Null is not zero");
+}
+
+test_case(constant_floats)
+{
+	constant_table constants;
+	type_id t_double = basic_type(type_kind::double_type);
+
+	constant_id half = constants.intern(make_float_constant(t_double, 0.5));
+	test_assert(constants.intern(make_float_constant(t_double, 0.5)) == half, "Same float");
+	test_assert(constants.get(half).as_double() == 0.5, "Float value");
+
+	constant_id zero = constants.intern(make_float_constant(t_double, 0.0));
+	constant_id neg_zero = constants.intern(make_float_constant(t_double, -0.0));
+	test_assert(zero != neg_zero, "Compared by bit pattern");
+}
+
+test_case(constant_strings)
+{
+	constant_table constants;
+	constant_cache cache(&constants);
+	type_id t_char = basic_type(type_kind::char_type);
+
+	char buf[16];
+	strcpy(buf, "hello world");
+	constant_id hello = cache.intern(make_string_constant(t_char, buf, 5));
+
+	strcpy(buf, "jello");
+	test_assert(cache.intern(make_string_constant(t_char, "hello", 5)) == hello, "Same string");
+	test_assert(cache.intern(make_string_constant(t_char, buf, 5)) != hello, "Different string");
+	test_assert(cache.hits == 1 && cache.misses == 2, "Cache statistics");
+
+	const constant_value &value = constants.get(hello);
+	test_assert(value.length == 5 && !strcmp(value.data, "hello"), "String is copied and null-terminated");
+
+	constant_id empty = cache.intern(make_string_constant(t_char, "", 0));
+	test_assert(empty == constants.intern(make_string_constant(t_char, nullptr, 0)), "Empty string");
+	test_assert(constants.get(empty).data[0] == '\0', "Empty string is null-terminated");
+}
@@ -0,0 +1,187 @@
+#include <test/test.h>
+#include <compiler/lexer.h>
+#include <vector>
+
+namespace {
+
+std::vector<token> lex_all(source_manager &sources, const char *text)
+{
+	source_file *file = sources.add_memory("test", text, (uint32_t)strlen(text));
+	lexer lex(file);
+	std::vector<token> tokens;
+	for (;;) {
+		token t = lex.next();
+		tokens.push_back(t);
+		if (t.kind == token_kind::end)
+			break;
+	}
+	return tokens;
+}
+
+bool kinds_equal(const std::vector<token> &tokens, std::initializer_list<token_kind> kinds)
+{
+	if (tokens.size() != kinds.size() + 1 || tokens.back().kind != token_kind::end)
+		return false;
+	size_t i = 0;
+	for (token_kind kind : kinds) {
+		if (tokens[i++].kind != kind)
+			return false;
+	}
+	return true;
+}
+
+}
+
+test_case(lexer_identifiers_and_keywords)
+{
+	source_manager sources;
+	const char *text = "int foo = bar_2; while returns";
+	std::vector<token> tokens = lex_all(sources, text);
+
+	test_assert(kinds_equal(tokens, {
+		token_kind::kw_int, token_kind::identifier, token_kind::assign,
+		token_kind::identifier, token_kind::semicolon, token_kind::kw_while,
+		token_kind::identifier }), "Token kinds");
+
+	test_assert(tokens[1].offset == 4 && tokens[1].length == 3, "Identifier span");
+	test_assert(tokens[1].sym == intern_symbol("foo"), "Identifier is interned");
+	test_assert(tokens[3].sym == intern_symbol("bar_2"), "Identifier with digits");
+	test_assert(tokens[6].sym == intern_symbol("returns"), "Keyword prefix is an identifier");
+	test_assert(tokens[0].sym == symbol{ 0 }, "Keywords are not interned");
+}
+
+test_case(lexer_long_identifiers)
+{
+	source_manager sources;
+	const char *text = "a_sixteen_chars_ an_identifier_longer_than_thirty_two_chars x";
+	std::vector<token> tokens = lex_all(sources, text);
+
+	test_assert(kinds_equal(tokens, { token_kind::identifier, token_kind::identifier, token_kind::identifier }), "Token kinds");
+	test_assert(tokens[0].length == 16 && tokens[0].sym == intern_symbol("a_sixteen_chars_"), "Identifier of one block");
+	test_assert(tokens[1].sym == intern_symbol("an_identifier_longer_than_thirty_two_chars"), "Identifier of many blocks");
+	test_assert(tokens[2].sym == intern_symbol("x"), "Identifier at the end");
+}
+
+test_case(lexer_fused_hash_matches)
+{
+	source_manager sources;
+	symbol_cahce cache;
+	const char *text = "alpha beta_gamma delta0123456789abcdefghij alpha";
+	source_file *file = sources.add_memory("test", text, (uint32_t)strlen(text));
+
+	// The cache asserts in debug builds that the hash equals `symbol_hash()`
+	lexer lex(file, &cache);
+	token a = lex.next();
+	token b = lex.next();
+	token c = lex.next();
+	token a2 = lex.next();
+
+	test_assert(a.sym == intern_symbol("alpha"), "Cached interning");
+	test_assert(b.sym == intern_symbol("beta_gamma"), "Cached interning");
+	test_assert(c.sym == intern_symbol("delta0123456789abcdefghij"), "Cached interning");
+	test_assert(a2.sym == a.sym && cache.hits >= 1, "Repeated identifier hits the cache");
+}
+
+test_case(lexer_numbers)
+{
+	source_manager sources;
+	const char *text = "0 42 0x1fU 3.14 .5 1e10 2.5e-3f 7u 1.x";
+	std::vector<token> tokens = lex_all(sources, text);
+
+	test_assert(kinds_equal(tokens, {
+		token_kind::integer, token_kind::integer, token_kind::integer,
+		token_kind::floating, token_kind::floating, token_kind::floating,
+		token_kind::floating, token_kind::integer, token_kind::floating }), "Token kinds");
+
+	test_assert(tokens[2].length == 5, "Hex literal with suffix");
+	test_assert(tokens[6].length == 7, "Float with exponent and suffix");
+	test_assert(tokens[8].length == 3, "Suffix characters belong to the literal");
+}
+
+test_case(lexer_strings)
+{
+	source_manager sources;
+	const char *text = "\"hello\" \"esc\\\"aped\\\\\" 'c' '\\'' \"\"";
+	std::vector<token> tokens = lex_all(sources, text);
+
+	test_assert(kinds_equal(tokens, {
+		token_kind::string, token_kind::string, token_kind::character,
+		token_kind::character, token_kind::string }), "Token kinds");
+
+	test_assert(tokens[0].length == 7, "Simple string");
+	test_assert(tokens[1].length == 13, "Escaped quotes and backslashes");
+	test_assert(tokens[3].length == 4, "Escaped character");
+	test_assert(tokens[4].length == 2, "Empty string");
+}
+
+test_case(lexer_unterminated)
+{
+	source_manager sources;
+
+	std::vector<token> tokens = lex_all(sources, "x \"open string");
+	test_assert(kinds_equal(tokens, { token_kind::identifier, token_kind::error }), "Unterminated string");
+	test_assert(tokens[1].offset == 2 && tokens[1].length == 12, "Error covers the rest of the file");
+
+	tokens = lex_all(sources, "x /* open comment");
+	test_assert(kinds_equal(tokens, { token_kind::identifier, token_kind::error }), "Unterminated comment");
+
+	tokens = lex_all(sources, "\"ends in escape\\");
+	test_assert(kinds_equal(tokens, { token_kind::error }), "Escape at the end");
+	test_assert(tokens[0].length == 16, "Escape doesn't read past the end");
+
+	tokens = lex_all(sources, "a $ b");
+	test_assert(kinds_equal(tokens, { token_kind::identifier, token_kind::error, token_kind::identifier }), "Unknown character");
+}
+
+test_case(lexer_comments_and_space)
+{
+	source_manager sources;
+	const char *text =
+		"  \t\t\r\n                                 a // line comment\n"
+		"/* block\n * comment **/ b /**/c//\n"
+		"                                                              d // at the end";
+	std::vector<token> tokens = lex_all(sources, text);
+
+	test_assert(kinds_equal(tokens, {
+		token_kind::identifier, token_kind::identifier,
+		token_kind::identifier, token_kind::identifier }), "Comments are skipped");
+	test_assert(tokens[1].sym == intern_symbol("b"), "After block comment");
+	test_assert(tokens[2].sym == intern_symbol("c"), "After empty block comment");
+	test_assert(tokens[3].sym == intern_symbol("d"), "After long whitespace");
+	test_assert(tokens[4].offset == (uint32_t)strlen(text), "End is at the end of the file");
+}
+
+test_case(lexer_embedded_null)
+{
+	source_manager sources;
+	const char text[] = "a // comment \0 continues\n b \"str\0ing\"";
+	source_file *file = sources.add_memory("test", text, sizeof(text) - 1);
+
+	lexer lex(file);
+	token a = lex.next();
+	token b = lex.next();
+	token s = lex.next();
+	token e = lex.next();
+	test_assert(a.kind == token_kind::identifier && b.kind == token_kind::identifier, "Null in a comment");
+	test_assert(s.kind == token_kind::string && s.length == 9, "Null in a string");
+	test_assert(e.kind == token_kind::end, "End of file");
+}
+
+test_case(lexer_punctuators)
+{
+	source_manager sources;
+	const char *text = "( ) { } [ ] ; , . ... : ? ~ ! + - * / % & | ^ < > = "
+		"++ -- -> && || << >> == != <= >= += -= *= /= %= &= |= ^= <<= >>= a+++b";
+	std::vector<token> tokens = lex_all(sources, text);
+
+	uint32_t first = (uint32_t)token_kind::l_paren;
+	uint32_t num = (uint32_t)token_kind::count - first;
+	test_assert(tokens.size() == num + 4 + 1, "Token count");
+	for (uint32_t i = 0; i < num; i++) {
+		token_kind kind = (token_kind)(first + i);
+		test_assert(tokens[i].kind == kind, "Punctuator kind");
+		test_assert(tokens[i].length == strlen(token_kind_name(kind)), "Punctuator length");
+	}
+
+	test_assert(tokens[num + 1].kind == token_kind::plus_plus && tokens[num + 2].kind == token_kind::plus, "Longest match");
+}
@@ -0,0 +1,58 @@
+#include <test/test.h>
+#include <compiler/perfect_hash.h>
+
+namespace {
+
+constexpr const char *keywords[] = {
+	"if", "else", "while", "for", "do", "return", "break", "continue",
+	"struct", "union", "enum", "switch", "case", "default", "const", "static",
+	"sizeof", "typedef", "goto", "extern", "inline", "void", "int", "char",
+};
+
+constexpr auto keyword_set = make_perfect_hash_set(keywords);
+
+enum token_kind { tk_if, tk_else, tk_while };
+
+constexpr perfect_hash_entry<token_kind> keyword_kinds[] = {
+	{ "if", tk_if },
+	{ "else", tk_else },
+	{ "while", tk_while },
+};
+
+constexpr auto keyword_map = make_perfect_hash_map(keyword_kinds);
+
+static_assert(keyword_set.seed != 0, "Seed is found at compile time");
+
+}
+
+test_case(perfect_hash_set_keywords)
+{
+	uint32_t num = sizeof(keywords) / sizeof(*keywords);
+	for (uint32_t i = 0; i < num; i++) {
+		const char *kw = keywords[i];
+		uint32_t len = (uint32_t)strlen(kw);
+		test_assert(keyword_set.find(kw, len) == (int32_t)i, "Found keyword index");
+		test_assert(keyword_set.find(kw, len, symbol_hash(kw, len)) == (int32_t)i, "Found keyword index with hash");
+		test_assert(!keyword_set.contains(kw, len - 1), "Prefix is not a keyword");
+	}
+
+	const char *not_keywords[] = { "", "iff", "x", "elseif", "While", "returns", "foo" };
+	for (const char *str : not_keywords) {
+		test_assert(!keyword_set.contains(str, (uint32_t)strlen(str)), "Not a keyword");
+	}
+}
+
+test_case(perfect_hash_map_keywords)
+{
+	const token_kind *kind = keyword_map.find("while", 5);
+	test_assert(kind && *kind == tk_while, "Found keyword value");
+	kind = keyword_map.find("else", 4);
+	test_assert(kind && *kind == tk_else, "Found keyword value");
+	test_assert(keyword_map.find("elsewhere", 9) == nullptr, "Not a keyword");
+}
+
+test_case(perfect_hash_symbol_hash_const)
+{
+	static_assert(symbol_hash_const("") == symbol_hash_init(), "Empty string hash");
+	test_assert(symbol_hash_const("identifier") == symbol_hash("identifier", 10), "Compile-time hash matches");
+}
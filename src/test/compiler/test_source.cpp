@@ -0,0 +1,100 @@
+#include <test/test.h>
+#include <compiler/source.h>
+#include <stdio.h>
+
+static bool write_test_file(const char *path, const char *data, size_t size)
+{
+	FILE *f = fopen(path, "wb");
+	if (!f)
+		return false;
+	bool ok = fwrite(data, 1, size, f) == size;
+	fclose(f);
+	return ok;
+}
+
+static bool is_zero_padded(const source_file *file)
+{
+	for (uint32_t i = 0; i < source_padding; i++) {
+		if (file->data[file->size + i] != 0)
+			return false;
+	}
+	return true;
+}
+
+test_case(source_open_file)
+{
+	const char *path = "test_source_open.txt";
+	const char text[] = "int main() { return 0; }\n";
+	test_assert(write_test_file(path, text, sizeof(text) - 1), "Wrote test file");
+
+	source_manager sources;
+	source_file *file = sources.open(path);
+	remove(path);
+
+	test_assert(file != nullptr, "Opened file");
+	test_assert(file->size == sizeof(text) - 1, "File size");
+	test_assert(!memcmp(file->data, text, file->size), "File contents");
+	test_assert(is_zero_padded(file), "Padding is zero");
+	test_assert(sources.get(file->id) == file, "File found by id");
+	test_assert(file->path == intern_symbol(path), "File path is interned");
+
+	source_span span = file->span(4, 4);
+	test_assert(span.data == file->data + 4 && span.length == 4, "Span points into the file");
+	test_assert(intern_span(span) == intern_symbol("main"), "Span can be interned");
+}
+
+test_case(source_open_page_multiple)
+{
+	const char *path = "test_source_page.txt";
+	uint32_t size = 8192;
+	char *text = (char*)mem::alloc(size);
+	memset(text, 'x', size);
+	bool written = write_test_file(path, text, size);
+	mem::free(text);
+	test_assert(written, "Wrote test file");
+
+	source_manager sources;
+	source_file *file = sources.open(path);
+	remove(path);
+
+	test_assert(file != nullptr, "Opened file");
+	test_assert(file->size == size, "File size");
+	test_assert(file->data[0] == 'x' && file->data[size - 1] == 'x', "File contents");
+	test_assert(is_zero_padded(file), "Padding after a whole page is zero");
+}
+
+test_case(source_open_empty)
+{
+	const char *path = "test_source_empty.txt";
+	test_assert(write_test_file(path, "", 0), "Wrote test file");
+
+	source_manager sources;
+	source_file *file = sources.open(path);
+	remove(path);
+
+	test_assert(file != nullptr, "Opened empty file");
+	test_assert(file->size == 0, "Empty file has no size");
+	test_assert(is_zero_padded(file), "Empty file has padding");
+}
+
+test_case(source_open_missing)
+{
+	source_manager sources;
+	test_assert(sources.open("test_source_does_not_exist.txt") == nullptr, "Missing file fails");
+	test_assert(sources.files.count == 0, "No file added");
+}
+
+test_case(source_release)
+{
+	source_manager sources;
+	source_file *file = sources.add_memory("memory", "abc", 3);
+	test_assert(file != nullptr && file->size == 3, "Added memory file");
+	test_assert(!memcmp(file->data, "abc", 3) && is_zero_padded(file), "Memory file is copied and padded");
+
+	sources.acquire(file);
+	sources.release(file);
+	test_assert(file->data != nullptr, "File is kept while referenced");
+	sources.release(file);
+	test_assert(file->data == nullptr, "Last release frees the file");
+	test_assert(sources.get(file->id) == file, "Released file keeps its id");
+}
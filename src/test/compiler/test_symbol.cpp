@@ -0,0 +1,349 @@
+#include <test/test.h>
+#include <compiler/symbol.h>
+#include <base/file.h>
+#include <base/bit_math.h>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+test_case(symbol_intern_same_string)
+{
+	symbol a = intern_symbol("symbol_test_a");
+	symbol b = intern_symbol("symbol_test_b");
+	symbol a2 = intern_symbol("symbol_test_a_suffix", 13);
+
+	test_assert(a == a2, "Same string has the same symbol");
+	test_assert(a != b, "Different strings have different symbols");
+
+	symbol_string *s = get_symbol(a);
+	test_assert(s->length == 13 && !strcmp(s->data, "symbol_test_a"), "Symbol string is null-terminated");
+}
+
+test_case(symbol_empty_string)
+{
+	symbol empty = intern_symbol("");
+	test_assert(empty.index == 0, "Empty string is symbol 0");
+	test_assert(get_symbol(empty)->length == 0, "Empty symbol has no length");
+}
+
+test_case(symbol_many_pages)
+{
+	char buf[64];
+	uint32_t num = symbol_page_size * 3;
+	uint32_t first_count = get_symbol_count();
+
+	for (uint32_t i = 0; i < num; i++) {
+		uint32_t len = (uint32_t)snprintf(buf, sizeof(buf), "symbol_page_test_%u", i);
+		intern_symbol(buf, len, symbol_hash(buf, len));
+	}
+
+	test_assert(get_symbol_count() == first_count + num, "Interned new symbols");
+
+	for (uint32_t i = 0; i < num; i++) {
+		uint32_t len = (uint32_t)snprintf(buf, sizeof(buf), "symbol_page_test_%u", i);
+		symbol sym = intern_symbol(buf, len);
+		test_assert(sym.index == first_count + i, "Found the existing symbol");
+		test_assert(!strcmp(get_symbol(sym)->data, buf), "Symbol string matches");
+	}
+
+	test_assert(get_symbol_count() == first_count + num, "No duplicates were interned");
+}
+
+test_case(symbol_concurrent_intern)
+{
+	const uint32_t num_threads = 8;
+	const uint32_t num_shared = 5000;
+	const uint32_t num_own = 2000;
+
+	std::vector<std::vector<uint32_t>> results(num_threads);
+	std::vector<std::thread> threads;
+
+	for (uint32_t t = 0; t < num_threads; t++) {
+		threads.emplace_back([&, t]() {
+			char buf[64];
+			std::vector<uint32_t> &res = results[t];
+			res.resize(num_shared);
+
+			// Every thread interns the shared strings in a different order
+			for (uint32_t i = 0; i < num_shared; i++) {
+				uint32_t ix = (i * 7919 + t * 1237) % num_shared;
+				uint32_t len = (uint32_t)snprintf(buf, sizeof(buf), "symbol_shared_%u", ix);
+				res[ix] = intern_symbol(buf, len).index;
+
+				if (i < num_own) {
+					len = (uint32_t)snprintf(buf, sizeof(buf), "symbol_thread_%u_%u", t, i);
+					intern_symbol(buf, len);
+				}
+			}
+		});
+	}
+
+	for (auto &thread : threads) {
+		thread.join();
+	}
+
+	char buf[64];
+	for (uint32_t i = 0; i < num_shared; i++) {
+		uint32_t len = (uint32_t)snprintf(buf, sizeof(buf), "symbol_shared_%u", i);
+		symbol sym = intern_symbol(buf, len);
+		test_assert(!strcmp(get_symbol(sym)->data, buf), "Symbol string matches");
+		for (uint32_t t = 0; t < num_threads; t++) {
+			test_assert(results[t][i] == sym.index, "All threads got the same symbol");
+		}
+	}
+
+	for (uint32_t t = 0; t < num_threads; t++) {
+		for (uint32_t i = 0; i < num_own; i++) {
+			uint32_t len = (uint32_t)snprintf(buf, sizeof(buf), "symbol_thread_%u_%u", t, i);
+			symbol sym = intern_symbol(buf, len);
+			test_assert(!strcmp(get_symbol(sym)->data, buf), "Thread symbol string matches");
+		}
+	}
+}
+
+test_case(symbol_cache_hits)
+{
+	symbol_cahce cache(4);
+
+	symbol a = cache.intern("symbol_cache_a");
+	test_assert(cache.misses == 1 && cache.hits == 0, "First lookup misses");
+	test_assert(a == intern_symbol("symbol_cache_a"), "Same symbol as the global interner");
+
+	for (uint32_t i = 0; i < 10; i++) {
+		test_assert(cache.intern("symbol_cache_a") == a, "Cached symbol");
+	}
+	test_assert(cache.hits == 10 && cache.misses == 1, "Repeated lookups hit");
+
+	test_assert(cache.intern("").index == 0, "Empty string");
+}
+
+test_case(symbol_cache_eviction)
+{
+	symbol_cahce cache(2);
+	char buf[64];
+
+	// Many more strings than the cache has entries, results must stay correct
+	for (uint32_t round = 0; round < 3; round++) {
+		for (uint32_t i = 0; i < 100; i++) {
+			uint32_t len = (uint32_t)snprintf(buf, sizeof(buf), "symbol_cache_evict_%u", i);
+			symbol sym = cache.intern(buf, len);
+			test_assert(!strcmp(get_symbol(sym)->data, buf), "Symbol string matches");
+			test_assert(sym == intern_symbol(buf, len), "Same symbol as the global interner");
+		}
+	}
+
+	test_assert(cache.misses > 0 && cache.hit_rate() < 1.0, "Evicted entries miss");
+
+	cache.reset_stats();
+	symbol x = cache.intern("symbol_cache_x");
+	symbol y = cache.intern("symbol_cache_y");
+	test_assert(cache.intern("symbol_cache_x") == x && cache.intern("symbol_cache_y") == y, "Found cached symbols");
+	test_assert(cache.hits >= 2, "Both fit in the cache");
+}
+
+test_case(symbol_cache_deferred)
+{
+	symbol_cahce cache;
+	char strings[200][32];
+	uint32_t lengths[200];
+	symbol syms[400];
+
+	for (uint32_t i = 0; i < 200; i++) {
+		lengths[i] = (uint32_t)snprintf(strings[i], sizeof(strings[i]), "symbol_deferred_%u", i % 50);
+	}
+
+	uint32_t immediate = 0;
+	for (uint32_t i = 0; i < 400; i++) {
+		uint32_t s = (i * 7) % 200;
+		if (cache.intern_deferred(&syms[i], strings[s], lengths[s], symbol_hash(strings[s], lengths[s])))
+			immediate++;
+	}
+
+	uint32_t queued = cache.deferred_symbols.count;
+	cache.resolve_deferred();
+	test_assert(queued + immediate == 400 && queued > 0, "Misses were queued");
+	test_assert(cache.deferred_symbols.count == 0, "Queue is empty after resolving");
+
+	for (uint32_t i = 0; i < 400; i++) {
+		uint32_t s = (i * 7) % 200;
+		test_assert(syms[i] == intern_symbol(strings[s], lengths[s]), "Deferred symbol was patched");
+	}
+
+	symbol sym;
+	bool cached = cache.intern_deferred(&sym, strings[0], lengths[0], symbol_hash(strings[0], lengths[0]));
+	cache.resolve_deferred();
+	test_assert(cached, "Resolved symbols are cached");
+	test_assert(sym == syms[0], "Cached symbol is correct");
+}
+
+namespace {
+
+// Same layout as the snapshot files written by `save_symbol_snapshot()`
+struct test_snapshot_header
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t count;
+	uint32_t index_capacity;
+	uint64_t offsets_offset;
+	uint64_t index_offset;
+	uint64_t strings_offset;
+	uint64_t size;
+};
+
+std::vector<char> read_snapshot(const char *path)
+{
+	mapped_file file;
+	if (!file.open(path))
+		return std::vector<char>();
+	const char *data = (const char*)file.data;
+	return std::vector<char>(data, data + file.size);
+}
+
+// Strings of the symbols in a snapshot image, starting from the empty symbol
+std::vector<std::string> snapshot_strings(const std::vector<char> &image)
+{
+	const test_snapshot_header *h = (const test_snapshot_header*)image.data();
+	const uint32_t *offsets = (const uint32_t*)(image.data() + h->offsets_offset);
+	std::vector<std::string> strings;
+	for (uint32_t i = 0; i < h->count; i++) {
+		const symbol_string *s = (const symbol_string*)(image.data() + offsets[i]);
+		strings.push_back(std::string(s->data, s->length));
+	}
+	return strings;
+}
+
+// Build a snapshot image of `strings` where the first one is the empty symbol
+std::vector<char> build_snapshot(const std::vector<std::string> &strings)
+{
+	uint32_t const count = (uint32_t)strings.size();
+	uint32_t capacity = 16;
+	while (capacity < count * 2)
+		capacity *= 2;
+
+	auto record_size = [](size_t length) {
+		return align_up((uint64_t)(offsetof(symbol_string, data) + length + 1), (uint64_t)alignof(symbol_string));
+	};
+
+	test_snapshot_header h;
+	h.magic = 0x4d595346;
+	h.version = 1;
+	h.count = count;
+	h.index_capacity = capacity;
+	h.offsets_offset = align_up((uint64_t)sizeof(test_snapshot_header), 8);
+	h.index_offset = align_up(h.offsets_offset + (uint64_t)sizeof(uint32_t) * count, 8);
+	h.strings_offset = h.index_offset + (uint64_t)sizeof(uint64_t) * capacity;
+	h.size = h.strings_offset;
+	for (const std::string &str : strings)
+		h.size += record_size(str.size());
+
+	std::vector<char> image((size_t)h.size, 0);
+	memcpy(image.data(), &h, sizeof(h));
+	uint32_t *offsets = (uint32_t*)(image.data() + h.offsets_offset);
+	uint64_t *slots = (uint64_t*)(image.data() + h.index_offset);
+	uint32_t const shift = 32 - find_msb(capacity);
+	uint64_t pos = h.strings_offset;
+
+	for (uint32_t i = 0; i < count; i++) {
+		const std::string &str = strings[i];
+		symbol_string *dst = (symbol_string*)(image.data() + pos);
+		dst->length = (uint32_t)str.size();
+		memcpy(dst->data, str.c_str(), str.size() + 1);
+		offsets[i] = (uint32_t)pos;
+		pos += record_size(str.size());
+
+		if (i == 0)
+			continue;
+
+		uint32_t const hash = symbol_hash(str.data(), (uint32_t)str.size());
+		uint32_t slot = (hash * 2654435769U) >> shift;
+		bool duplicate = false;
+		while (slots[slot] != 0) {
+			if (strings[(uint32_t)slots[slot]] == str) {
+				duplicate = true;
+				break;
+			}
+			slot = (slot + 1) & (capacity - 1);
+		}
+		if (!duplicate)
+			slots[slot] = (uint64_t)hash << 32 | i;
+	}
+
+	return image;
+}
+
+}
+
+test_case(symbol_snapshot)
+{
+	const char *path = "test_symbol_snapshot.bin";
+	const char *garbage = "not a symbol snapshot, just some bytes to load";
+	char buf[64];
+
+	test_assert(write_file(path, garbage, strlen(garbage)), "Wrote garbage file");
+	test_assert(!load_symbol_snapshot(path), "Garbage is not a snapshot");
+
+	symbol syms[100];
+	for (uint32_t i = 0; i < 100; i++) {
+		uint32_t len = (uint32_t)snprintf(buf, sizeof(buf), "symbol_snapshot_%u", i);
+		syms[i] = intern_symbol(buf, len);
+	}
+
+	test_assert(save_symbol_snapshot(path), "Saved snapshot");
+	intern_symbol("symbol_snapshot_after_save");
+	test_assert(!load_symbol_snapshot(path), "Snapshot missing interned symbols");
+
+	test_assert(save_symbol_snapshot(path), "Saved snapshot");
+	std::vector<char> saved = read_snapshot(path);
+	std::vector<std::string> strings = snapshot_strings(saved);
+	test_assert(build_snapshot(strings) == saved, "Test snapshot layout matches the saved one");
+
+	std::vector<char> truncated(saved.begin(), saved.end() - 1);
+	test_assert(write_file(path, truncated.data(), truncated.size()), "Wrote truncated snapshot");
+	test_assert(!load_symbol_snapshot(path), "Truncated snapshot is rejected");
+
+	// Every slot used: a probe for a missing symbol would never end
+	std::vector<char> full = saved;
+	const test_snapshot_header *h = (const test_snapshot_header*)full.data();
+	uint64_t *slots = (uint64_t*)(full.data() + h->index_offset);
+	for (uint32_t i = 0; i < h->index_capacity; i++) {
+		if (slots[i] == 0)
+			slots[i] = (uint64_t)0xdead << 32 | 1;
+	}
+	test_assert(write_file(path, full.data(), full.size()), "Wrote full index snapshot");
+	test_assert(!load_symbol_snapshot(path), "Snapshot with a full index is rejected");
+
+	// Cold start: the snapshot also contains symbols that were never interned
+	uint32_t count = get_symbol_count();
+	for (uint32_t i = 0; i < 100; i++) {
+		snprintf(buf, sizeof(buf), "symbol_snapshot_cold_%u", i);
+		strings.push_back(buf);
+	}
+	std::vector<char> cold = build_snapshot(strings);
+	test_assert(write_file(path, cold.data(), cold.size()), "Wrote cold start snapshot");
+	bool loaded = load_symbol_snapshot(path);
+	remove(path);
+
+	test_assert(loaded, "Loaded snapshot of the current symbols");
+	test_assert(get_symbol_count() == count + 100, "Snapshot symbols are allocated");
+	test_assert(!load_symbol_snapshot(path), "Only one snapshot can be loaded");
+
+	for (uint32_t i = 0; i < 100; i++) {
+		uint32_t len = (uint32_t)snprintf(buf, sizeof(buf), "symbol_snapshot_%u", i);
+		symbol sym = intern_symbol(buf, len);
+		test_assert(sym == syms[i], "Snapshot symbol has the same index");
+		test_assert(!strcmp(get_symbol(sym)->data, buf), "Snapshot symbol string matches");
+	}
+
+	for (uint32_t i = 0; i < 100; i++) {
+		uint32_t len = (uint32_t)snprintf(buf, sizeof(buf), "symbol_snapshot_cold_%u", i);
+		symbol sym = intern_symbol(buf, len);
+		test_assert(sym.index == count + i, "Cold symbol is found in the snapshot");
+		test_assert(!strcmp(get_symbol(sym)->data, buf), "Cold symbol string matches");
+	}
+
+	symbol fresh = intern_symbol("symbol_snapshot_fresh");
+	test_assert(fresh.index == count + 100, "New symbols are added after the snapshot");
+	test_assert(intern_symbol("symbol_snapshot_fresh") == fresh, "New symbol is found");
+}
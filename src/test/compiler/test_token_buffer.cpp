@@ -0,0 +1,70 @@
+#include <test/test.h>
+#include <compiler/token_buffer.h>
+#include <string>
+
+test_case(token_buffer_matches_lexer)
+{
+	source_manager sources;
+	const char *text = "int main(void) { return foo(\"str\", 0x10) + 1.5 /* c */ ; } $";
+	source_file *file = sources.add_memory("test", text, (uint32_t)strlen(text));
+
+	linear_allocator arena;
+	token_buffer tokens(&arena);
+	lexer buffered(file);
+	tokens.lex_all(buffered);
+
+	lexer lex(file);
+	uint32_t i = 0;
+	for (;;) {
+		token t = lex.next();
+		test_assert(i < tokens.count, "Token is in the buffer");
+
+		token b = tokens.get(i);
+		test_assert(b.kind == t.kind && b.offset == t.offset, "Same kind and offset");
+		test_assert(b.length == t.length && b.sym == t.sym, "Same length and symbol");
+		i++;
+
+		if (t.kind == token_kind::end)
+			break;
+	}
+
+	test_assert(i == tokens.count, "Same number of tokens");
+	test_assert(tokens.literal_count == 4, "String, integer, float and error are literals");
+	test_assert(tokens.kind(tokens.count - 1) == token_kind::end, "Ends in an end token");
+	test_assert(tokens.sym(1) == intern_symbol("main"), "Identifier symbol");
+
+	const token_literal &str = tokens.literal(9);
+	test_assert(str.offset == 28 && str.length == 5, "String literal span");
+}
+
+test_case(token_buffer_grows)
+{
+	std::string text;
+	for (uint32_t i = 0; i < 5000; i++) {
+		text += "a+\"s\";";
+	}
+
+	source_manager sources;
+	source_file *file = sources.add_memory("test", text.data(), (uint32_t)text.size());
+
+	linear_allocator arena;
+	token_buffer tokens(&arena);
+
+	// Start small to force growing
+	tokens.reserve(4, 1);
+	lexer lex(file);
+	tokens.lex_all(lex);
+
+	test_assert(tokens.count == 5000 * 4 + 1, "All tokens");
+	test_assert(tokens.literal_count == 5000, "All literals");
+	for (uint32_t i = 0; i < 5000; i++) {
+		test_assert(tokens.kind(i * 4 + 0) == token_kind::identifier, "Identifier");
+		test_assert(tokens.kind(i * 4 + 1) == token_kind::plus, "Plus");
+		test_assert(tokens.kind(i * 4 + 2) == token_kind::string, "String");
+		test_assert(tokens.literal(i * 4 + 2).offset == i * 6 + 2, "Literal offset");
+		test_assert(tokens.offsets[i * 4 + 3] == i * 6 + 5, "Semicolon offset");
+	}
+
+	arena.reset();
+	test_assert(arena.memory == nullptr, "Token memory released");
+}
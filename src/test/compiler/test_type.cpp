@@ -0,0 +1,137 @@
+#include <test/test.h>
+#include <compiler/type.h>
+#include <thread>
+#include <vector>
+
+test_case(type_basic_ids)
+{
+	type_table types;
+	test_assert(types.size() == (uint32_t)type_kind::double_type + 1, "Null id and basic types");
+	test_assert(types.intern(make_basic_type(type_kind::int_type)) == basic_type(type_kind::int_type), "Basic type has a fixed id");
+	test_assert(types.get(basic_type(type_kind::bool_type)).kind == type_kind::bool_type, "Basic type descriptor");
+	test_assert(types.get(type_id{ 0 }).kind == type_kind::none, "Id 0 is no type");
+	test_assert(types.intern(type_desc()) == type_id{ 0 }, "Null descriptor interns to id 0");
+
+	type_cache cache(&types);
+	test_assert(cache.intern(type_desc()) == type_id{ 0 }, "Null descriptor through the cache");
+	test_assert(types.size() == (uint32_t)type_kind::double_type + 1, "No duplicate of the null id");
+}
+
+test_case(type_hash_consing)
+{
+	type_table types;
+	type_id t_int = basic_type(type_kind::int_type);
+	type_id t_char = basic_type(type_kind::char_type);
+
+	type_id p1 = types.intern(make_pointer_type(t_int));
+	type_id p2 = types.intern(make_pointer_type(t_int));
+	type_id pc = types.intern(make_pointer_type(t_char));
+	test_assert(p1 == p2, "Same pointer type");
+	test_assert(p1 != pc, "Different pointee");
+	test_assert(types.get(p1).base == t_int, "Pointee is stored");
+
+	type_id pp = types.intern(make_pointer_type(p1));
+	test_assert(pp != p1 && types.intern(make_pointer_type(types.intern(make_pointer_type(t_int)))) == pp, "Nested pointer");
+
+	type_id a10 = types.intern(make_array_type(t_int, 10));
+	test_assert(a10 == types.intern(make_array_type(t_int, 10)), "Same array type");
+	test_assert(a10 != types.intern(make_array_type(t_int, 11)), "Different length");
+
+	test_assert(types.intern(make_struct_type(intern_symbol("vec3")))
+		== types.intern(make_struct_type(intern_symbol("vec3"))), "Same struct name");
+	test_assert(types.intern(make_struct_type(intern_symbol("vec3")))
+		!= types.intern(make_struct_type(intern_symbol("vec4"))), "Structs are nominal");
+}
+
+test_case(type_function_params)
+{
+	type_table types;
+	type_id t_int = basic_type(type_kind::int_type);
+	type_id t_float = basic_type(type_kind::float_type);
+
+	type_id params[] = { t_int, t_float };
+	type_id f = types.intern(make_function_type(t_int, params, 2));
+
+	// The table keeps its own copy of the parameters
+	type_id other[] = { t_int, t_float };
+	params[1] = t_int;
+	test_assert(types.intern(make_function_type(t_int, other, 2)) == f, "Same signature");
+	test_assert(types.intern(make_function_type(t_int, params, 2)) != f, "Different parameter");
+	test_assert(types.intern(make_function_type(t_int, other, 1)) != f, "Different parameter count");
+	test_assert(types.intern(make_function_type(t_float, other, 2)) != f, "Different result");
+
+	const type_desc &desc = types.get(f);
+	test_assert(desc.count == 2 && desc.params[0] == t_int && desc.params[1] == t_float, "Parameters are copied");
+	test_assert(types.intern(make_function_type(t_int, nullptr, 0)) == types.intern(make_function_type(t_int, nullptr, 0)), "No parameters");
+}
+
+test_case(type_cache)
+{
+	type_table types;
+	type_cache cache(&types, 2);
+	type_id t_int = basic_type(type_kind::int_type);
+
+	type_id p = cache.intern(make_pointer_type(t_int));
+	test_assert(cache.misses == 1 && cache.hits == 0, "First lookup misses");
+	test_assert(cache.intern(make_pointer_type(t_int)) == p, "Cached id");
+	test_assert(cache.hits == 1, "Second lookup hits");
+	test_assert(types.intern(make_pointer_type(t_int)) == p, "Same id as the table");
+
+	// Fill the small cache past its capacity
+	for (uint32_t i = 0; i < 64; i++) {
+		type_id a = cache.intern(make_array_type(t_int, i));
+		test_assert(a == types.intern(make_array_type(t_int, i)), "Cache agrees with the table");
+	}
+	test_assert(cache.intern(make_pointer_type(t_int)) == p, "Evicted id is found again");
+}
+
+test_case(type_many_pages)
+{
+	type_table types;
+	type_id t_int = basic_type(type_kind::int_type);
+	uint32_t num = intern_page_size * 3;
+
+	std::vector<type_id> ids;
+	for (uint32_t i = 0; i < num; i++)
+		ids.push_back(types.intern(make_array_type(t_int, i)));
+
+	for (uint32_t i = 0; i < num; i++) {
+		test_assert(types.get(ids[i]).count == i, "Descriptor on a later page");
+		test_assert(types.intern(make_array_type(t_int, i)) == ids[i], "Stable id");
+	}
+}
+
+test_case(type_concurrent)
+{
+	type_table types(mem::get_standard_allocator());
+	type_id t_int = basic_type(type_kind::int_type);
+	const uint32_t num_threads = 4;
+	const uint32_t num_types = 2000;
+	std::vector<type_id> results[num_threads];
+	std::vector<std::thread> threads;
+
+	for (uint32_t t = 0; t < num_threads; t++) {
+		threads.emplace_back([&, t]() {
+			type_cache cache(&types);
+			for (uint32_t i = 0; i < num_types; i++) {
+				uint32_t n = (i * 7 + t * 131) % num_types;
+				results[t].push_back(cache.intern(make_array_type(t_int, n)));
+			}
+		});
+	}
+	for (auto &thread : threads)
+		thread.join();
+
+	test_assert(types.size() == (uint32_t)type_kind::double_type + 1 + num_types, "Every type created once");
+	std::vector<type_id> by_length(num_types);
+	for (uint32_t i = 0; i < num_types; i++)
+		by_length[(i * 7) % num_types] = results[0][i];
+
+	for (uint32_t t = 0; t < num_threads; t++) {
+		for (uint32_t i = 0; i < num_types; i++) {
+			uint32_t n = (i * 7 + t * 131) % num_types;
+			test_assert(types.get(results[t][i]).count == n, "Thread got the right type");
+			test_assert(results[t][i] == by_length[n], "All threads got the same id");
+		}
+	}
+}
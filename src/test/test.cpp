@@ -6,31 +6,14 @@
 #include <base/hash_map.h>
 
 #include <string.h>
+#include <mutex>
 
-uhash int_hash(uint32_t i)
-{
-	uint64_t j = i * 2654435761U;
-	return (uhash)(~j ^ (j >> 32));
-}
-
-uhash int_hash(uint64_t i)
-{
-	uint64_t j = i * 11400714819323198549ULL;
-	return (uhash)(~j ^ (j >> 32));
-}
-
-struct pointer_hash
-{
-	uhash operator()(void *ptr)
-	{
-		return int_hash((uintptr_t)ptr);
-	}
-};
-
+// Tracks the live allocations, locked as tests may allocate from multiple threads
 struct test_allocator : mem::allocator
 {
-	hash_map<void*, size_t, pointer_hash> allocs;
+	hash_map<void*, size_t> allocs;
 	mem::allocator *inner;
+	std::mutex mutex;
 
 	test_allocator()
 	{
@@ -40,14 +23,18 @@ struct test_allocator : mem::allocator
 	virtual void *allocator_allocate(uint32_t thread, size_t size, size_t alignment) override
 	{
 		void *mem = inner->allocator_allocate(thread, size, alignment);
+		std::lock_guard<std::mutex> lock(mutex);
 		allocs.insert(mem, size);
 		return mem;
 	}
 
 	virtual void allocator_free(uint32_t thread, void *pointer, size_t size, size_t alignment) override
 	{
-		bool found = allocs.erase(pointer);
-		p_assert(found);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			bool found = allocs.erase(pointer);
+			p_assert(found);
+		}
 		inner->allocator_free(thread, pointer, size, alignment);
 	}
 };
@@ -58,6 +45,7 @@ uint32_t g_num_tests = 0;
 const char *test_tag = "";
 
 operator_counts counts;
+uhash hostile_seed;
 
 test_case_struct::test_case_struct(const char *name, const char *tag, void (*func)())
 	: name(name)
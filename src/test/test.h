@@ -1,6 +1,7 @@
 #pragma once
 
 #include <base/base.h>
+#include <base/hash.h>
 
 struct test_case_struct
 {
@@ -36,6 +37,8 @@ struct operator_counts {
 	uint32_t copy = 0;
 	uint32_t move = 0;
 	uint32_t defa = 0;
+	uint32_t copy_assign = 0;
+	uint32_t move_assign = 0;
 
 	void reset()
 	{
@@ -44,3 +47,61 @@ struct operator_counts {
 };
 
 extern operator_counts counts;
+
+// Non-trivial value type that records its constructions and destructions to `counts`
+struct counter {
+	int value;
+
+	struct hash {
+		uhash operator()(const counter &c) {
+			return c.value * 13213;
+		}
+	};
+
+	bool operator==(const counter &c) const
+	{
+		return value == c.value;
+	}
+
+	bool operator<(const counter &c) const
+	{
+		return value < c.value;
+	}
+
+	explicit counter(int v)
+		: value(v)
+	{
+		counts.ctor++;
+	}
+
+	counter(const counter &c)
+		: value(c.value)
+	{
+		counts.ctor++;
+		counts.copy++;
+	}
+
+	counter(counter &&c)
+		: value(c.value)
+	{
+		counts.ctor++;
+		counts.move++;
+	}
+
+	~counter()
+	{
+		counts.dtor++;
+	}
+};
+
+// Seeded hash that degenerates for one known seed, like an adversary who
+// has found the seed of a table
+extern uhash hostile_seed;
+
+struct hostile_hash {
+	static const bool seeded = true;
+
+	uhash operator()(int i, uhash seed) {
+		return seed == hostile_seed ? 0 : hash_int32((uint32_t)i ^ seed);
+	}
+};